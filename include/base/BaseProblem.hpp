@@ -19,42 +19,94 @@ namespace optim
 
     /// @class BaseProblem
     /// @brief Base problem interface
-    template <typename fp_t>
+    /// @tparam fp_t floating-point type
+    /// @tparam N number of rows of x if fixed at compile time
+    /// @tparam K number of columns of x if fixed at compile time
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
     struct BaseProblem
     {
+        static constexpr int rows_at_compile_time = N;
+        static constexpr int cols_at_compile_time = K;
+
         /// @brief loss function that needs to be minimized.
         /// @param in_x the point to evaluate
         virtual fp_t loss(
-            const Mat<fp_t> &in_x) = 0;
+            const Mat<fp_t, N, K> &in_x) = 0;
     };
 
     /// @brief Gradient problem interface
-    template <typename fp_t>
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
     struct GradProblem
-        : public BaseProblem<fp_t>
+        : public BaseProblem<fp_t, N, K>
     {
         /// @brief gradient function that computes the gradient of the loss function
         /// @param in_x the point to evaluate
         /// @param out_x the output gradient
         virtual void grad(
-            const Mat<fp_t> &in_x,
-            Mat<fp_t> &out_x) = 0;
+            const Mat<fp_t, N, K> &in_x,
+            Mat<fp_t, N, K> &out_x) = 0;
+
+        /// @brief compute the loss and the gradient at the same point
+        /// @details the default calls `grad` and `loss` separately. Override it when both share most of their work, solvers and line searches call it whenever they need both values at one point.
+        /// @param in_x the point to evaluate
+        /// @param out_x the output gradient
+        /// @return the loss at in_x
+        virtual fp_t loss_and_grad(
+            const Mat<fp_t, N, K> &in_x,
+            Mat<fp_t, N, K> &out_x)
+        {
+            grad(in_x, out_x);
+            return this->loss(in_x);
+        }
     };
 
-    template <typename fp_t>
+    /// @brief Hessian problem interface
+    /// @details Hessian products are taken at the point of the last `update_hess` call. Implement `hess_forward` for NewtonCG and `hess_backward` for NewtonMethod.
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
     struct HessProblem
-        : public GradProblem<fp_t>
+        : public GradProblem<fp_t, N, K>
     {
+        /// @brief move the Hessian to point x
+        /// @details called by the solvers before any Hessian product at a new point. The default does nothing, for problems that track the point in `grad`.
+        /// @param x the point to evaluate
+        virtual void update_hess([[maybe_unused]] const Mat<fp_t, N, K> &x){};
+
+        /// @brief Hessian-vector product d = H x
         virtual void hess_forward(
-            const Mat<fp_t> &x,
-            Mat<fp_t> &d)
+            [[maybe_unused]] const Mat<fp_t, N, K> &x,
+            [[maybe_unused]] Mat<fp_t, N, K> &d)
         {
             throw std::runtime_error("Hessian not implemented");
         };
 
+        /// @brief Newton step d = H^{-1} x
         virtual void hess_backward(
+            [[maybe_unused]] const Mat<fp_t, N, K> &x,
+            [[maybe_unused]] Mat<fp_t, N, K> &d)
+        {
+            throw std::runtime_error("Hessian inverse not implemented");
+        };
+
+        /// @brief diagonal of the Hessian, used by DiagPreconditioner
+        virtual void hess_diag([[maybe_unused]] Mat<fp_t, N, K> &d)
+        {
+            throw std::runtime_error("Hessian diagonal not implemented");
+        };
+    };
+
+    /// @brief Sparse Hessian problem interface
+    /// @details the solver factorizes the Hessian itself, so only its entries are needed.
+    template <typename fp_t>
+    struct SpHessProblem
+        : public GradProblem<fp_t>
+    {
+        /// @brief fill the Hessian at x
+        /// @details H is nk x nk for an n x k point, indexed like the column-major storage of x. Only the lower triangle is read. Keep the sparsity pattern fixed from call to call, the symbolic factorization is reused.
+        /// @param x the point to evaluate
+        /// @param H the output Hessian
+        virtual void hess(
             const Mat<fp_t> &x,
-            Mat<fp_t> &d) = 0;
+            SpMat<fp_t> &H) = 0;
     };
 
     namespace internal
@@ -62,68 +114,88 @@ namespace optim
         /// @brief Proximal operator interface
         /// @details when using proximal operator, you need to implement the proximal operator and the loss function(both smooth and non-smooth parts).
         template <typename fp_t,
-                  template <typename> class Problem>
+                  template <typename, int, int> class Problem,
+                  int N = Dynamic, int K = Dynamic>
         struct ProxOperator
-            : virtual public Problem<fp_t>
+            : virtual public Problem<fp_t, N, K>
         {
-            static_assert(std::is_base_of_v<BaseProblem<fp_t>, Problem<fp_t>>,
+            static_assert(std::is_base_of_v<BaseProblem<fp_t, N, K>, Problem<fp_t, N, K>>,
                           "ProxOperator requires a BaseProblem");
             /// @brief smooth part of the loss function
             /// @param x the point to evaluate
             /// @return  the smooth part of the loss
-            virtual fp_t sm_loss(const Mat<fp_t> &x) = 0;
+            virtual fp_t sm_loss(const Mat<fp_t, N, K> &x) = 0;
 
             /// @brief non-smooth part of the loss function
             /// @param x the point to evaluate
             /// @return  the non-smooth part of the loss
-            virtual fp_t nsm_loss(const Mat<fp_t> &x) = 0;
+            virtual fp_t nsm_loss(const Mat<fp_t, N, K> &x) = 0;
 
-            fp_t loss(const Mat<fp_t> &x) override
+            fp_t loss(const Mat<fp_t, N, K> &x) override
             {
                 return sm_loss(x) + nsm_loss(x);
             }
 
+            /// @brief smooth part of the loss and its gradient at the same point
+            /// @details the default calls `grad` and `sm_loss` separately.
+            /// @param x the point to evaluate
+            /// @param g the output gradient of the smooth part
+            /// @return the smooth part of the loss
+            virtual fp_t sm_loss_and_grad(const Mat<fp_t, N, K> &x, Mat<fp_t, N, K> &g)
+            {
+                this->grad(x, g);
+                return sm_loss(x);
+            }
+
+            fp_t loss_and_grad(const Mat<fp_t, N, K> &x, Mat<fp_t, N, K> &g) override
+            {
+                return sm_loss_and_grad(x, g) + nsm_loss(x);
+            }
+
             /// @brief proximal operator
             /// @param step the step size
             /// @param in_x the input point
             /// @param out_x the output point
             virtual std::enable_if_t<
                 std::is_base_of_v<
-                    GradProblem<fp_t>, Problem<fp_t>>,
+                    GradProblem<fp_t, N, K>, Problem<fp_t, N, K>>,
                 void>
             prox(fp_t step,
-                 const Mat<fp_t> &in_x,
-                 Mat<fp_t> &out_x) = 0;
+                 const Mat<fp_t, N, K> &in_x,
+                 Mat<fp_t, N, K> &out_x) = 0;
         };
 
         template <typename fp_t,
-                  template <typename> class Problem,
-                  bool use_prox = false>
+                  template <typename, int, int> class Problem,
+                  bool use_prox = false,
+                  int N = Dynamic, int K = Dynamic>
         struct ProxWrapper
         {
-            static_assert(std::is_base_of_v<BaseProblem<fp_t>, Problem<fp_t>>,
+            static_assert(std::is_base_of_v<BaseProblem<fp_t, N, K>, Problem<fp_t, N, K>>,
                           "ProxWrapper requires a BaseProblem");
-            using type = Problem<fp_t>;
+            using type = Problem<fp_t, N, K>;
         };
 
         template <typename fp_t,
-                  template <typename> class Problem>
-        struct ProxWrapper<fp_t, Problem, true>
+                  template <typename, int, int> class Problem,
+                  int N, int K>
+        struct ProxWrapper<fp_t, Problem, true, N, K>
         {
-            static_assert(std::is_base_of_v<BaseProblem<fp_t>, Problem<fp_t>>,
+            static_assert(std::is_base_of_v<BaseProblem<fp_t, N, K>, Problem<fp_t, N, K>>,
                           "ProxWrapper requires a BaseProblem");
-            using type = typename internal::ProxOperator<fp_t, Problem>;
+            using type = typename internal::ProxOperator<fp_t, Problem, N, K>;
         };
     }
 
     template <typename fp_t,
-              template <typename> class Problem,
-              bool use_prox = false>
+              template <typename, int, int> class Problem,
+              bool use_prox = false,
+              int N = Dynamic, int K = Dynamic>
     using ProxWrapper = typename internal::ProxWrapper<
-        fp_t, Problem, use_prox>::type;
+        fp_t, Problem, use_prox, N, K>::type;
 
-    template <typename fp_t>
-    using ProxGradProblem = typename internal::ProxOperator<fp_t, GradProblem>;
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
+    using ProxGradProblem = typename internal::ProxOperator<fp_t, GradProblem, N, K>;
 }
 
 #endif
\ No newline at end of file
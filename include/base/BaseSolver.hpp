@@ -5,21 +5,29 @@
 #include "BaseProblem.hpp"
 #include "misc/logger.hpp"
 #include "Recorder.hpp"
+#include "misc/instrument.hpp"
+#include "misc/trace.hpp"
 
 namespace optim
 {
     /// @brief Base class for all solvers.
-    template <typename fp_t>
+    /// @tparam fp_t floating-point type
+    /// @tparam N number of rows of x if fixed at compile time
+    /// @tparam K number of columns of x if fixed at compile time
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
     struct BaseSolver
     {
     protected:
         int iter;
+        SolverStats solver_stats;
 
     public:
         /// @brief number of iterations
         int n_iter() const { return iter; };
+        /// @brief evaluation counts and phase times of the last solve(), see SolverStats
+        const SolverStats &stats() const { return solver_stats; }
         /// @brief solve the problem with the given initial point x
-        virtual fp_t solve(Mat<fp_t> &x) = 0;
+        virtual fp_t solve(Mat<fp_t, N, K> &x) = 0;
         virtual ~BaseSolver(){};
     };
 };
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef _OPTIMLIB_BASE_BATCH_PROBLEM_HPP_
+#define _OPTIMLIB_BASE_BATCH_PROBLEM_HPP_
+
+#include "BaseProblem.hpp"
+
+namespace optim
+{
+    /// @brief Batch of independent problems with the same structure
+    /// @details the batch solvers keep the points of B problems of n variables as a B x n matrix, one row per problem. A column holds one variable of every problem contiguously (structure of arrays), so a loss written with column operations runs over the problems in SIMD lanes. Rows are compacted as problems finish: row r belongs to problem `lanes[r]` of the original batch, use it to pick the data of that problem.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    struct BatchGradProblem
+    {
+        /// @brief loss of every row
+        /// @param X points, one row per problem
+        /// @param lanes problem of each row
+        /// @param f output losses, one row per problem
+        virtual void loss(
+            const Mat<fp_t> &X,
+            const std::vector<Index> &lanes,
+            Mat<fp_t> &f) = 0;
+
+        /// @brief gradient of every row
+        /// @param X points, one row per problem
+        /// @param lanes problem of each row
+        /// @param G output gradients, same shape as X
+        virtual void grad(
+            const Mat<fp_t> &X,
+            const std::vector<Index> &lanes,
+            Mat<fp_t> &G) = 0;
+
+        /// @brief loss and gradient of every row at once
+        /// @details the default calls `grad` and `loss` separately. The solvers only call this one.
+        virtual void loss_and_grad(
+            const Mat<fp_t> &X,
+            const std::vector<Index> &lanes,
+            Mat<fp_t> &f,
+            Mat<fp_t> &G)
+        {
+            grad(X, lanes, G);
+            loss(X, lanes, f);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,205 @@
+#pragma once
+#ifndef _OPTIMLIB_BASE_CACHED_PROBLEM_HPP_
+#define _OPTIMLIB_BASE_CACHED_PROBLEM_HPP_
+
+#include "BaseProblem.hpp"
+
+/// @cond
+namespace optim::internal::cache
+{
+    /// @brief FNV-1a over the bytes of a buffer, a word at a time
+    inline uint64_t hash_bytes(const void *data, size_t n_bytes)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        uint64_t h = 14695981039346656037ull, w;
+        size_t i = 0;
+        for (; i + sizeof(w) <= n_bytes; i += sizeof(w))
+        {
+            std::memcpy(&w, p + i, sizeof(w));
+            h = (h ^ w) * 1099511628211ull;
+        }
+        for (; i < n_bytes; i++)
+            h = (h ^ p[i]) * 1099511628211ull;
+        return h;
+    }
+
+    /// @brief loss and gradient at the most recently used points
+    template <typename fp_t, typename P>
+    struct CachedBase : public P
+    {
+        struct Entry
+        {
+            Mat<fp_t> x, g;
+            uint64_t hash = 0,
+                     last_use = 0; ///< 0 if empty
+            fp_t loss;
+            bool has_loss = false,
+                 has_grad = false;
+        };
+
+        std::shared_ptr<P> inner;
+        std::vector<Entry> entries;
+        uint64_t clock = 0;
+        long hits = 0, misses = 0;
+
+        CachedBase(std::shared_ptr<P> inner, int capacity)
+            : inner(inner), entries(std::max(capacity, 1)) {}
+
+        /// @brief entry of x if cached, else the least recently used one emptied for x
+        Entry &lookup(const Mat<fp_t> &x)
+        {
+            const uint64_t h = hash_bytes(BMO_GET_DATA(x), BMO_SIZE(x) * sizeof(fp_t));
+            Entry *lru = &entries[0];
+            for (Entry &e : entries)
+            {
+                if (e.last_use && e.hash == h &&
+                    BMO_ROWS(e.x) == BMO_ROWS(x) && BMO_COLS(e.x) == BMO_COLS(x) &&
+                    std::memcmp(BMO_GET_DATA(e.x), BMO_GET_DATA(x), BMO_SIZE(x) * sizeof(fp_t)) == 0)
+                {
+                    e.last_use = ++clock;
+                    return e;
+                }
+                if (e.last_use < lru->last_use)
+                    lru = &e;
+            }
+            lru->x = x;
+            lru->hash = h;
+            lru->has_loss = lru->has_grad = false;
+            lru->last_use = ++clock;
+            return *lru;
+        }
+
+        /// @brief fill both values of e with one evaluation
+        fp_t eval_both(Entry &e, const Mat<fp_t> &x, Mat<fp_t> &g)
+        {
+            e.loss = inner->loss_and_grad(x, g);
+            e.g = g;
+            e.has_loss = e.has_grad = true;
+            return e.loss;
+        }
+    };
+
+    template <typename fp_t, typename P,
+              bool hess = std::is_base_of_v<HessProblem<fp_t>, P>>
+    struct Cached : public CachedBase<fp_t, P>
+    {
+        using CachedBase<fp_t, P>::CachedBase;
+    };
+
+    template <typename fp_t, typename P>
+    struct Cached<fp_t, P, true> : public CachedBase<fp_t, P>
+    {
+        using CachedBase<fp_t, P>::CachedBase;
+
+        void update_hess(const Mat<fp_t> &x) override { this->inner->update_hess(x); }
+
+        void hess_forward(const Mat<fp_t> &x, Mat<fp_t> &d) override
+        {
+            this->inner->hess_forward(x, d);
+        }
+
+        void hess_backward(const Mat<fp_t> &x, Mat<fp_t> &d) override
+        {
+            this->inner->hess_backward(x, d);
+        }
+
+        void hess_diag(Mat<fp_t> &d) override { this->inner->hess_diag(d); }
+    };
+}
+/// @endcond
+
+namespace optim
+{
+    /// @brief Memoizing wrapper of a problem
+    /// @details keeps the loss and gradient at the last `capacity` points evaluated and answers repeated requests at those points without calling the wrapped problem, e.g. a gradient asked for right after the line search evaluated the loss there. Points are looked up by a hash of their buffer, then compared bit for bit. With `joint`, any miss evaluates the loss and the gradient together by `loss_and_grad`, which pays off when both share most of their work and the solver asks for them separately. Hessian functions are forwarded uncached. Call `clear()` whenever the wrapped problem changes, e.g. from `update_lagrangian()` when wrapping the subproblem of ALM, which changes the multipliers between subproblems. The cache is not thread-safe, give every thread its own wrapper.
+    /// @tparam fp_t floating-point type
+    /// @tparam Problem problem interface to wrap, GradProblem or HessProblem
+    template <typename fp_t,
+              template <typename, int, int> class Problem = GradProblem>
+    class CachedProblem final
+        : public internal::cache::Cached<fp_t, Problem<fp_t, Dynamic, Dynamic>>
+    {
+        using P = Problem<fp_t, Dynamic, Dynamic>;
+        using Base = internal::cache::Cached<fp_t, P>;
+
+        static_assert(std::is_base_of_v<GradProblem<fp_t>, P>,
+                      "CachedProblem requires a GradProblem");
+
+    public:
+        bool joint = false; ///< evaluate the loss and the gradient together on every miss
+
+        /// @param inner problem to wrap
+        /// @param capacity number of points kept
+        explicit CachedProblem(std::shared_ptr<P> inner, int capacity = 4)
+            : Base(inner, capacity) {}
+
+        /// @brief requests answered from the cache
+        long n_hits() const { return this->hits; }
+
+        /// @brief requests passed to the wrapped problem
+        long n_misses() const { return this->misses; }
+
+        /// @brief drop the cached points, e.g. after the problem data changed
+        void clear()
+        {
+            for (auto &e : this->entries)
+                e.last_use = 0;
+        }
+
+        fp_t loss(const Mat<fp_t> &x) override
+        {
+            auto &e = this->lookup(x);
+            if (e.has_loss)
+            {
+                this->hits++;
+                return e.loss;
+            }
+            this->misses++;
+            if (joint)
+            {
+                BMO_RESIZE(e.g, BMO_ROWS(x), BMO_COLS(x));
+                e.loss = this->inner->loss_and_grad(x, e.g);
+                e.has_grad = true;
+            }
+            else
+                e.loss = this->inner->loss(x);
+            e.has_loss = true;
+            return e.loss;
+        }
+
+        void grad(const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            auto &e = this->lookup(x);
+            if (e.has_grad)
+            {
+                this->hits++;
+                g = e.g;
+                return;
+            }
+            this->misses++;
+            if (joint && !e.has_loss)
+                this->eval_both(e, x, g);
+            else
+            {
+                this->inner->grad(x, g);
+                e.g = g;
+                e.has_grad = true;
+            }
+        }
+
+        fp_t loss_and_grad(const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            auto &e = this->lookup(x);
+            if (e.has_loss && e.has_grad)
+            {
+                this->hits++;
+                g = e.g;
+                return e.loss;
+            }
+            this->misses++;
+            return this->eval_both(e, x, g);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,199 @@
+#pragma once
+#ifndef _OPTIMLIB_BASE_FINITE_SUM_PROBLEM_HPP_
+#define _OPTIMLIB_BASE_FINITE_SUM_PROBLEM_HPP_
+
+#include "BaseProblem.hpp"
+#include "misc/thread_pool.hpp"
+#include <mutex>
+
+namespace optim
+{
+    /// @brief Finite-sum problem interface, f(x) = sum_i f_i(x)
+    /// @details Implement the loss and gradient of one shard, `loss`, `grad` and `loss_and_grad` then evaluate the shards on a thread pool. Shards are grouped into `n_blocks` contiguous blocks, each block is summed in shard order into its own buffer and the buffers are added in block order, so the result is bitwise reproducible for a fixed `n_blocks` whatever the number of threads. Any solver taking `Problem<fp_t>` accepts it. `loss`, `grad`, `loss_and_grad` and `batch_grad` may be called concurrently, e.g. by the starts of a MultiStart: every call checks out a set of block buffers of its own, and a set is allocated only when all are in use.
+    /// @tparam fp_t floating-point type
+    /// @tparam Problem problem interface to implement, e.g. HessProblem to use it with Newton's method
+    template <typename fp_t,
+              template <typename, int, int> class Problem = GradProblem>
+    struct FiniteSumProblem
+        : public Problem<fp_t, Dynamic, Dynamic>
+    {
+        static_assert(std::is_base_of_v<GradProblem<fp_t>, Problem<fp_t, Dynamic, Dynamic>>,
+                      "FiniteSumProblem requires a GradProblem");
+
+        /// @brief pool the shards run on, created on first use with one thread per core if not set
+        std::shared_ptr<ThreadPool> pool;
+        /// @brief number of blocks the shards are grouped into
+        /// @details fixes the summation order. One gradient-sized buffer is kept per block and concurrent call.
+        Index n_blocks = 32;
+
+        /// @brief number of shards
+        virtual Index n_shards() const = 0;
+
+        /// @brief loss of shard i
+        /// @details called concurrently for different shards.
+        virtual fp_t shard_loss(
+            Index i, const Mat<fp_t> &x) = 0;
+
+        /// @brief add the gradient of shard i to g
+        /// @details called concurrently for different shards, each with its own g.
+        virtual void shard_grad(
+            Index i, const Mat<fp_t> &x, Mat<fp_t> &g) = 0;
+
+        /// @brief loss of shard i, and add its gradient to g
+        /// @details the default calls `shard_grad` and `shard_loss` separately.
+        virtual fp_t shard_loss_and_grad(
+            Index i, const Mat<fp_t> &x, Mat<fp_t> &g)
+        {
+            shard_grad(i, x, g);
+            return shard_loss(i, x);
+        }
+
+        fp_t loss(const Mat<fp_t> &x) override
+        {
+            const Index n = n_shards();
+            Checkout blocks(*this, x, n, false);
+            const Index nb = blocks.nb;
+            pool->parallel_for(nb, [&](Index b)
+                               {
+                fp_t sum = 0;
+                for (Index i = item_begin(b, nb, n); i < item_begin(b + 1, nb, n); i++)
+                    sum += shard_loss(i, x);
+                blocks->loss[b] = sum; });
+            return blocks.reduce_loss();
+        }
+
+        void grad(const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            const Index n = n_shards();
+            Checkout blocks(*this, x, n, true);
+            const Index nb = blocks.nb;
+            pool->parallel_for(nb, [&](Index b)
+                               {
+                Mat<fp_t> &gb = blocks->grad[b];
+                BMO_SET_ZERO(gb);
+                for (Index i = item_begin(b, nb, n); i < item_begin(b + 1, nb, n); i++)
+                    shard_grad(i, x, gb); });
+            blocks.reduce_grad(x, g);
+        }
+
+        fp_t loss_and_grad(const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            const Index n = n_shards();
+            Checkout blocks(*this, x, n, true);
+            const Index nb = blocks.nb;
+            pool->parallel_for(nb, [&](Index b)
+                               {
+                Mat<fp_t> &gb = blocks->grad[b];
+                BMO_SET_ZERO(gb);
+                fp_t sum = 0;
+                for (Index i = item_begin(b, nb, n); i < item_begin(b + 1, nb, n); i++)
+                    sum += shard_loss_and_grad(i, x, gb);
+                blocks->loss[b] = sum; });
+            blocks.reduce_grad(x, g);
+            return blocks.reduce_loss();
+        }
+
+        /// @brief g = sum of the gradients of the n given shards
+        /// @details same blocked reduction as `grad`, used by the stochastic solvers for mini-batches.
+        void batch_grad(
+            const Index *shards, Index n,
+            const Mat<fp_t> &x, Mat<fp_t> &g)
+        {
+            Checkout blocks(*this, x, n, true);
+            const Index nb = blocks.nb;
+            pool->parallel_for(nb, [&](Index b)
+                               {
+                Mat<fp_t> &gb = blocks->grad[b];
+                BMO_SET_ZERO(gb);
+                for (Index i = item_begin(b, nb, n); i < item_begin(b + 1, nb, n); i++)
+                    shard_grad(shards[i], x, gb); });
+            blocks.reduce_grad(x, g);
+        }
+
+        /// @brief the pool shards run on, created with one thread per core if not set
+        ThreadPool &thread_pool()
+        {
+            if (!pool)
+                pool = std::make_shared<ThreadPool>();
+            return *pool;
+        }
+
+    private:
+        /// @brief buffers of one call, a gradient and a loss per block
+        struct Blocks
+        {
+            std::vector<Mat<fp_t>> grad;
+            std::vector<fp_t> loss;
+        };
+
+        std::mutex blocks_mtx;
+        std::vector<std::unique_ptr<Blocks>> free_blocks; // sets not used by any call
+
+        /// @brief a set of block buffers held by one call, sized like x, returned on destruction
+        struct Checkout
+        {
+            FiniteSumProblem &prob;
+            std::unique_ptr<Blocks> blocks;
+            Index nb; ///< number of blocks in use
+
+            Checkout(FiniteSumProblem &prob, const Mat<fp_t> &x, Index n, bool need_grad)
+                : prob(prob)
+            {
+                prob.thread_pool();
+                nb = std::max(Index(1), std::min(prob.n_blocks, n));
+                {
+                    std::lock_guard<std::mutex> lk(prob.blocks_mtx);
+                    if (!prob.free_blocks.empty())
+                    {
+                        blocks = std::move(prob.free_blocks.back());
+                        prob.free_blocks.pop_back();
+                    }
+                }
+                if (!blocks)
+                    blocks = std::make_unique<Blocks>();
+                blocks->loss.resize(nb);
+                if (need_grad)
+                {
+                    if (Index(blocks->grad.size()) < nb)
+                        blocks->grad.resize(nb);
+                    for (Index b = 0; b < nb; b++)
+                        BMO_RESIZE(blocks->grad[b], BMO_ROWS(x), BMO_COLS(x));
+                }
+            }
+
+            ~Checkout()
+            {
+                std::lock_guard<std::mutex> lk(prob.blocks_mtx);
+                prob.free_blocks.push_back(std::move(blocks));
+            }
+
+            Checkout(const Checkout &) = delete;
+            Checkout &operator=(const Checkout &) = delete;
+
+            Blocks *operator->() const { return blocks.get(); }
+
+            fp_t reduce_loss() const
+            {
+                fp_t sum = 0;
+                for (Index b = 0; b < nb; b++)
+                    sum += blocks->loss[b];
+                return sum;
+            }
+
+            void reduce_grad(const Mat<fp_t> &x, Mat<fp_t> &g) const
+            {
+                BMO_RESIZE(g, BMO_ROWS(x), BMO_COLS(x));
+                g = blocks->grad[0];
+                for (Index b = 1; b < nb; b++)
+                    g += blocks->grad[b];
+            }
+        };
+
+        OPTIM_INLINE static Index item_begin(Index b, Index nb, Index n)
+        {
+            return b * n / nb;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+#ifndef _OPTIMLIB_BASE_LEAST_SQUARES_PROBLEM_HPP_
+#define _OPTIMLIB_BASE_LEAST_SQUARES_PROBLEM_HPP_
+
+#include "BaseProblem.hpp"
+
+namespace optim
+{
+    /// @brief how a LeastSquaresProblem provides its Jacobian
+    enum class JacobianType
+    {
+        Dense,   ///< `jacobian` fills an m x n matrix
+        Sparse,  ///< `sp_jacobian` fills a sparse m x n matrix
+        Operator ///< `jac_forward` and `jac_backward` apply J and J^T at the point of the last `update_jac`
+    };
+
+    /// @brief Nonlinear least-squares problem interface, f(x) = 1/2 |r(x)|^2
+    /// @details Implement the m residuals of an n x 1 point and one way to get their m x n Jacobian J, chosen by `jacobian_type`. `loss`, `grad` and `loss_and_grad` are derived from them (the gradient is J^T r), so the problem also works with the solvers taking a GradProblem.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    struct LeastSquaresProblem
+        : public GradProblem<fp_t>
+    {
+        /// @brief number of residuals m
+        virtual Index n_residuals() const = 0;
+
+        /// @brief residuals at x
+        /// @param x the point to evaluate
+        /// @param r the output m x 1 residuals
+        virtual void residual(
+            const Mat<fp_t> &x,
+            Mat<fp_t> &r) = 0;
+
+        /// @brief which of the Jacobian functions are implemented
+        virtual JacobianType jacobian_type() const { return JacobianType::Dense; }
+
+        /// @brief dense Jacobian at x, for JacobianType::Dense
+        virtual void jacobian(
+            [[maybe_unused]] const Mat<fp_t> &x,
+            [[maybe_unused]] Mat<fp_t> &J)
+        {
+            throw std::runtime_error("Jacobian not implemented");
+        };
+
+        /// @brief sparse Jacobian at x, for JacobianType::Sparse
+        /// @details the products with J and J^T are the only operations on it, any pattern works.
+        virtual void sp_jacobian(
+            [[maybe_unused]] const Mat<fp_t> &x,
+            [[maybe_unused]] SpMat<fp_t> &J)
+        {
+            throw std::runtime_error("Sparse Jacobian not implemented");
+        };
+
+        /// @brief move the Jacobian to point x, for JacobianType::Operator
+        /// @details called before any Jacobian product at a new point. The default does nothing.
+        virtual void update_jac([[maybe_unused]] const Mat<fp_t> &x){};
+
+        /// @brief Jacobian-vector product Jv = J v, for JacobianType::Operator
+        virtual void jac_forward(
+            [[maybe_unused]] const Mat<fp_t> &v,
+            [[maybe_unused]] Mat<fp_t> &Jv)
+        {
+            throw std::runtime_error("Jacobian product not implemented");
+        };
+
+        /// @brief transposed product Jtu = J^T u, for JacobianType::Operator
+        virtual void jac_backward(
+            [[maybe_unused]] const Mat<fp_t> &u,
+            [[maybe_unused]] Mat<fp_t> &Jtu)
+        {
+            throw std::runtime_error("Jacobian transpose product not implemented");
+        };
+
+        fp_t loss(const Mat<fp_t> &x) override
+        {
+            Mat<fp_t> r(n_residuals(), 1);
+            residual(x, r);
+            return fp_t(0.5) * BMO_SQUARE_NORM(r);
+        }
+
+        void grad(const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            loss_and_grad(x, g);
+        }
+
+        fp_t loss_and_grad(const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            const Index m = n_residuals(), n = BMO_ROWS(x);
+            Mat<fp_t> r(m, 1);
+            residual(x, r);
+            switch (jacobian_type())
+            {
+            case JacobianType::Dense:
+            {
+                Mat<fp_t> J(m, n);
+                jacobian(x, J);
+                BMO_NOALIAS(g) = BMO_TRANSPOSE(J) * r;
+                break;
+            }
+            case JacobianType::Sparse:
+            {
+                SpMat<fp_t> J(m, n);
+                sp_jacobian(x, J);
+                BMO_NOALIAS(g) = BMO_TRANSPOSE(J) * r;
+                break;
+            }
+            case JacobianType::Operator:
+                update_jac(x);
+                jac_backward(r, g);
+                break;
+            }
+            return fp_t(0.5) * BMO_SQUARE_NORM(r);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,216 @@
+#pragma once
+#ifndef _OPTIMLIB_BASE_MULTI_START_HPP_
+#define _OPTIMLIB_BASE_MULTI_START_HPP_
+
+#include "BaseSolver.hpp"
+#include "misc/thread_pool.hpp"
+#include <exception>
+
+/// @cond
+namespace optim::internal::multi_start
+{
+    /// @brief thrown out of the solver to abandon a start
+    struct Abandoned
+    {
+    };
+
+    /// @brief the problem seen by the solver of one start
+    /// @details forwards to the user problem and records every loss. The incumbent is lowered to any loss below it, and the start is abandoned once it cannot beat the incumbent at its recent rate of progress.
+    template <typename fp_t, typename P>
+    struct MonitorBase : public P
+    {
+        std::shared_ptr<P> inner;
+        std::atomic<fp_t> *incumbent;
+        Recorder<fp_t> history;
+        int window;
+        fp_t patience;
+        int n_eval = 0;
+
+        MonitorBase(std::shared_ptr<P> inner, std::atomic<fp_t> *incumbent,
+                    int window, fp_t patience)
+            : inner(inner), incumbent(incumbent), history(window, false),
+              window(window), patience(patience) {}
+
+        void check(fp_t f, const Mat<fp_t> &x)
+        {
+            history.record(n_eval++, f, x);
+            fp_t best = incumbent->load(std::memory_order_relaxed);
+            while (f < best &&
+                   !incumbent->compare_exchange_weak(best, f, std::memory_order_relaxed))
+                ;
+            if (n_eval < window || !(history.best_loss > best))
+                return;
+            // loss decrease over the last window evaluations
+            const fp_t progress = history.prev_k_max_loss() - history.best_loss;
+            if (history.best_loss - best > patience * progress)
+                throw Abandoned();
+        }
+
+        fp_t loss(const Mat<fp_t> &x) override
+        {
+            const fp_t f = inner->loss(x);
+            check(f, x);
+            return f;
+        }
+
+        void grad(const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            inner->grad(x, g);
+        }
+
+        fp_t loss_and_grad(const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            const fp_t f = inner->loss_and_grad(x, g);
+            check(f, x);
+            return f;
+        }
+    };
+
+    template <typename fp_t, typename P,
+              bool hess = std::is_base_of_v<HessProblem<fp_t>, P>>
+    struct Monitor : public MonitorBase<fp_t, P>
+    {
+        using MonitorBase<fp_t, P>::MonitorBase;
+    };
+
+    template <typename fp_t, typename P>
+    struct Monitor<fp_t, P, true> : public MonitorBase<fp_t, P>
+    {
+        using MonitorBase<fp_t, P>::MonitorBase;
+
+        void update_hess(const Mat<fp_t> &x) override { this->inner->update_hess(x); }
+
+        void hess_forward(const Mat<fp_t> &x, Mat<fp_t> &d) override
+        {
+            this->inner->hess_forward(x, d);
+        }
+
+        void hess_backward(const Mat<fp_t> &x, Mat<fp_t> &d) override
+        {
+            this->inner->hess_backward(x, d);
+        }
+
+        void hess_diag(Mat<fp_t> &d) override { this->inner->hess_diag(d); }
+    };
+}
+/// @endcond
+
+namespace optim
+{
+    /// @brief Multi-start driver
+    /// @details runs a solver from many starting points on a thread pool and keeps the best distinct minima. The starts share the lowest loss evaluated so far, the incumbent, through an atomic. A start is abandoned once it cannot reach the incumbent at its recent rate of progress: after `window` evaluations, when its best loss is above the incumbent by more than `patience` times the loss decrease over its last `window` evaluations. Every start gets its own solver from the factory, so any solver works and none is shared between threads. The problem is shared, its functions are called concurrently and must be thread-safe: FiniteSumProblem is, and may even share the pool of the driver, CachedProblem is not.
+    /// @tparam fp_t floating-point type
+    /// @tparam Problem problem interface the solvers take, GradProblem or HessProblem
+    template <typename fp_t,
+              template <typename, int, int> class Problem = GradProblem>
+    class MultiStart
+    {
+    public:
+        using ProblemType = Problem<fp_t, Dynamic, Dynamic>;
+        using Solver = BaseSolver<fp_t>;
+        using SolverFactory = std::function<std::shared_ptr<Solver>(std::shared_ptr<ProblemType>)>;
+
+        static_assert(std::is_base_of_v<GradProblem<fp_t>, ProblemType>,
+                      "MultiStart requires a GradProblem");
+
+        /// @brief a minimum found
+        struct Result
+        {
+            Index start; ///< index of the starting point
+            fp_t loss;
+            Mat<fp_t> x;
+            int n_iter; ///< iterations of the solver
+        };
+
+    private:
+        std::shared_ptr<ProblemType> prob;
+        SolverFactory make_solver;
+        std::atomic<fp_t> incumbent{OptimConst<fp_t>::inf};
+        std::atomic<int> abandoned{0};
+
+    public:
+        /// @brief pool the starts run on, created on first use with one thread per core if not set
+        std::shared_ptr<ThreadPool> pool;
+
+        int top_k = 5;         ///< number of minima returned
+        int window = 10;       ///< evaluations the progress of a start is measured over
+        fp_t patience = 10;    ///< windows a start may need to reach the incumbent, inf never abandons
+        fp_t min_dist = 1e-4;  ///< minima closer than this count as one
+
+    public:
+        /// @param p problem to minimize
+        /// @param make_solver makes the solver of one start for the problem it is given
+        MultiStart(std::shared_ptr<ProblemType> p, SolverFactory make_solver)
+            : prob(p), make_solver(make_solver) {}
+
+        /// @brief lowest loss evaluated by the last solve()
+        fp_t best_loss() const { return incumbent.load(); }
+
+        /// @brief number of starts abandoned by the last solve()
+        int n_abandoned() const { return abandoned.load(); }
+
+        /// @brief run the solver from every starting point
+        /// @return up to top_k distinct minima of the finished starts, best first
+        std::vector<Result> solve(const std::vector<Mat<fp_t>> &starts)
+        {
+            using Monitor = internal::multi_start::Monitor<fp_t, ProblemType>;
+            if (!pool)
+                pool = std::make_shared<ThreadPool>();
+            const Index n = Index(starts.size());
+            incumbent = OptimConst<fp_t>::inf;
+            abandoned = 0;
+            std::vector<Result> results(n);
+            std::vector<char> finished(n, 0);
+            std::exception_ptr error;
+            std::mutex error_mtx;
+            pool->parallel_for(n, [&](Index i)
+                               {
+                try
+                {
+                    auto monitor = std::make_shared<Monitor>(prob, &incumbent, window, patience);
+                    auto solver = make_solver(monitor);
+                    Result &r = results[i];
+                    r.start = i;
+                    r.x = starts[i];
+                    r.loss = solver->solve(r.x);
+                    r.n_iter = solver->n_iter();
+                    finished[i] = 1;
+                    logger.trace("[MultiStart] start {} ends at loss {:g} after {} iterations.", i, r.loss, r.n_iter);
+                }
+                catch (const internal::multi_start::Abandoned &)
+                {
+                    abandoned++;
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lk(error_mtx);
+                    error = std::current_exception();
+                } });
+            if (error)
+                std::rethrow_exception(error);
+            // best first, then drop the minima close to a better one
+            std::vector<Index> order;
+            for (Index i = 0; i < n; i++)
+                if (finished[i])
+                    order.push_back(i);
+            std::sort(order.begin(), order.end(), [&](Index a, Index b)
+                      { return results[a].loss < results[b].loss; });
+            std::vector<Result> minima;
+            for (Index i : order)
+            {
+                if (int(minima.size()) == top_k)
+                    break;
+                bool distinct = true;
+                for (const Result &m : minima)
+                    distinct &= !(BMO_FRO_NORM(Mat<fp_t>(results[i].x - m.x)) < min_dist);
+                if (distinct)
+                    minima.push_back(std::move(results[i]));
+            }
+            logger.info("[MultiStart] {} starts, {} abandoned, best loss: {:g}.",
+                        n, abandoned.load(), minima.empty() ? OptimConst<fp_t>::inf : minima[0].loss);
+            return minima;
+        }
+    };
+}
+
+#endif
@@ -109,6 +109,33 @@ namespace optim
             return _length == 0;
         };
 
+        OPTIM_INLINE int
+        capacity() const
+        {
+            return _size;
+        };
+
+        /// @brief drop all elements but keep the storage of each slot
+        OPTIM_INLINE void
+        clear()
+        {
+            _head = 0;
+            _length = 0;
+        };
+
+        /// @brief clear the array and make it hold up to size elements
+        /// @details slots are only reallocated when size changes, so the elements keep their memory for reuse.
+        void reset(int size)
+        {
+            clear();
+            if (size == _size)
+                return;
+            if (data)
+                delete[] data;
+            _size = size;
+            data = new T[size];
+        };
+
         CircularArray() = default;
 
         CircularArray(int size)
@@ -118,6 +145,9 @@ namespace optim
             _head = 0;
         };
 
+        CircularArray(const CircularArray &) = delete;
+        CircularArray &operator=(const CircularArray &) = delete;
+
         ~CircularArray()
         {
             if (data)
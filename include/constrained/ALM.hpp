@@ -31,6 +31,20 @@ namespace optim
             virtual void inequality_constraint(const Mat<fp_t> &x, Mat<fp_t> &res){};
 
             virtual void solve_subproblem(Mat<fp_t> &x) = 0;
+
+            /// @brief solve the subproblem and store the gradient of the augmented Lagrangian at the solution in g
+            /// @details override it to hand over the gradient the subproblem solver already has, the default evaluates it again.
+            virtual void solve_subproblem_and_grad(Mat<fp_t> &x, Mat<fp_t> &g)
+            {
+                solve_subproblem(x);
+                internal::trace::Span trace("grad");
+                this->grad(x, g);
+                internal::instrument::count(internal::instrument::Eval::Grad);
+            }
+
+            /// @brief called whenever ALM changed the multipliers or qd_reg, before the next subproblem
+            /// @details the augmented Lagrangian is then a different function, e.g. call `clear()` here on a CachedProblem wrapping it.
+            virtual void update_lagrangian(){};
         };
 
         std::shared_ptr<Problem> prob;
@@ -61,6 +75,8 @@ namespace optim
 
         fp_t solve(Mat<fp_t> &x) override
         {
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("ALM");
             fp_t cons_loss, cur_cons_tol;
             // resize matrix
             Mat<fp_t> eq_res = prob->eq_multiplier,
@@ -69,18 +85,21 @@ namespace optim
             // init subproblem tol
             prob->qd_reg = init_qd_reg;
             prob->gtol = 1 / init_qd_reg;
-            cons_viol_tol = 1 / std::pow(init_qd_reg, alpha);
+            cur_cons_tol = 1 / std::pow(init_qd_reg, alpha);
             for (iter = 1; iter < max_iter; iter++)
             {
-                prob->solve_subproblem(x);
+                internal::trace::Span trace_iter("iter");
+                {
+                    internal::trace::Span trace("subproblem");
+                    prob->solve_subproblem_and_grad(x, cur_grad);
+                }
                 update_constraint_violation(x, eq_res, ineq_res);
                 fn::max(ineq_res, -prob->gtol / prob->qd_reg, ineq_res);
                 cons_loss = BMO_SQUARE_NORM(ineq_res) + BMO_SQUARE_NORM(eq_res);
                 cons_loss = std::sqrt(cons_loss);
-                prob->grad(x, cur_grad);
                 if (cons_loss < cur_cons_tol)
                 {
-                    if (BMO_FRO_NORM(cur_grad) < gtol)
+                    if (cons_loss < cons_viol_tol && BMO_FRO_NORM(cur_grad) < gtol)
                         return 0;
                     // update multiplier
                     prob->eq_multiplier += prob->qd_reg * eq_res;
@@ -95,6 +114,7 @@ namespace optim
                     prob->gtol = 1. / prob->qd_reg;
                     cur_cons_tol = 1. / std::pow(prob->qd_reg, alpha);
                 }
+                prob->update_lagrangian();
             }
             return 0;
         }
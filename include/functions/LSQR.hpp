@@ -0,0 +1,102 @@
+#pragma once
+#ifndef __OPTIM_LSQR_HPP__
+#define __OPTIM_LSQR_HPP__
+
+/// @cond
+template <typename fp_t>
+struct lsqrParams
+{
+    int max_iter;
+    fp_t tol;
+};
+
+/// @brief buffers of lsqr, kept by the caller between solves
+template <typename fp_t>
+struct lsqrWorkspace
+{
+    Mat<fp_t> u, Av;     ///< m x 1
+    Mat<fp_t> v, w, Atu; ///< n x 1
+    int n_iter = 0;      ///< iterations of the last solve
+
+    void resize(Index m, Index n)
+    {
+        BMO_RESIZE(u, m, 1), BMO_RESIZE(Av, m, 1);
+        BMO_RESIZE(v, n, 1), BMO_RESIZE(w, n, 1), BMO_RESIZE(Atu, n, 1);
+    }
+};
+
+/// @brief LSQR (Paige & Saunders), x = argmin |A x - b|^2 + damp^2 |x|^2
+/// @details only needs the products `apply_A(v, Av)` and `apply_At(u, Atu)`. Stops when the residual of the damped normal equations is below `tol` relative to |A| |r|, or the residual below `tol` relative to |A| |x| + |b|.
+/// @return 0 if converged, 1 if max_iter is reached
+template <typename forward_fn, typename backward_fn, typename fp_t>
+int lsqr(forward_fn &&apply_A, backward_fn &&apply_At,
+         const Mat<fp_t> &b, fp_t damp, Mat<fp_t> &x,
+         lsqrWorkspace<fp_t> &ws, const lsqrParams<fp_t> &param)
+{
+    BMO_SET_ZERO(x);
+    ws.n_iter = 0;
+    const int max_iter =
+        param.max_iter < 0 ? BMO_SIZE(x) : param.max_iter;
+    Mat<fp_t> &u = ws.u, &v = ws.v, &w = ws.w;
+    // Golub-Kahan bidiagonalization: beta u = b, alpha v = A^T u
+    fp_t beta = BMO_FRO_NORM(b), alpha = 0;
+    const fp_t b_nrm = beta;
+    if (beta == 0)
+        return 0;
+    u = b / beta;
+    apply_At(u, ws.Atu);
+    v = ws.Atu;
+    alpha = BMO_FRO_NORM(v);
+    if (alpha == 0)
+        return 0;
+    v /= alpha;
+    w = v;
+    fp_t phibar = beta, rhobar = alpha,
+         a_nrm2 = 0, res2 = 0;
+    for (int iter = 0; iter < max_iter; iter++)
+    {
+        ws.n_iter++;
+        apply_A(v, ws.Av);
+        u *= -alpha;
+        u += ws.Av;
+        beta = BMO_FRO_NORM(u);
+        if (beta > 0)
+        {
+            u /= beta;
+            a_nrm2 += alpha * alpha + beta * beta + damp * damp;
+            apply_At(u, ws.Atu);
+            v *= -beta;
+            v += ws.Atu;
+            alpha = BMO_FRO_NORM(v);
+            if (alpha > 0)
+                v /= alpha;
+        }
+        // rotate the damping away, then the subdiagonal beta
+        const fp_t rhobar1 = std::hypot(rhobar, damp),
+                   cs1 = rhobar / rhobar1,
+                   sn1 = damp / rhobar1,
+                   psi = sn1 * phibar;
+        phibar *= cs1;
+        const fp_t rho = std::hypot(rhobar1, beta),
+                   cs = rhobar1 / rho,
+                   sn = beta / rho,
+                   theta = sn * alpha,
+                   phi = cs * phibar;
+        rhobar = -cs * alpha;
+        phibar *= sn;
+        x += (phi / rho) * w;
+        w *= -theta / rho;
+        w += v;
+        // |r| of the damped system and |A^T r| of its normal equations
+        res2 += psi * psi;
+        const fp_t r_nrm = std::sqrt(phibar * phibar + res2),
+                   a_nrm = std::sqrt(a_nrm2),
+                   ar_nrm = alpha * std::abs(sn * phi);
+        if (ar_nrm <= param.tol * a_nrm * r_nrm ||
+            r_nrm <= param.tol * (a_nrm * BMO_FRO_NORM(x) + b_nrm))
+            return 0;
+    }
+    return 1;
+}
+/// @endcond
+#endif
@@ -3,12 +3,15 @@
 #define _OPTIM_FUNCTIONS_HPP_
 
 #include "macro/macro.h"
+#include "prox_kernel.hpp"
 
 namespace optim::fn
 {
 #include "max.hpp"
 #include "min.hpp"
 #include "CG.hpp"
+#include "LSQR.hpp"
+#include "projection.hpp"
 #include "proximal.hpp"
 }
 
@@ -0,0 +1,189 @@
+#pragma once
+#ifndef _OPTIM_FUNCTIONS_PROJECTION_HPP_
+#define _OPTIM_FUNCTIONS_PROJECTION_HPP_
+
+/// @brief threshold of the projection onto the (weighted) simplex
+/// @details finds tau with sum_i w_i max(y_i - tau w_i, 0) = a by Condat's algorithm (Fast projection onto the simplex and the l1 ball, 2016), extended to positive weights. Every candidate tau = (sum_S w_i y_i - a) / sum_S w_i^2 of a subset S is a lower bound of the solution, so entries with y_i <= tau w_i are dropped for good as soon as they fall below one. Expected linear time, no sort. The active entries are kept in a per-thread buffer that only grows.
+/// @tparam use_abs take y_i = |x_i|, for the L1 ball
+/// @tparam weighted use the weights w, otherwise w_i = 1 and w is not read
+/// @param x input of size n
+/// @param w positive weights of size n
+/// @param a radius, positive
+/// @return tau
+template <bool use_abs, bool weighted, typename fp_t>
+fp_t simplex_threshold(const fp_t *x, const fp_t *w, Index n, fp_t a)
+{
+    optim_assert(n > 0, "empty input.");
+    thread_local std::vector<fp_t> buf_y, buf_w;
+    if (Index(buf_y.size()) < n)
+    {
+        buf_y.resize(n);
+        if constexpr (weighted)
+            buf_w.resize(n);
+    }
+    fp_t *vy = buf_y.data(), *vw = buf_w.data();
+    auto Y = [x](Index i) -> fp_t
+    { return use_abs ? std::abs(x[i]) : x[i]; };
+    auto W = [w](Index i) -> fp_t
+    {
+        if constexpr (weighted)
+            return w[i];
+        else
+            return fp_t(1);
+    };
+    auto VW = [vw](Index j) -> fp_t
+    {
+        if constexpr (weighted)
+            return vw[j];
+        else
+            return fp_t(1);
+    };
+    // the active set v is [start, len) of the buffer, [0, start) holds
+    // entries set aside when a single entry gave a larger bound
+    Index start = 0, len = 1;
+    fp_t num, den, tau;
+    vy[0] = Y(0);
+    if constexpr (weighted)
+        vw[0] = W(0);
+    num = VW(0) * vy[0], den = VW(0) * VW(0);
+    tau = (num - a) / den;
+    for (Index i = 1; i < n; i++)
+    {
+        const fp_t y = Y(i), wi = W(i);
+        if (y <= tau * wi)
+            continue;
+        vy[len] = y;
+        if constexpr (weighted)
+            vw[len] = wi;
+        len++;
+        num += wi * y, den += wi * wi;
+        tau = (num - a) / den;
+        const fp_t tau_i = (wi * y - a) / (wi * wi);
+        if (tau <= tau_i)
+        { // restart from the single entry i
+            start = len - 1;
+            num = wi * y, den = wi * wi;
+            tau = tau_i;
+        }
+    }
+    // entries set aside may still be active, v grows to the left
+    Index p = start;
+    for (Index j = start - 1; j >= 0; j--)
+        if (vy[j] > tau * VW(j))
+        {
+            p--;
+            vy[p] = vy[j];
+            if constexpr (weighted)
+                vw[p] = vw[j];
+            num += VW(p) * vy[p], den += VW(p) * VW(p);
+            tau = (num - a) / den;
+        }
+    start = p;
+    // drop entries below tau until none is left
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        Index k = start, left = len - start;
+        for (Index j = start; j < len; j++)
+        { // never empty v, only rounding could ask for it
+            if (vy[j] > tau * VW(j) || left == 1)
+            {
+                vy[k] = vy[j];
+                if constexpr (weighted)
+                    vw[k] = vw[j];
+                k++;
+            }
+            else
+            {
+                num -= VW(j) * vy[j], den -= VW(j) * VW(j);
+                tau = (num - a) / den;
+                left--;
+                changed = true;
+            }
+        }
+        len = k;
+    }
+    // recompute the sums over the final set to drop the rounding of the updates
+    num = den = 0;
+    for (Index j = start; j < len; j++)
+        num += VW(j) * vy[j], den += VW(j) * VW(j);
+    return (num - a) / den;
+}
+
+/// @brief projection onto the simplex {x >= 0, sum x = a}
+/// @tparam fp_t floating-point type
+/// @param a sum of the entries, positive
+/// @param in_x input x
+/// @param out output, max(in_x - tau, 0)
+template <typename fp_t>
+void proj_simplex(fp_t a, const Mat<fp_t> &in_x, Mat<fp_t> &out)
+{
+    optim_assert(a > 0, "a must be positive.");
+    const Index n = BMO_ROWS(in_x),
+                m = BMO_COLS(in_x);
+    const fp_t tau = simplex_threshold<false, false>(
+        BMO_GET_DATA(in_x), (const fp_t *)nullptr, n * m, a);
+    BMO_RESIZE(out, n, m);
+    const fp_t *x = BMO_GET_DATA(in_x);
+    fp_t *y = BMO_GET_DATA(out);
+    for (Index i = 0; i < n * m; i++)
+        y[i] = std::max(x[i] - tau, fp_t(0));
+}
+
+/// @brief projection onto the L1 ball {|x|_1 <= radius}
+/// @tparam fp_t floating-point type
+/// @param radius radius of the ball, positive
+/// @param in_x input x
+/// @param out output, sign(in_x) max(|in_x| - tau, 0), or in_x if it is in the ball
+template <typename fp_t>
+void proj_l1_ball(fp_t radius, const Mat<fp_t> &in_x, Mat<fp_t> &out)
+{
+    optim_assert(radius > 0, "radius must be positive.");
+    const Index n = BMO_ROWS(in_x),
+                m = BMO_COLS(in_x);
+    BMO_RESIZE(out, n, m);
+    if (BMO_SUM(BMO_ABS(in_x)) <= radius)
+    {
+        out = in_x;
+        return;
+    }
+    const fp_t tau = simplex_threshold<true, false>(
+        BMO_GET_DATA(in_x), (const fp_t *)nullptr, n * m, radius);
+    kernel::soft_threshold(BMO_GET_DATA(in_x), BMO_GET_DATA(out), n * m, tau);
+}
+
+/// @brief projection onto the weighted L1 ball {sum w_i |x_i| <= radius}
+/// @tparam fp_t floating-point type
+/// @param radius radius of the ball, positive
+/// @param weight positive weights, same shape as in_x
+/// @param in_x input x
+/// @param out output, sign(in_x) max(|in_x| - tau w, 0), or in_x if it is in the ball
+template <typename fp_t>
+void proj_l1_ball(fp_t radius, const Mat<fp_t> &weight,
+                  const Mat<fp_t> &in_x, Mat<fp_t> &out)
+{
+    optim_assert(radius > 0, "radius must be positive.");
+    const Index n = BMO_ROWS(in_x),
+                m = BMO_COLS(in_x);
+    optim_assert(BMO_SIZE(weight) == n * m, "weight must have the shape of x.");
+    const fp_t *x = BMO_GET_DATA(in_x), *w = BMO_GET_DATA(weight);
+    fp_t wsum = 0;
+    for (Index i = 0; i < n * m; i++)
+        wsum += w[i] * std::abs(x[i]);
+    BMO_RESIZE(out, n, m);
+    if (wsum <= radius)
+    {
+        out = in_x;
+        return;
+    }
+    const fp_t tau = simplex_threshold<true, true>(x, w, n * m, radius);
+    fp_t *y = BMO_GET_DATA(out);
+    for (Index i = 0; i < n * m; i++)
+    {
+        const fp_t t = tau * w[i];
+        y[i] = x[i] - std::min(std::max(x[i], -t), t);
+    }
+}
+
+#endif
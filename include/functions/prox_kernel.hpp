@@ -0,0 +1,350 @@
+#pragma once
+#ifndef _OPTIM_FUNCTIONS_PROX_KERNEL_HPP_
+#define _OPTIM_FUNCTIONS_PROX_KERNEL_HPP_
+
+#include "macro/macro.h"
+#include <atomic>
+
+// define OPTIM_NO_SIMD to only build the scalar kernels
+#if !defined(OPTIM_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define OPTIM_SIMD_X86
+#include <immintrin.h>
+#elif !defined(OPTIM_NO_SIMD) && defined(__aarch64__) && defined(__ARM_NEON)
+#define OPTIM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/// @brief elementwise kernels of the proximal operators on raw buffers
+/// @details Every kernel has a scalar, NEON, AVX2 and AVX-512 version. The x86 versions are compiled with per-function target attributes, so no -mavx flag is needed, and the widest one the CPU supports is picked at runtime on first use. NEON is part of AArch64, so it is always used there. Input and output may alias. Only `float` and `double` are vectorized, other types use the scalar kernels.
+namespace optim::fn::kernel
+{
+    enum class SimdISA
+    {
+        Scalar = 0,
+        NEON = 1,
+        AVX2 = 2,
+        AVX512 = 3
+    };
+
+    template <typename T>
+    struct ProxKernelTable
+    {
+        /// y = sign(x) max(|x| - t, 0)
+        void (*soft_threshold)(const T *x, T *y, Index n, T t);
+        /// y = s sign(x) max(|x| - t, 0)
+        void (*elastic_net)(const T *x, T *y, Index n, T t, T s);
+        /// y = min(max(x, lo), hi)
+        void (*clamp)(const T *x, T *y, Index n, T lo, T hi);
+        /// y_i = min(max(x_i, lo_i), hi_i)
+        void (*clamp_vec)(const T *x, const T *lo, const T *hi, T *y, Index n);
+        /// sum x_i^2
+        T (*squared_norm)(const T *x, Index n);
+        /// y = a x
+        void (*scale)(const T *x, T *y, Index n, T a);
+    };
+
+    /// @cond
+    namespace scalar
+    {
+        template <typename T>
+        struct Vec
+        {
+            using scalar = T;
+            using reg = T;
+            static constexpr Index width = 1;
+            static OPTIM_INLINE reg load(const T *p) { return *p; }
+            static OPTIM_INLINE void store(T *p, reg v) { *p = v; }
+            static OPTIM_INLINE reg set1(T v) { return v; }
+            static OPTIM_INLINE reg min(reg a, reg b) { return std::min(a, b); }
+            static OPTIM_INLINE reg max(reg a, reg b) { return std::max(a, b); }
+            static OPTIM_INLINE reg add(reg a, reg b) { return a + b; }
+            static OPTIM_INLINE reg sub(reg a, reg b) { return a - b; }
+            static OPTIM_INLINE reg mul(reg a, reg b) { return a * b; }
+            static OPTIM_INLINE T reduce(reg a) { return a; }
+        };
+#define OPTIM_SIMD_FN
+#include "prox_kernel.ipp"
+#undef OPTIM_SIMD_FN
+    }
+
+#if defined(OPTIM_SIMD_X86)
+#define OPTIM_SIMD_FN __attribute__((target("avx2")))
+    namespace avx2
+    {
+        template <typename T>
+        struct Vec;
+
+        template <>
+        struct Vec<double>
+        {
+            using scalar = double;
+            using reg = __m256d;
+            static constexpr Index width = 4;
+            static OPTIM_SIMD_FN OPTIM_INLINE reg load(const double *p) { return _mm256_loadu_pd(p); }
+            static OPTIM_SIMD_FN OPTIM_INLINE void store(double *p, reg v) { _mm256_storeu_pd(p, v); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg set1(double v) { return _mm256_set1_pd(v); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE double reduce(reg a)
+            {
+                const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a),
+                                             _mm256_extractf128_pd(a, 1));
+                return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+            }
+        };
+
+        template <>
+        struct Vec<float>
+        {
+            using scalar = float;
+            using reg = __m256;
+            static constexpr Index width = 8;
+            static OPTIM_SIMD_FN OPTIM_INLINE reg load(const float *p) { return _mm256_loadu_ps(p); }
+            static OPTIM_SIMD_FN OPTIM_INLINE void store(float *p, reg v) { _mm256_storeu_ps(p, v); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg set1(float v) { return _mm256_set1_ps(v); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE float reduce(reg a)
+            {
+                __m128 s = _mm_add_ps(_mm256_castps256_ps128(a),
+                                      _mm256_extractf128_ps(a, 1));
+                s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+                return _mm_cvtss_f32(_mm_add_ss(s, _mm_movehdup_ps(s)));
+            }
+        };
+#include "prox_kernel.ipp"
+    }
+#undef OPTIM_SIMD_FN
+
+// GCC 12 warns about _mm512_undefined_pd inside its own min/max/extract
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#define OPTIM_SIMD_FN __attribute__((target("avx512f")))
+    namespace avx512
+    {
+        template <typename T>
+        struct Vec;
+
+        template <>
+        struct Vec<double>
+        {
+            using scalar = double;
+            using reg = __m512d;
+            static constexpr Index width = 8;
+            static OPTIM_SIMD_FN OPTIM_INLINE reg load(const double *p) { return _mm512_loadu_pd(p); }
+            static OPTIM_SIMD_FN OPTIM_INLINE void store(double *p, reg v) { _mm512_storeu_pd(p, v); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg set1(double v) { return _mm512_set1_pd(v); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE double reduce(reg a)
+            {
+                return avx2::Vec<double>::reduce(
+                    _mm256_add_pd(_mm512_castpd512_pd256(a), _mm512_extractf64x4_pd(a, 1)));
+            }
+        };
+
+        template <>
+        struct Vec<float>
+        {
+            using scalar = float;
+            using reg = __m512;
+            static constexpr Index width = 16;
+            static OPTIM_SIMD_FN OPTIM_INLINE reg load(const float *p) { return _mm512_loadu_ps(p); }
+            static OPTIM_SIMD_FN OPTIM_INLINE void store(float *p, reg v) { _mm512_storeu_ps(p, v); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg set1(float v) { return _mm512_set1_ps(v); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+            static OPTIM_SIMD_FN OPTIM_INLINE float reduce(reg a)
+            { // the upper half through a double cast, extractf32x8 needs AVX512DQ
+                const __m256 h = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1));
+                return avx2::Vec<float>::reduce(_mm256_add_ps(_mm512_castps512_ps256(a), h));
+            }
+        };
+#include "prox_kernel.ipp"
+    }
+#undef OPTIM_SIMD_FN
+#pragma GCC diagnostic pop
+#endif
+
+#if defined(OPTIM_SIMD_NEON)
+#define OPTIM_SIMD_FN
+    namespace neon
+    {
+        template <typename T>
+        struct Vec;
+
+        template <>
+        struct Vec<double>
+        {
+            using scalar = double;
+            using reg = float64x2_t;
+            static constexpr Index width = 2;
+            static OPTIM_INLINE reg load(const double *p) { return vld1q_f64(p); }
+            static OPTIM_INLINE void store(double *p, reg v) { vst1q_f64(p, v); }
+            static OPTIM_INLINE reg set1(double v) { return vdupq_n_f64(v); }
+            static OPTIM_INLINE reg min(reg a, reg b) { return vminq_f64(a, b); }
+            static OPTIM_INLINE reg max(reg a, reg b) { return vmaxq_f64(a, b); }
+            static OPTIM_INLINE reg add(reg a, reg b) { return vaddq_f64(a, b); }
+            static OPTIM_INLINE reg sub(reg a, reg b) { return vsubq_f64(a, b); }
+            static OPTIM_INLINE reg mul(reg a, reg b) { return vmulq_f64(a, b); }
+            static OPTIM_INLINE double reduce(reg a) { return vaddvq_f64(a); }
+        };
+
+        template <>
+        struct Vec<float>
+        {
+            using scalar = float;
+            using reg = float32x4_t;
+            static constexpr Index width = 4;
+            static OPTIM_INLINE reg load(const float *p) { return vld1q_f32(p); }
+            static OPTIM_INLINE void store(float *p, reg v) { vst1q_f32(p, v); }
+            static OPTIM_INLINE reg set1(float v) { return vdupq_n_f32(v); }
+            static OPTIM_INLINE reg min(reg a, reg b) { return vminq_f32(a, b); }
+            static OPTIM_INLINE reg max(reg a, reg b) { return vmaxq_f32(a, b); }
+            static OPTIM_INLINE reg add(reg a, reg b) { return vaddq_f32(a, b); }
+            static OPTIM_INLINE reg sub(reg a, reg b) { return vsubq_f32(a, b); }
+            static OPTIM_INLINE reg mul(reg a, reg b) { return vmulq_f32(a, b); }
+            static OPTIM_INLINE float reduce(reg a) { return vaddvq_f32(a); }
+        };
+#include "prox_kernel.ipp"
+    }
+#undef OPTIM_SIMD_FN
+#endif
+
+    namespace internal
+    {
+        inline SimdISA detect_isa()
+        {
+#if defined(OPTIM_SIMD_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return SimdISA::AVX512;
+            if (__builtin_cpu_supports("avx2"))
+                return SimdISA::AVX2;
+#elif defined(OPTIM_SIMD_NEON)
+            return SimdISA::NEON;
+#endif
+            return SimdISA::Scalar;
+        }
+
+        inline std::atomic<SimdISA> &active_isa()
+        {
+            static std::atomic<SimdISA> isa{detect_isa()};
+            return isa;
+        }
+    }
+    /// @endcond
+
+    /// @brief the widest instruction set supported by this build and CPU
+    inline SimdISA best_simd_isa()
+    {
+        static const SimdISA isa = internal::detect_isa();
+        return isa;
+    }
+
+    /// @brief instruction set of the kernels in use
+    inline SimdISA simd_isa()
+    {
+        return internal::active_isa().load(std::memory_order_relaxed);
+    }
+
+    /// @brief force the instruction set of the kernels, e.g. to benchmark them
+    /// @return false, and nothing changes, if the build or the CPU does not support it
+    inline bool set_simd_isa(SimdISA isa)
+    {
+        const SimdISA best = best_simd_isa();
+        if (isa != SimdISA::Scalar && isa != best &&
+            !(best == SimdISA::AVX512 && isa == SimdISA::AVX2))
+            return false;
+        internal::active_isa().store(isa, std::memory_order_relaxed);
+        return true;
+    }
+
+    inline const char *simd_isa_name(SimdISA isa)
+    {
+        static const char *names[] = {"scalar", "NEON", "AVX2", "AVX-512"};
+        return names[int(isa)];
+    }
+
+    /// @brief kernels of the instruction set in use
+    template <typename T>
+    const ProxKernelTable<T> &kernels()
+    {
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>)
+        { // indexed by SimdISA, unsupported sets fall back to scalar
+            static const ProxKernelTable<T> tables[] = {
+                scalar::make_table<scalar::Vec<T>>(),
+#if defined(OPTIM_SIMD_NEON)
+                neon::make_table<neon::Vec<T>>(),
+#else
+                scalar::make_table<scalar::Vec<T>>(),
+#endif
+#if defined(OPTIM_SIMD_X86)
+                avx2::make_table<avx2::Vec<T>>(),
+                avx512::make_table<avx512::Vec<T>>(),
+#else
+                scalar::make_table<scalar::Vec<T>>(),
+                scalar::make_table<scalar::Vec<T>>(),
+#endif
+            };
+            return tables[int(simd_isa())];
+        }
+        else
+        {
+            static const ProxKernelTable<T> table = scalar::make_table<scalar::Vec<T>>();
+            return table;
+        }
+    }
+
+    template <typename T>
+    OPTIM_INLINE void soft_threshold(const T *x, T *y, Index n, T t)
+    {
+        kernels<T>().soft_threshold(x, y, n, t);
+    }
+
+    template <typename T>
+    OPTIM_INLINE void elastic_net(const T *x, T *y, Index n, T t, T s)
+    {
+        kernels<T>().elastic_net(x, y, n, t, s);
+    }
+
+    template <typename T>
+    OPTIM_INLINE void clamp(const T *x, T *y, Index n, T lo, T hi)
+    {
+        kernels<T>().clamp(x, y, n, lo, hi);
+    }
+
+    template <typename T>
+    OPTIM_INLINE void clamp(const T *x, const T *lo, const T *hi, T *y, Index n)
+    {
+        kernels<T>().clamp_vec(x, lo, hi, y, n);
+    }
+
+    template <typename T>
+    OPTIM_INLINE T squared_norm(const T *x, Index n)
+    {
+        return kernels<T>().squared_norm(x, n);
+    }
+
+    template <typename T>
+    OPTIM_INLINE void scale(const T *x, T *y, Index n, T a)
+    {
+        kernels<T>().scale(x, y, n, a);
+    }
+}
+
+#endif
@@ -0,0 +1,113 @@
+// bodies of the elementwise proximal kernels. Included once per instruction
+// set, inside its namespace, with V the vector traits of that set and
+// OPTIM_SIMD_FN its target attribute. The tail is done in scalar code with
+// the same formulas, so results do not depend on n.
+/// @cond
+template <typename V>
+OPTIM_SIMD_FN void soft_threshold(
+    const typename V::scalar *x, typename V::scalar *y,
+    Index n, typename V::scalar t)
+{ // y = x - clamp(x, -t, t)
+    const auto hi = V::set1(t), lo = V::set1(-t);
+    Index i = 0;
+    for (; i + V::width <= n; i += V::width)
+    {
+        const auto v = V::load(x + i);
+        V::store(y + i, V::sub(v, V::min(V::max(v, lo), hi)));
+    }
+    for (; i < n; i++)
+        y[i] = x[i] - std::min(std::max(x[i], -t), t);
+}
+
+template <typename V>
+OPTIM_SIMD_FN void elastic_net(
+    const typename V::scalar *x, typename V::scalar *y,
+    Index n, typename V::scalar t, typename V::scalar s)
+{ // y = s * (x - clamp(x, -t, t))
+    const auto hi = V::set1(t), lo = V::set1(-t), vs = V::set1(s);
+    Index i = 0;
+    for (; i + V::width <= n; i += V::width)
+    {
+        const auto v = V::load(x + i);
+        V::store(y + i, V::mul(vs, V::sub(v, V::min(V::max(v, lo), hi))));
+    }
+    for (; i < n; i++)
+        y[i] = s * (x[i] - std::min(std::max(x[i], -t), t));
+}
+
+template <typename V>
+OPTIM_SIMD_FN void clamp(
+    const typename V::scalar *x, typename V::scalar *y,
+    Index n, typename V::scalar lo, typename V::scalar hi)
+{
+    const auto vlo = V::set1(lo), vhi = V::set1(hi);
+    Index i = 0;
+    for (; i + V::width <= n; i += V::width)
+        V::store(y + i, V::min(V::max(V::load(x + i), vlo), vhi));
+    for (; i < n; i++)
+        y[i] = std::min(std::max(x[i], lo), hi);
+}
+
+template <typename V>
+OPTIM_SIMD_FN void clamp_vec(
+    const typename V::scalar *x,
+    const typename V::scalar *lo, const typename V::scalar *hi,
+    typename V::scalar *y, Index n)
+{
+    Index i = 0;
+    for (; i + V::width <= n; i += V::width)
+        V::store(y + i, V::min(V::max(V::load(x + i), V::load(lo + i)),
+                               V::load(hi + i)));
+    for (; i < n; i++)
+        y[i] = std::min(std::max(x[i], lo[i]), hi[i]);
+}
+
+template <typename V>
+OPTIM_SIMD_FN typename V::scalar squared_norm(
+    const typename V::scalar *x, Index n)
+{ // four accumulators to hide the add latency
+    auto acc0 = V::set1(0), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    Index i = 0;
+    for (; i + 4 * V::width <= n; i += 4 * V::width)
+    {
+        const auto v0 = V::load(x + i),
+                   v1 = V::load(x + i + V::width),
+                   v2 = V::load(x + i + 2 * V::width),
+                   v3 = V::load(x + i + 3 * V::width);
+        acc0 = V::add(acc0, V::mul(v0, v0));
+        acc1 = V::add(acc1, V::mul(v1, v1));
+        acc2 = V::add(acc2, V::mul(v2, v2));
+        acc3 = V::add(acc3, V::mul(v3, v3));
+    }
+    for (; i + V::width <= n; i += V::width)
+    {
+        const auto v = V::load(x + i);
+        acc0 = V::add(acc0, V::mul(v, v));
+    }
+    typename V::scalar sum = V::reduce(V::add(V::add(acc0, acc1), V::add(acc2, acc3)));
+    for (; i < n; i++)
+        sum += x[i] * x[i];
+    return sum;
+}
+
+template <typename V>
+OPTIM_SIMD_FN void scale(
+    const typename V::scalar *x, typename V::scalar *y,
+    Index n, typename V::scalar a)
+{
+    const auto va = V::set1(a);
+    Index i = 0;
+    for (; i + V::width <= n; i += V::width)
+        V::store(y + i, V::mul(va, V::load(x + i)));
+    for (; i < n; i++)
+        y[i] = a * x[i];
+}
+
+template <typename V>
+ProxKernelTable<typename V::scalar> make_table()
+{
+    return {&soft_threshold<V>, &elastic_net<V>,
+            &clamp<V>, &clamp_vec<V>,
+            &squared_norm<V>, &scale<V>};
+}
+/// @endcond
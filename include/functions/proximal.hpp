@@ -12,53 +12,77 @@ void prox(fp_t step, const Mat<fp_t> &in_x, Mat<fp_t> &out)
                 m = BMO_COLS(in_x);
     BMO_RESIZE(out, n, m);
     if constexpr (p == 1)
-    {
-        for (Index i = 0, size = n * m; i < size; i++)
-        {
-            if (in_x(i) > step)
-                out(i) = in_x(i) - step;
-            else if (in_x(i) < -step)
-                out(i) = in_x(i) + step;
-            else
-                out(i) = 0;
-        }
-    }
+        kernel::soft_threshold(BMO_GET_DATA(in_x), BMO_GET_DATA(out), n * m, step);
     else if constexpr (p == 2)
     {
-        const fp_t nrm = BMO_FRO_NORM(in_x);
+        const fp_t nrm = std::sqrt(kernel::squared_norm(BMO_GET_DATA(in_x), n * m));
         if (nrm > step)
-            out = (1 - step / nrm) * in_x;
+            kernel::scale(BMO_GET_DATA(in_x), BMO_GET_DATA(out), n * m, 1 - step / nrm);
         else
             BMO_SET_ZERO(out);
     }
     else if constexpr (p == -1)
-    {
-        out = BMO_ABS(in_x) / step;
-        fp_t *begin = BMO_GET_DATA(out),
-             *end = begin + n * m,
-             sum, lambda, slice;
-        // projection into the L1 ball
-        sum = BMO_SUM(out);
-        if (sum <= fp_t(1))
+    { // infinity norm, by Moreau: x - projection of x onto the L1 ball of radius step
+        if (BMO_SUM(BMO_ABS(in_x)) <= step)
         { // in the L1 ball
             BMO_SET_ZERO(out);
             return;
         }
-        else
-            sum = fp_t(0);
-        std::sort(begin, end);
-        while (sum < fp_t(1) && end >= begin)
-            sum += *end--;
-        slice = *(end + 1);
-        lambda = slice - (fp_t(1) - (sum - slice));
-        for (Index i = 0; i < n * m; i++)
-        {
-            if (in_x(i) > lambda)
-                out(i) = lambda * step;
-            else if (in_x(i) < -lambda)
-                out(i) = -lambda * step;
-            else
-                out(i) = in_x(i);
-        }
+        const fp_t tau = simplex_threshold<true, false>(
+            BMO_GET_DATA(in_x), (const fp_t *)nullptr, n * m, step);
+        kernel::clamp(BMO_GET_DATA(in_x), BMO_GET_DATA(out), n * m, -tau, tau);
     }
+}
+
+/// @brief proximal operator of the elastic net step * (|x|_1 + l2 / 2 * |x|_2^2)
+/// @tparam fp_t floating-point type
+/// @param step step size
+/// @param l2 weight of the squared L2 norm relative to the L1 norm
+/// @param in_x input x
+/// @param out output, soft_threshold(in_x, step) / (1 + step * l2)
+template <typename fp_t>
+void prox_elastic_net(fp_t step, fp_t l2, const Mat<fp_t> &in_x, Mat<fp_t> &out)
+{
+    optim_assert(step > 0, "step must be positive.");
+    optim_assert(l2 >= 0, "l2 must be non-negative.");
+    const Index n = BMO_ROWS(in_x),
+                m = BMO_COLS(in_x);
+    BMO_RESIZE(out, n, m);
+    kernel::elastic_net(BMO_GET_DATA(in_x), BMO_GET_DATA(out), n * m,
+                        step, 1 / (1 + step * l2));
+}
+
+/// @brief projection onto the box [lower, upper], the proximal operator of its indicator
+/// @tparam fp_t floating-point type
+/// @param lower lower bound of every entry
+/// @param upper upper bound of every entry
+/// @param in_x input x
+/// @param out output
+template <typename fp_t>
+void prox_box(fp_t lower, fp_t upper, const Mat<fp_t> &in_x, Mat<fp_t> &out)
+{
+    optim_assert(lower <= upper, "lower must not exceed upper.");
+    const Index n = BMO_ROWS(in_x),
+                m = BMO_COLS(in_x);
+    BMO_RESIZE(out, n, m);
+    kernel::clamp(BMO_GET_DATA(in_x), BMO_GET_DATA(out), n * m, lower, upper);
+}
+
+/// @brief projection onto the box [lower, upper] with entrywise bounds
+/// @tparam fp_t floating-point type
+/// @param lower lower bounds, same shape as in_x
+/// @param upper upper bounds, same shape as in_x
+/// @param in_x input x
+/// @param out output
+template <typename fp_t>
+void prox_box(const Mat<fp_t> &lower, const Mat<fp_t> &upper,
+              const Mat<fp_t> &in_x, Mat<fp_t> &out)
+{
+    const Index n = BMO_ROWS(in_x),
+                m = BMO_COLS(in_x);
+    optim_assert(BMO_SIZE(lower) == n * m && BMO_SIZE(upper) == n * m,
+                 "bounds must have the shape of x.");
+    BMO_RESIZE(out, n, m);
+    kernel::clamp(BMO_GET_DATA(in_x), BMO_GET_DATA(lower), BMO_GET_DATA(upper),
+                  BMO_GET_DATA(out), n * m);
 }
\ No newline at end of file
@@ -5,29 +5,40 @@
 
 namespace optim
 {
-    template <typename fp_t, bool use_prox = false>
+    template <typename fp_t, bool use_prox = false,
+              typename P = ProxWrapper<fp_t, GradProblem, use_prox>>
     struct ArmijoLineSearch final
-        : public LineSearch<fp_t, use_prox>
+        : public LineSearch<fp_t, use_prox, P>
     {
-        using Problem = typename LineSearch<fp_t, use_prox>::Problem;
-        using Args = LineSearchArgs<fp_t, use_prox>;
+        using Problem = typename LineSearch<fp_t, use_prox, P>::Problem;
+        using Args = typename LineSearch<fp_t, use_prox, P>::Args;
 
         int max_iter = 10;
-        fp_t armijo_c = 0.95;
-        fp_t decay_rate = 0.1;
+        fp_t armijo_c = 1e-4; ///< sufficient decrease parameter
+        fp_t decay_rate = 0.1; ///< factor a rejected step is shrunk by with Backtracking::Fixed, and with Interpolation when the model has no minimum
+        Backtracking backtracking = Backtracking::Interpolation; ///< the step then shrinks into [a / 1000, a / 2], the default used to be Fixed
 
+    private:
+        int ls_iter = 0; ///< trial of the resumable search
+        fp_t dTg = 0;    ///< directional derivative at prev_x, of the last trial with prox
+        internal::Backtrack<fp_t> backtrack;
+
+    public:
         void line_search(Args &arg)
         {
             optim_assert(arg.step > 0, "step must be positive.");
+            internal::instrument::Timer timer(internal::instrument::Phase::LineSearch);
+            internal::trace::Span trace("Armijo");
             int iter = 0;
-            fp_t dTg;
+            backtrack.reset();
             for (iter = 1; iter <= max_iter; iter++)
             {
-                arg.step_forward(this->prob);
-                arg.update_cur_loss(this->prob);
+                internal::trace::Span trace_trial("ls_trial");
+                arg.step_forward(this->prob.get());
+                arg.update_cur_loss(this->prob.get());
                 if constexpr (use_prox)
                 {
-                    arg.update_prev_grad_map(this->prob);
+                    arg.update_prev_grad_map(this->prob.get());
                     arg.tmp = arg.cur_x - arg.prev_x;
                     dTg = BMO_MAT_DOT_PROD(
                               arg.tmp, arg.prev_grad_map) /
@@ -36,19 +47,48 @@ namespace optim
                 else
                     dTg = BMO_MAT_DOT_PROD(arg.direction, arg.prev_grad);
                 optim_assert(dTg < 0, "dTg must be negtive.");
-                if (arg.cur_loss <= arg.prev_loss + arg.step * dTg ||
+                if (arg.cur_loss <= arg.prev_loss + armijo_c * arg.step * dTg ||
                     arg.step == this->min_step)
                     goto over;
-                arg.step *= decay_rate;
+                arg.step = backtrack.next(backtracking, decay_rate,
+                                          arg.prev_loss, dTg, arg.step, arg.cur_loss);
                 // force step larger than min_step
                 if (arg.step < this->min_step)
                     arg.step = this->min_step;
             }
             arg.step = this->min_step;
-            arg.step_forward(this->prob);
-            arg.update_cur_loss(this->prob);
+            arg.step_forward(this->prob.get());
+            arg.update_cur_loss(this->prob.get());
         over:
-            arg.update_cur_grad(this->prob);
+            internal::instrument::ls_trials(iter);
+            if (this->update_cur_grad)
+                arg.update_cur_grad(this->prob.get());
+        }
+
+        void start(Args &arg) override
+        {
+            optim_assert(arg.step > 0, "step must be positive.");
+            ls_iter = 1;
+            backtrack.reset();
+            dTg = BMO_MAT_DOT_PROD(arg.direction, arg.prev_grad);
+            optim_assert(dTg < 0, "dTg must be negtive.");
+            arg.step_forward(this->prob.get());
+        }
+
+        bool tell(Args &arg) override
+        {
+            if (ls_iter > max_iter || // evaluated at min_step after max_iter trials
+                arg.cur_loss <= arg.prev_loss + armijo_c * arg.step * dTg ||
+                arg.step == this->min_step)
+                return true;
+            if (++ls_iter > max_iter)
+                arg.step = this->min_step;
+            else // force step larger than min_step
+                arg.step = std::max(backtrack.next(backtracking, decay_rate,
+                                                   arg.prev_loss, dTg, arg.step, arg.cur_loss),
+                                    this->min_step);
+            arg.step_forward(this->prob.get());
+            return false;
         }
     };
 
@@ -0,0 +1,385 @@
+#pragma once
+#ifndef _OPTIM_HAGER_ZHANG_HPP_
+#define _OPTIM_HAGER_ZHANG_HPP_
+
+#include "base.hpp"
+
+namespace optim
+{
+    /// @brief Hager-Zhang line search, the one of CG_DESCENT
+    /// @details find a step \f$ \alpha \f$ that satisfies the Wolfe conditions \f$ \phi(\alpha) - \phi(0) \leq \delta \alpha \phi'(0) \f$ and \f$ \phi'(\alpha) \geq \sigma \phi'(0) \f$, where \f$ \phi(\alpha) = f(x_k + \alpha d) \f$, or the approximate Wolfe conditions \f$ (2\delta - 1) \phi'(0) \geq \phi'(\alpha) \geq \sigma \phi'(0) \f$ and \f$ \phi(\alpha) \leq \phi(0) + \epsilon C_k \f$. Only the derivative enters the approximate conditions, so they still tell descent apart near the minimum, where the loss decrease is lost in rounding errors. They are used once \f$ |f(x_k) - f(x_{k-1})| \leq \omega C_k \f$, \f$ C_k \f$ being an average of \f$ |f| \f$ over the past iterations. The step is bracketed by growing it, then the bracket is shrunk by double secant steps, with a bisection when they shrink it less than `gamma`. \f$ \phi(0) \f$ and \f$ \phi'(0) \f$ come from the previous point without evaluation and the loss and gradient are evaluated together at every trial point, so the gradient at the accepted point is always updated. With low-memory arguments the lowest point is not kept but evaluated again if the search fails. W. W. Hager and H. Zhang, "A new conjugate gradient method with guaranteed descent and an efficient line search", SIAM J. Optim. 16 (2005).
+    /// @tparam fp_t floating-point type
+    /// @tparam use_prox whether to use proximal operator, \f$ \phi'(\alpha) \f$ is then taken along the gradient map as in MTLineSearch
+    template <typename fp_t = double,
+              bool use_prox = false,
+              typename P = ProxWrapper<fp_t, GradProblem, use_prox>>
+    class HZLineSearch final
+        : public LineSearch<fp_t, use_prox, P>
+    {
+    public:
+        using Problem = typename LineSearch<fp_t, use_prox, P>::Problem;
+        using Constant = OptimConst<fp_t>;
+        using Args = typename LineSearch<fp_t, use_prox, P>::Args;
+
+    private:
+        int iter = 0;
+
+    public:
+        int max_iter = 20;         ///< max trial points of line search
+        fp_t delta = 0.1;          ///< sufficient decrease parameter, in (0, 0.5)
+        fp_t sigma = 0.9;          ///< curvature parameter, in [delta, 1)
+        fp_t epsilon = 1e-6;       ///< loss tolerance of the approximate Wolfe conditions, relative to \f$ C_k \f$
+        fp_t omega = 1e-3;         ///< switch to the approximate Wolfe conditions once the loss changes less than omega \f$ C_k \f$
+        fp_t Delta = 0.7;          ///< decay of the average \f$ C_k \f$
+        fp_t theta = 0.5;          ///< position of the bisection point in the bracket
+        fp_t gamma = 0.66;         ///< bisect if a double secant step keeps more than gamma of the bracket
+        fp_t rho = 5;              ///< growth of the step while bracketing
+        bool approx_wolfe = true;  ///< whether to use the approximate Wolfe conditions at all
+
+    private:
+        int status = 0;
+
+        struct Point
+        {
+            fp_t a, f, g; ///< step, loss and directional derivative
+        };
+
+        /// @brief what the trial point in arg.step is for
+        enum class Stage
+        {
+            Bracket,  ///< growing the step until the minimum is bracketed
+            Secant,   ///< first secant step of the bracket
+            Secant2,  ///< second secant step, from the side the first one moved
+            Midpoint, ///< the double secant step did not shrink the bracket enough
+            Bisect,   ///< restoring the bracket conditions at the upper end
+            Fallback  ///< the minimum step, after the search failed
+        };
+
+        Stage stage = Stage::Bracket,
+              after = Stage::Secant; ///< where a bisection returns to, Secant for a new double secant step, Secant2 for the shrink check
+        Point p0{0, 0, 0}, lo{0, 0, 0}, hi{0, 0, 0}, lo_old{0, 0, 0}, hi_old{0, 0, 0}, best{0, 0, 0};
+        fp_t width = 0; ///< bracket width before the double secant step
+        fp_t eps_k = 0; ///< epsilon C_k
+        fp_t Q = 0, C = 0, f_last = Constant::inf;
+        bool use_approx = false;
+
+        typename Args::MatType best_x, best_grad, best_gmap; ///< lowest point found so far
+
+        /// @brief whether arg keeps no previous point, the lowest point is then evaluated again if the search fails
+        static bool low_memory(const Args &arg)
+        {
+            if constexpr (use_prox)
+                return false;
+            else
+                return arg.low_memory;
+        }
+
+        void resize_buffers(const typename Args::MatType &x)
+        {
+            const Index n = BMO_ROWS(x),
+                        m = BMO_COLS(x);
+            BMO_RESIZE(best_x, n, m);
+            BMO_RESIZE(best_grad, n, m);
+            if constexpr (use_prox)
+                BMO_RESIZE(best_gmap, n, m);
+        }
+
+        bool wolfe(const Point &t) const
+        {
+            if (t.g < sigma * p0.g)
+                return false;
+            if (t.f - p0.f <= delta * t.a * p0.g)
+                return true;
+            return use_approx && t.f <= p0.f + eps_k &&
+                   t.g <= (2 * delta - 1) * p0.g;
+        }
+
+        /// @brief the loss at t is low enough to keep t as the lower end
+        bool low(const Point &t) const { return t.f <= p0.f + eps_k; }
+
+        static fp_t secant(const Point &a, const Point &b)
+        {
+            return (a.a * b.g - b.a * a.g) / (b.g - a.g);
+        }
+
+        /// @brief ask for the loss at step c of the bracket, fails once the bracket is down to rounding errors
+        bool trial(Stage s, fp_t c, fp_t &next)
+        {
+            if (hi.a - lo.a <= Constant::eps * hi.a)
+                return false;
+            stage = s, next = c;
+            return true;
+        }
+
+        /// @brief start a double secant step
+        bool secant2(fp_t &next)
+        {
+            width = hi.a - lo.a;
+            lo_old = lo, hi_old = hi;
+            const fp_t c = secant(lo, hi);
+            if (c > lo.a && c < hi.a)
+                return trial(Stage::Secant, c, next);
+            return trial(Stage::Midpoint, (lo.a + hi.a) / 2, next);
+        }
+
+        /// @brief after a double secant step, bisect if it did not shrink the bracket enough
+        bool shrink(fp_t &next)
+        {
+            if (hi.a - lo.a > gamma * width)
+                return trial(Stage::Midpoint, (lo.a + hi.a) / 2, next);
+            return secant2(next);
+        }
+
+        bool bisect(fp_t &next)
+        {
+            return trial(Stage::Bisect, (1 - theta) * lo.a + theta * hi.a, next);
+        }
+
+        /// @brief replace an end of the bracket by t, false if t breaks it and a bisection in [lo, t] is needed
+        bool update(const Point &t)
+        {
+            if (t.g >= 0)
+                hi = t;
+            else if (low(t))
+                lo = t;
+            else
+            {
+                hi = t;
+                return false;
+            }
+            return true;
+        }
+
+        /// @brief take the trial point t and choose the next one
+        /// @return false if the search can not go on
+        bool advance(const Point &t, fp_t &next)
+        {
+            switch (stage)
+            {
+            case Stage::Bracket:
+                if (t.g >= 0)
+                {
+                    hi = t;
+                    return secant2(next);
+                }
+                if (!low(t))
+                {
+                    hi = t, after = Stage::Secant;
+                    return bisect(next);
+                }
+                lo = t;
+                if (t.a >= this->max_step)
+                    return false;
+                next = std::min(rho * t.a, this->max_step);
+                return true;
+            case Stage::Secant:
+            {
+                if (!update(t))
+                {
+                    after = Stage::Secant2;
+                    return bisect(next);
+                }
+                const fp_t c = hi.a == t.a ? secant(hi_old, hi) : secant(lo_old, lo);
+                if (c > lo.a && c < hi.a)
+                    return trial(Stage::Secant2, c, next);
+                return shrink(next);
+            }
+            case Stage::Secant2:
+                if (!update(t))
+                {
+                    after = Stage::Secant2;
+                    return bisect(next);
+                }
+                return shrink(next);
+            case Stage::Midpoint:
+                if (!update(t))
+                {
+                    after = Stage::Secant;
+                    return bisect(next);
+                }
+                return secant2(next);
+            case Stage::Bisect:
+                if (t.g < 0)
+                {
+                    (low(t) ? lo : hi) = t;
+                    return bisect(next);
+                }
+                hi = t;
+                return after == Stage::Secant ? secant2(next) : shrink(next);
+            default:
+                return false;
+            }
+        }
+
+        /// @brief set up the search from the previous point, without evaluation
+        void begin(Args &arg)
+        {
+            using std::abs;
+            arg.step = std::max(
+                std::min(arg.step, this->max_step),
+                this->min_step);
+            iter = 0, status = 0;
+            p0 = Point{0, arg.prev_loss, 0};
+            if constexpr (!use_prox)
+            {
+                p0.g = BMO_MAT_DOT_PROD(arg.prev_grad, arg.direction);
+                optim_assert(p0.g < 0, "g_0 must be negtive.");
+            }
+            // running average of |f|, once the loss stalls compared to it
+            // only the approximate conditions can tell descent apart
+            Q = 1 + Q * Delta;
+            C += (abs(p0.f) - C) / Q;
+            use_approx = approx_wolfe &&
+                         (use_approx || abs(p0.f - f_last) <= omega * C);
+            f_last = p0.f;
+            eps_k = epsilon * C;
+            stage = Stage::Bracket;
+            lo = best = p0;
+        }
+
+        /// @brief directional derivative at the trial point in arg
+        fp_t derivative(Args &arg)
+        {
+            if constexpr (use_prox)
+            {
+                arg.tmp = arg.cur_x - arg.prev_x;
+                if (iter == 0)
+                {
+                    p0.g = BMO_MAT_DOT_PROD(arg.prev_grad_map, arg.tmp) /
+                           arg.step;
+                    optim_assert(p0.g < 0, "g_0 must be negtive.");
+                    lo.g = best.g = p0.g; // begin() copied p0 before its slope was known
+                }
+                return BMO_MAT_DOT_PROD(arg.cur_grad_map, arg.tmp) /
+                       arg.step;
+            }
+            else
+                return BMO_MAT_DOT_PROD(arg.cur_grad, arg.direction);
+        }
+
+        /// @brief take the lowest point found if it decreases the loss, otherwise ask for the minimum step
+        /// @return true if the search is over
+        bool fail(Args &arg)
+        {
+            status = 1;
+            logger.warn("[HZLS] failed after {} trials, bracket [{:g}, {:g}].", iter, lo.a, hi.a);
+            if (best.a > 0 && low_memory(arg))
+            {
+                stage = Stage::Fallback;
+                arg.step = best.a;
+                arg.step_forward(this->prob.get());
+                return false;
+            }
+            if (best.a > 0)
+            {
+                arg.step = best.a;
+                arg.cur_loss = best.f;
+                BMO_SWAP(arg.cur_x, best_x);
+                BMO_SWAP(arg.cur_grad, best_grad);
+                if constexpr (use_prox)
+                    BMO_SWAP(arg.cur_grad_map, best_gmap);
+                return true;
+            }
+            stage = Stage::Fallback;
+            arg.step = this->min_step;
+            arg.step_forward(this->prob.get());
+            return false;
+        }
+
+        /// @brief take the loss and gradient at the trial point
+        /// @return true if the search is over, otherwise arg.cur_x is the next trial point
+        bool next_trial(Args &arg)
+        {
+            const Point t{arg.step, arg.cur_loss, derivative(arg)};
+            iter++;
+            if (stage == Stage::Fallback || wolfe(t))
+                return true;
+            logger.trace("[HZLS] iter: {:<3d} | step: {:<10g} | f: {:<12g} | g: {:<10g} | bracket: [{:g}, {:g}]",
+                         iter, t.a, t.f - p0.f, t.g, lo.a, hi.a);
+            if (t.f < best.f && low_memory(arg))
+                best = t;
+            else if (t.f < best.f)
+            { // keep the lowest point in case the search fails
+                best = t;
+                BMO_SWAP(arg.cur_x, best_x);
+                BMO_SWAP(arg.cur_grad, best_grad);
+                if constexpr (use_prox)
+                    BMO_SWAP(arg.cur_grad_map, best_gmap);
+            }
+            fp_t next = 0;
+            if (iter >= max_iter || !advance(t, next))
+                return fail(arg);
+            arg.step = next;
+            arg.step_forward(this->prob.get());
+            return false;
+        }
+
+    public:
+        void init(
+            std::shared_ptr<Problem> p, Args &arg) override
+        {
+            this->prob = p;
+            Q = C = 0;
+            f_last = Constant::inf;
+            use_approx = false;
+            if (!low_memory(arg))
+                resize_buffers(arg.cur_x);
+            else
+            {
+                BMO_RESIZE(best_x, 0, 0);
+                BMO_RESIZE(best_grad, 0, 0);
+            }
+        }
+
+        void line_search(Args &arg) override
+        {
+            optim_assert(arg.step > 0, "step must be positive.");
+            internal::instrument::Timer timer(internal::instrument::Phase::LineSearch);
+            internal::trace::Span trace("HZLS");
+            begin(arg);
+            arg.step_forward(this->prob.get());
+            for (;;)
+            {
+                internal::trace::Span trace_trial("ls_trial");
+                arg.update_cur_loss_grad(this->prob.get());
+                if constexpr (use_prox)
+                {
+                    if (iter == 0)
+                        arg.update_prev_grad_map(this->prob.get());
+                    arg.update_cur_grad_map(this->prob.get());
+                }
+                if (next_trial(arg))
+                    break;
+            }
+            internal::instrument::ls_trials(iter);
+        }
+
+        void start(Args &arg) override
+        {
+            optim_assert(arg.step > 0, "step must be positive.");
+            begin(arg);
+            arg.step_forward(this->prob.get());
+        }
+
+        bool tell(Args &arg) override
+        {
+            return next_trial(arg);
+        }
+
+        bool success() const override
+        {
+            return status == 0;
+        }
+
+        int n_iter() const
+        {
+            return iter;
+        }
+    };
+
+    template <typename fp_t = double, bool use_prox = false,
+              typename P = ProxWrapper<fp_t, GradProblem, use_prox>>
+    using HZLS = HZLineSearch<fp_t, use_prox, P>;
+}
+
+#endif
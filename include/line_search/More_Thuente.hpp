@@ -12,16 +12,17 @@ namespace optim
     /// @tparam fp_t floating-point type
     /// @tparam use_prox whether to use proximal operator
     template <typename fp_t = double,
-              bool use_prox = false>
+              bool use_prox = false,
+              typename P = ProxWrapper<fp_t, GradProblem, use_prox>>
     class MTLineSearch final
-        : public LineSearch<fp_t, use_prox>
+        : public LineSearch<fp_t, use_prox, P>
     {
         friend class BaseSolver<fp_t>;
 
     public:
-        using Problem = typename LineSearch<fp_t>::Problem;
+        using Problem = typename LineSearch<fp_t, use_prox, P>::Problem;
         using Constant = OptimConst<fp_t>;
-        using Args = LineSearchArgs<fp_t, use_prox>;
+        using Args = typename LineSearch<fp_t, use_prox, P>::Args;
 
     private:
         int iter = 0;
@@ -34,6 +35,18 @@ namespace optim
     private:
         int status = 0; // wether ls success
 
+        typename Args::MatType best_x, best_grad, best_gmap; ///< best point found so far
+
+        void resize_buffers(const typename Args::MatType &x)
+        {
+            const Index n = BMO_ROWS(x),
+                        m = BMO_COLS(x);
+            BMO_RESIZE(best_x, n, m);
+            BMO_RESIZE(best_grad, n, m);
+            if constexpr (use_prox)
+                BMO_RESIZE(best_gmap, n, m);
+        }
+
     private:
         bool check_wolfe_condition(
             fp_t step,
@@ -45,21 +58,183 @@ namespace optim
                    (abs(g_t) <= wolfe_c2 * abs(g_0));
         };
 
-    public:
-        /// @brief More-Thuente line search Algorithm implementation for efficiently invoke by taking less computing on f(x0),\f$\nabla f(x0)\f$
-        void line_search(Args &arg) override
+    private:
+        using FuncVal = internal::MTLineSearch::FuncVal<fp_t, use_prox>;
+
+        // state of the search, kept between the trials
+        fp_t g_0 = 0, g_test = 0; ///< derivative at the previous point, and wolfe_c1 * g_0
+        bool use_auxiliary = true, brackt = false;
+        fp_t step_min = 0, step_max = 0, width = 0, width_old = 0;
+        FuncVal a_l{0, 0, 0}, a_t{0, 0, 0}, a_u{0, 0, 0}; ///< best step, last trial step, other endpoint
+
+        /// @brief check the first trial point and set up the interval of uncertainty if it fails
+        /// @param g_t derivative at the first trial point
+        /// @return true if the first trial point satisfies the Wolfe conditions
+        bool begin(Args &arg, fp_t g_t)
+        {
+            optim_assert(g_0 < 0, "g_0 must be negtive.");
+            if (check_wolfe_condition(
+                    arg.step, arg.prev_loss, g_0, arg.cur_loss, g_t))
+            {
+                status = 0;
+                return true;
+            }
+            use_auxiliary = 1, brackt = 0;
+            step_max = arg.step * 10,
+            step_min = this->min_step;
+            width = this->max_step - this->min_step,
+            width_old = 2. * width;
+            a_l = FuncVal(0, arg.prev_loss, g_0);
+            a_t = FuncVal(arg.step, arg.cur_loss, g_t);
+            a_u = FuncVal(0, arg.prev_loss, g_0);
+            // a_l starts at the previous point
+            resize_buffers(arg.cur_x);
+            best_x = arg.prev_x;
+            best_grad = arg.prev_grad;
+            if constexpr (use_prox)
+                best_gmap = arg.prev_grad_map;
+            g_test = wolfe_c1 * g_0; // gtest in origin code
+            logger.info("[MTLS] start line-search.");
+            return false;
+        }
+
+        /// @brief update the interval with the last trial step and select the next one in arg.step
+        /// @return true if the search is over, status tells how
+        bool next_trial(Args &arg)
         {
             using std::abs;
             using std::max;
             using std::min;
             using namespace internal::MTLineSearch;
+            if (use_auxiliary)
+            {
+                a_l.phi_to_psi(g_test);
+                a_t.phi_to_psi(g_test);
+                a_u.phi_to_psi(g_test);
+                arg.step = select_trial_value<fp_t>(
+                    brackt, a_l, a_u, a_t, step_min, step_max);
+                // Reset the function and derivative values for f.
+                a_l.psi_to_phi(g_test);
+                a_t.psi_to_phi(g_test);
+                a_u.psi_to_phi(g_test);
+            }
+            else
+                arg.step = select_trial_value(
+                    brackt, a_l, a_u, a_t, step_min, step_max);
+            // Force the step to be within the bounds
+            arg.step = std::min(std::max(arg.step, this->min_step), this->max_step);
+            // ----------------- Updating Method -----------------
+            if (a_t.val > a_l.val)
+                // case U1 & a
+                a_u.swap(a_t); // shrink interval
+            else
+            {
+                if (std::signbit(a_t.deriv) !=
+                    std::signbit(a_l.deriv))
+                    // a_t and a_l should be endpoints
+                    a_u.swap(a_l);
+                a_l.swap(a_t); // case U2 & b
+                BMO_SWAP(best_x, arg.cur_x);
+                BMO_SWAP(best_grad, arg.cur_grad);
+                if constexpr (use_prox)
+                    BMO_SWAP(best_gmap, arg.cur_grad_map);
+            }
+            if (check_wolfe_condition(
+                    a_l.arg, arg.prev_loss, g_0, a_l.val, a_l.deriv))
+            { // that's what we want!
+                status = 0;
+                return true;
+            }
+            // update the 'interval of uncertainty'
+            if (brackt)
+            {
+                if (abs(a_u.arg - a_l.arg) > 0.66 * width_old)
+                    // Decide if a bisection step is needed.
+                    arg.step = (a_l.arg + a_u.arg) / 2;
+                width_old = width;
+                width = abs(a_u.arg - a_l.arg);
+                if (step_max < Constant::sqrt_eps)
+                    OPTIM_UNLIKELY
+                    { // minimal is too close to origin point!
+                        optim_assert(a_l.val <= arg.prev_loss,
+                                     "f_t should be less than f_0. Please check your loss and grad func.");
+                        status = -1;
+                        return true;
+                    }
+                step_max = max(a_l.arg, a_u.arg);
+                step_min = min(a_l.arg, a_u.arg);
+                if ((arg.step > step_max || arg.step < step_min) ||
+                    step_max - step_min <= 1e-4 * step_max) [[unlikely]]
+                    arg.step = (step_max + step_min) / 2;
+            }
+            else
+            { // step too small, expand interval.
+                step_min = arg.step + 1.1 * (arg.step - a_l.arg);
+                step_max = arg.step + 5.0 * (arg.step - a_l.arg);
+            }
+            // log
+            if (iter % 10 == 0)
+            {
+                logger.info("[MTLS] iter: {:<3d}  brackt:{:<5}  use_auxilary: {:<5}\nstep_min: {:<10g} | a_l: {:<10g} | a_t: {:<10g} | a_u: {:<10g} | step_max: {:<10g}", iter, brackt, use_auxiliary, step_min, a_l.arg, a_t.arg, a_u.arg, step_max);
+            }
+            else
+            {
+                // f_t <= f_0 + step * wolfe_c1 * g_0
+                logger.trace("[MTLS] iter: {:<3d}  brackt:{:<5}  use_auxilary: {:<5}\n| a_l: {:<10g} | a_t: {:<10g} | a_u: {:<10g} |\n| f_l: {:<10g} | f_t: {:<10g} | f_u: {:<10g} |\n| g_l: {:<10g} | g_t: {:<10g} | g_u: {:<10g} |", iter, brackt, use_auxiliary, a_l.arg, a_t.arg, a_u.arg, a_l.val, a_t.val, a_u.val, a_l.deriv, a_t.deriv, a_u.deriv);
+            }
+            return false;
+        }
+
+        /// @brief switch to the "Modified Updating Method" once the last trial step gives psi(a_t) <= 0 and phi'(a_t) >= 0
+        void check_auxiliary(const Args &arg)
+        {
+            if (use_auxiliary &&
+                a_t.val <= arg.prev_loss + g_test && // psi(a_t) <= 0
+                a_t.deriv >= 0)                      // phi'(a_t) >= 0
+                use_auxiliary = 0;
+        }
+
+        void fail(const Args &arg)
+        {
+            status = 1;
+            logger.warn("[MTLS] reaches max_iter: {}.", max_iter);
+            optim_assert(a_l.val <= arg.prev_loss,
+                         "cur_loss should be less than prev_loss. Please check your loss, grad func.");
+        }
+
+        /// @brief move the best point found to the current point
+        void finish(Args &arg)
+        {
+            arg.step = a_l.arg;
+            arg.cur_loss = a_l.val;
+            BMO_SWAP(arg.cur_x, best_x);
+            BMO_SWAP(arg.cur_grad, best_grad);
+            if constexpr (use_prox)
+                BMO_SWAP(arg.prev_grad_map, best_gmap);
+        }
+
+    public:
+        void init(
+            std::shared_ptr<Problem> p, Args &arg) override
+        {
+            if constexpr (!use_prox)
+                if (arg.low_memory)
+                    throw std::invalid_argument("MTLS keeps points of its own, use HZLS with low-memory arguments.");
+            this->prob = p;
+            resize_buffers(arg.cur_x);
+        }
+
+        /// @brief More-Thuente line search Algorithm implementation for efficiently invoke by taking less computing on f(x0),\f$\nabla f(x0)\f$
+        void line_search(Args &arg) override
+        {
             optim_assert(arg.step > 0, "step must be positive.");
-            iter = 0;      // reset iter
-            fp_t g_0, g_t; // = grad_0.T * d;
+            internal::instrument::Timer timer(internal::instrument::Phase::LineSearch);
+            internal::trace::Span trace("MTLS");
+            iter = 0; // reset iter
+            fp_t g_t; // = grad_t.T * d;
             // check wolfe condition
             arg.step_forward(this->prob.get());
-            arg.update_cur_loss(this->prob.get());
-            arg.update_cur_grad(this->prob.get());
+            arg.update_cur_loss_grad(this->prob.get());
             // update subgradient if needed
             if constexpr (use_prox)
             {
@@ -76,123 +251,55 @@ namespace optim
                 g_0 = BMO_MAT_DOT_PROD(arg.prev_grad, arg.direction);
                 g_t = BMO_MAT_DOT_PROD(arg.cur_grad, arg.direction);
             }
-            optim_assert(g_0 < 0, "g_0 must be negtive.");
-            if (check_wolfe_condition(
-                    arg.step, arg.prev_loss, g_0, arg.cur_loss, g_t))
+            if (begin(arg, g_t))
+            {
+                internal::instrument::ls_trials(1);
                 return;
-            bool use_auxiliary = 1, brackt = 0;
-            fp_t step_max = arg.step * 10,
-                 step_min = this->min_step;
-            fp_t width = this->max_step - this->min_step,
-                 width_old = 2. * width;
-            FuncVal<fp_t, use_prox>
-                a_l(0, arg.prev_loss, g_0),
-                a_t(arg.step, arg.cur_loss, g_t),
-                a_u(0, arg.prev_loss, g_0);
-            const int n = BMO_ROWS(arg.cur_x),
-                      m = BMO_COLS(arg.cur_x);
-            Mat<fp_t> best_x(n, m), best_grad(n, m), best_gmap;
-            if constexpr (use_prox)
-                BMO_RESIZE(best_gmap, n, m);
-            g_t = wolfe_c1 * g_0; // gtest in origin code
-            logger.info("[MTLS] start line-search.");
+            }
             for (iter = 1; iter <= max_iter; iter++)
             {
-                if (use_auxiliary)
-                {
-                    a_l.phi_to_psi(g_t);
-                    a_t.phi_to_psi(g_t);
-                    a_u.phi_to_psi(g_t);
-                    arg.step = select_trial_value<fp_t>(
-                        brackt, a_l, a_u, a_t, step_min, step_max);
-                    // Reset the function and derivative values for f.
-                    a_l.psi_to_phi(g_t);
-                    a_t.psi_to_phi(g_t);
-                    a_u.psi_to_phi(g_t);
-                }
-                else
-                    arg.step = select_trial_value(
-                        brackt, a_l, a_u, a_t, step_min, step_max);
-                // Force the step to be within the bounds
-                arg.step = std::min(std::max(arg.step, this->min_step), this->max_step);
-                // ----------------- Updating Method -----------------
-                if (a_t.val > a_l.val)
-                    // case U1 & a
-                    a_u.swap(a_t); // shrink interval
-                else
-                {
-                    if (std::signbit(a_t.deriv) !=
-                        std::signbit(a_l.deriv))
-                        // a_t and a_l should be endpoints
-                        a_u.swap(a_l);
-                    a_l.swap(a_t); // case U2 & b
-                    BMO_SWAP(best_x, arg.cur_x);
-                    BMO_SWAP(best_grad, arg.cur_grad);
-                    if constexpr (use_prox)
-                        best_gmap = std::move(arg.cur_grad_map);
-                }
-                if (check_wolfe_condition(
-                        a_l.arg, arg.prev_loss, g_0, a_l.val, a_l.deriv))
-                { // that's what we want!
-                    status = 0;
+                internal::trace::Span trace_trial("ls_trial");
+                if (next_trial(arg))
                     goto over;
-                }
-                // update the 'interval of uncertainty'
-                if (brackt)
-                {
-                    if (abs(a_u.arg - a_l.arg) > 0.66 * width_old)
-                        // Decide if a bisection step is needed.
-                        arg.step = (a_l.arg + a_u.arg) / 2;
-                    width_old = width;
-                    width = abs(a_u.arg - a_l.arg);
-                    if (step_max < Constant::sqrt_eps)
-                        OPTIM_UNLIKELY
-                        { // minimal is too close to origin point!
-                            optim_assert(a_l.val <= arg.prev_loss,
-                                         "f_t should be less than f_0. Please check your loss and grad func.");
-                            status = -1;
-                            goto over;
-                        }
-                    step_max = max(a_l.arg, a_u.arg);
-                    step_min = min(a_l.arg, a_u.arg);
-                    if ((arg.step > step_max || arg.step < step_min) ||
-                        step_max - step_min <= 1e-4 * step_max) [[unlikely]]
-                        arg.step = (step_max + step_min) / 2;
-                }
-                else
-                { // step too small, expand interval.
-                    step_min = arg.step + 1.1 * (arg.step - a_l.arg);
-                    step_max = arg.step + 5.0 * (arg.step - a_l.arg);
-                }
-                // log
-                if (iter % 10 == 0)
-                {
-                    logger.info("[MTLS] iter: {:<3d}  brackt:{:<5}  use_auxilary: {:<5}\nstep_min: {:<10g} | a_l: {:<10g} | a_t: {:<10g} | a_u: {:<10g} | step_max: {:<10g}", iter, brackt, use_auxiliary, step_min, a_l.arg, a_t.arg, a_u.arg, step_max);
-                }
-                else
-                {
-                    // f_t <= f_0 + step * wolfe_c1 * g_0
-                    logger.trace("[MTLS] iter: {:<3d}  brackt:{:<5}  use_auxilary: {:<5}\n| a_l: {:<10g} | a_t: {:<10g} | a_u: {:<10g} |\n| f_l: {:<10g} | f_t: {:<10g} | f_u: {:<10g} |\n| g_l: {:<10g} | g_t: {:<10g} | g_u: {:<10g} |", iter, brackt, use_auxiliary, a_l.arg, a_t.arg, a_u.arg, a_l.val, a_t.val, a_u.val, a_l.deriv, a_t.deriv, a_u.deriv);
-                }
                 // compute new step
                 a_t.update_val(this->prob.get(), arg);
-                // check if switch to "Modified Updating Method"
-                if (use_auxiliary &&
-                    a_t.val <= arg.prev_loss + g_t && // psi(a_t) <= 0
-                    a_t.deriv >= 0)                   // phi'(a_t) >= 0
-                    use_auxiliary = 0;
+                check_auxiliary(arg);
             }
-            status = 1;
-            logger.warn("[MTLS] reaches max_iter: {}.", max_iter);
-            optim_assert(a_l.val <= arg.prev_loss,
-                         "cur_loss should be less than prev_loss. Please check your loss, grad func.");
+            fail(arg);
         over:
-            arg.step = a_l.arg;
-            arg.cur_loss = a_l.val;
-            arg.cur_x = std::move(best_x);
-            arg.cur_grad = std::move(best_grad);
-            if constexpr (use_prox)
-                arg.prev_grad_map = std::move(best_gmap);
+            internal::instrument::ls_trials(iter); // the first trial and one per update_val
+            finish(arg);
+        }
+
+        void start(Args &arg) override
+        {
+            optim_assert(arg.step > 0, "step must be positive.");
+            iter = 0;
+            g_0 = BMO_MAT_DOT_PROD(arg.prev_grad, arg.direction);
+            arg.step_forward(this->prob.get());
+        }
+
+        bool tell(Args &arg) override
+        {
+            if (iter == 0)
+            { // first trial point
+                if (begin(arg, BMO_MAT_DOT_PROD(arg.cur_grad, arg.direction)))
+                    return true;
+            }
+            else
+            {
+                a_t.take_val(arg);
+                check_auxiliary(arg);
+            }
+            if (++iter > max_iter)
+                fail(arg);
+            else if (!next_trial(arg))
+            {
+                arg.step_forward(this->prob.get());
+                return false;
+            }
+            finish(arg);
+            return true;
         }
 
         bool success() const override { return status == 0; }
@@ -200,8 +307,9 @@ namespace optim
         int n_iter() const { return iter; };
     };
 
-    template <typename fp_t = double, bool use_prox = false>
-    using MTLS = MTLineSearch<fp_t, use_prox>;
+    template <typename fp_t = double, bool use_prox = false,
+              typename P = ProxWrapper<fp_t, GradProblem, use_prox>>
+    using MTLS = MTLineSearch<fp_t, use_prox, P>;
 }
 
 #endif
\ No newline at end of file
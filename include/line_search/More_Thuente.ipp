@@ -46,28 +46,32 @@ namespace optim::internal::MTLineSearch
     template <typename fp_t, bool use_prox = false>
     struct FuncVal : public BaseFuncVal<fp_t>
     {
-        using Problem = typename LineSearch<fp_t, use_prox>::Problem;
-
         FuncVal(
             fp_t argument, fp_t value, fp_t derivative)
             : BaseFuncVal<fp_t>(argument, value, derivative){};
 
-        void update_val(
-            Problem *prob,
-            LineSearchArgs<fp_t, use_prox> &arg)
+        template <typename P, typename Args>
+        void update_val(P *prob, Args &arg)
         { // arg update but val and grad not
             arg.step_forward(prob);
-            arg.update_cur_loss(prob);
-            arg.update_cur_grad(prob);
-            this->arg = arg.step;
-            this->val = arg.cur_loss;
+            arg.update_cur_loss_grad(prob);
             if constexpr (use_prox)
             {
                 arg.update_cur_grad_map(prob);
                 arg.tmp = arg.cur_x - arg.prev_x;
+            }
+            take_val(arg);
+        };
+
+        // loss and gradient already evaluated at arg.cur_x
+        template <typename Args>
+        void take_val(const Args &arg)
+        {
+            this->arg = arg.step;
+            this->val = arg.cur_loss;
+            if constexpr (use_prox)
                 this->deriv = BMO_MAT_DOT_PROD(arg.cur_grad_map, arg.direction) /
                               this->arg;
-            }
             else
                 this->deriv = BMO_MAT_DOT_PROD(arg.cur_grad, arg.direction);
         };
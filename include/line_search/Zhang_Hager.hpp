@@ -9,13 +9,14 @@ namespace optim
     /// @brief Zhang-Hager line search
     /// @details find a step \[\alpha_k\] such that \f$ f(x_k + \alpha_k d) \leq C_k + \rho \alpha_k \nabla f(x_k)^T d \f$, where \f$ C_k = \frac{\gamma Q_{k-1}C_{k-1} + f(x_k)}{Q_k} \f$, \f$ Q_k = \gamma Q_{k-1} + 1,\ C_0 = f(x_0) \f$.
     template <typename fp_t = double,
-              bool use_prox = false>
+              bool use_prox = false,
+              typename P = ProxWrapper<fp_t, GradProblem, use_prox>>
     class ZHLineSearch final
-        : public LineSearch<fp_t, use_prox>
+        : public LineSearch<fp_t, use_prox, P>
     {
     public:
-        using Problem = typename LineSearch<fp_t, use_prox>::Problem;
-        using Args = LineSearchArgs<fp_t, use_prox>;
+        using Problem = typename LineSearch<fp_t, use_prox, P>::Problem;
+        using Args = typename LineSearch<fp_t, use_prox, P>::Args;
 
     private:
         int iter = 0;
@@ -25,10 +26,13 @@ namespace optim
         int max_iter = 10; ///< max iter of line search
         fp_t pho = 1e-3;   ///< sufficient decrease parameter in line search
         fp_t gamma = 0.85;
-        fp_t decay_rate = 0.1; ///< decay rate of step length in line search
+        fp_t decay_rate = 0.1; ///< factor a rejected step is shrunk by with Backtracking::Fixed, and with Interpolation when the model has no minimum
+        Backtracking backtracking = Backtracking::Interpolation; ///< the step then shrinks into [a / 1000, a / 2], the default used to be Fixed
 
     private:
         int status = 0;
+        fp_t dTg = 0; ///< d.dot(g) in sm prob, or (cur_x - prev_x) / step .dot(g_grad_map) of the last trial in nsm prob
+        internal::Backtrack<fp_t> backtrack;
 
     public:
         void init(
@@ -42,15 +46,18 @@ namespace optim
         void line_search(Args &arg) override
         {
             optim_assert(arg.step > 0, "step must be positive.");
+            internal::instrument::Timer timer(internal::instrument::Phase::LineSearch);
+            internal::trace::Span trace("ZHLS");
             arg.step = std::max(
                 std::min(arg.step, this->max_step),
                 this->min_step);
             iter = 0; // reset iter
-            fp_t dTg; // d.dot(g) in sm prob or
-            // or (cur_x - prev_x) / step .dot(g_grad_map) in nsm prob
+            status = 0;
+            backtrack.reset();
             // begin line search
             for (iter = 1; iter <= max_iter; iter++)
             {
+                internal::trace::Span trace_trial("ls_trial");
                 arg.step_forward(this->prob.get());
                 arg.update_cur_loss(this->prob.get());
                 if constexpr (use_prox)
@@ -72,17 +79,20 @@ namespace optim
                     Cval = (gamma * pQ * Cval + arg.cur_loss) / Q;
                     goto over;
                 }
-                arg.step *= decay_rate;
+                arg.step = backtrack.next(backtracking, decay_rate,
+                                          arg.prev_loss, dTg, arg.step, arg.cur_loss);
                 // force step larger than min_step
                 if (arg.step < this->min_step)
                     arg.step = this->min_step;
             }
             // if line search failed, use the min step
             // and give a warning(TODO)
+            status = 1;
             arg.step = this->min_step;
             arg.step_forward(this->prob.get());
             arg.update_cur_loss(this->prob.get());
         over:
+            internal::instrument::ls_trials(iter);
             if (this->update_cur_grad)
             {
                 arg.update_cur_grad(this->prob.get());
@@ -91,6 +101,44 @@ namespace optim
             }
         };
 
+        void start(Args &arg) override
+        {
+            optim_assert(arg.step > 0, "step must be positive.");
+            arg.step = std::max(
+                std::min(arg.step, this->max_step),
+                this->min_step);
+            iter = 1;
+            status = 0;
+            backtrack.reset();
+            dTg = BMO_MAT_DOT_PROD(arg.direction, arg.prev_grad);
+            optim_assert(dTg < 0, "dTg must be negtive.");
+            arg.step_forward(this->prob.get());
+        }
+
+        bool tell(Args &arg) override
+        {
+            if (iter > max_iter) // evaluated at min_step after max_iter trials
+                return true;
+            if (arg.cur_loss <= Cval + pho * arg.step * dTg ||
+                arg.step == this->min_step)
+            {
+                pQ = Q, Q = gamma * Q + 1;
+                Cval = (gamma * pQ * Cval + arg.cur_loss) / Q;
+                return true;
+            }
+            if (++iter > max_iter)
+            { // failed as in line_search(), use the min step
+                status = 1;
+                arg.step = this->min_step;
+            }
+            else // force step larger than min_step
+                arg.step = std::max(backtrack.next(backtracking, decay_rate,
+                                                   arg.prev_loss, dTg, arg.step, arg.cur_loss),
+                                    this->min_step);
+            arg.step_forward(this->prob.get());
+            return false;
+        }
+
         bool success() const override
         {
             return status == 0;
@@ -102,8 +150,9 @@ namespace optim
         }
     };
 
-    template <typename fp_t = double, bool use_prox = false>
-    using ZHLS = ZHLineSearch<fp_t, use_prox>;
+    template <typename fp_t = double, bool use_prox = false,
+              typename P = ProxWrapper<fp_t, GradProblem, use_prox>>
+    using ZHLS = ZHLineSearch<fp_t, use_prox, P>;
 }
 
 // #ifdef OPTIM_HEADER_ONLY
@@ -3,6 +3,7 @@
 #define _OPTIM_LINE_SEARCH_BASE_HPP__
 
 #include "base/BaseSolver.hpp"
+#include "misc/malloc_guard.hpp"
 
 
 namespace optim
@@ -11,42 +12,68 @@ namespace optim
     /// @anchor ddd
     /// @brief Base class for line search arguments
     /// @tparam fp_t floating-point type
-    template <typename fp_t>
+    /// @tparam N number of rows of x if fixed at compile time
+    /// @tparam K number of columns of x if fixed at compile time
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
     struct BaseLineSearchArgs
     {
+        using MatType = Mat<fp_t, N, K>; ///< type of the points and gradients
+
         fp_t step; ///< step size
 
         fp_t prev_loss; ///< previous loss
         fp_t cur_loss;  ///< current loss
 
-        Mat<fp_t> direction; ///< step direction
+        MatType direction; ///< step direction
+
+        MatType prev_x; ///< previous point
+        MatType cur_x;  ///< current point
 
-        Mat<fp_t> prev_x; ///< previous point
-        Mat<fp_t> cur_x;  ///< current point
+        MatType prev_grad; ///< previous gradient
+        MatType cur_grad;  ///< current gradient
 
-        Mat<fp_t> prev_grad; ///< previous gradient
-        Mat<fp_t> cur_grad;  ///< current gradient
+        /// @brief cur_grad is the gradient at cur_x
+        /// @details set when the gradient is evaluated and cleared when cur_x moves, code writing cur_x itself must clear it.
+        bool cur_grad_fresh = false;
     };
 
     /// @cond
-    template <typename fp_t, bool use_prox>
+    template <typename fp_t, bool use_prox, int N = Dynamic, int K = Dynamic>
     struct LineSearchArgs;
     /// @endcond
 
     /// @brief Line search arguments
     /// @tparam fp_t floating-point type
-    template <typename fp_t>
-    struct LineSearchArgs<fp_t, false> final
-        : public BaseLineSearchArgs<fp_t>
+    template <typename fp_t, int N, int K>
+    struct LineSearchArgs<fp_t, false, N, K> final
+        : public BaseLineSearchArgs<fp_t, N, K>
     {
-        using Problem = GradProblem<fp_t>;
+        using Problem = GradProblem<fp_t, N, K>;
+        using MatType = Mat<fp_t, N, K>;
+
+        /// @brief no prev_x is kept and cur_x moves in place, see init_low_memory()
+        bool low_memory = false;
+
+    private:
+        fp_t x_step = 0; ///< step cur_x is at in low-memory mode
+
+    public:
+        LineSearchArgs() = default;
 
         /// @brief  malloc the memory for the line search arguments and assign x to the current point
         /// @param x initial point
-        LineSearchArgs(Mat<fp_t> &x)
+        LineSearchArgs(const MatType &x) { init(x); }
+
+        /// @brief size the buffers like x and assign x to the current point
+        /// @details memory is only reallocated when the shape of x changes, so a workspace can be reused across solve() calls.
+        /// @param x initial point
+        void init(const MatType &x)
         {
             const Index n = BMO_ROWS(x),
                         m = BMO_COLS(x);
+            low_memory = false;
+            this->cur_grad_fresh = false;
+            BMO_RESIZE(this->cur_x, n, m);
             this->cur_x = x;
             BMO_RESIZE(this->prev_x, n, m);
             BMO_RESIZE(this->prev_grad, n, m);
@@ -54,25 +81,73 @@ namespace optim
             BMO_RESIZE(this->direction, n, m);
         }
 
+        /// @brief take x over as the current point and keep no previous point
+        /// @details x is swapped into cur_x, so the caller's point is the only copy, and swapped back by release_low_memory(). prev_x is freed and step_forward() moves cur_x in place by the difference of the steps, so the workspace holds x, the two gradients and the direction. Only line searches that keep no points of their own support it, MTLineSearch does not.
+        /// @param x initial point, empty until release_low_memory()
+        void init_low_memory(MatType &x)
+        {
+            const Index n = BMO_ROWS(x),
+                        m = BMO_COLS(x);
+            low_memory = true;
+            this->cur_grad_fresh = false;
+            x_step = 0;
+            BMO_SWAP(this->cur_x, x);
+            BMO_RESIZE(this->prev_x, 0, 0);
+            BMO_RESIZE(this->prev_grad, n, m);
+            BMO_RESIZE(this->cur_grad, n, m);
+            BMO_RESIZE(this->direction, n, m);
+        }
+
+        /// @brief hand the current point back to the x given to init_low_memory()
+        void release_low_memory(MatType &x)
+        {
+            BMO_SWAP(this->cur_x, x);
+        }
+
         /// @brief Step forward to the next point
-        OPTIM_STRONG_INLINE
-        void step_forward(Problem *)
+        template <typename P>
+        OPTIM_STRONG_INLINE void step_forward(P *)
         {
-            this->cur_x = this->prev_x + this->step * this->direction;
+            this->cur_grad_fresh = false;
+            if (low_memory)
+            {
+                this->cur_x += (this->step - x_step) * this->direction;
+                x_step = this->step;
+            }
+            else
+                this->cur_x = this->prev_x + this->step * this->direction;
         }
 
         /// @brief Update the current loss
-        OPTIM_STRONG_INLINE
-        void update_cur_loss(Problem *prob)
+        template <typename P>
+        OPTIM_STRONG_INLINE void update_cur_loss(P *prob)
         {
+            internal::instrument::count(internal::instrument::Eval::Loss);
+            internal::trace::Span trace("loss");
+            internal::AllowMallocScope allow_malloc;
             this->cur_loss = prob->loss(this->cur_x);
         }
 
         /// @brief Update the current gradient
-        OPTIM_STRONG_INLINE
-        void update_cur_grad(Problem *prob)
+        template <typename P>
+        OPTIM_STRONG_INLINE void update_cur_grad(P *prob)
         {
+            internal::instrument::count(internal::instrument::Eval::Grad);
+            internal::trace::Span trace("grad");
+            internal::AllowMallocScope allow_malloc;
             prob->grad(this->cur_x, this->cur_grad);
+            this->cur_grad_fresh = true;
+        }
+
+        /// @brief Update the current loss and gradient in one evaluation
+        template <typename P>
+        OPTIM_STRONG_INLINE void update_cur_loss_grad(P *prob)
+        {
+            internal::instrument::count(internal::instrument::Eval::LossGrad);
+            internal::trace::Span trace("loss_grad");
+            internal::AllowMallocScope allow_malloc;
+            this->cur_loss = prob->loss_and_grad(this->cur_x, this->cur_grad);
+            this->cur_grad_fresh = true;
         }
 
         /// @brief norm of the current gradient
@@ -86,20 +161,25 @@ namespace optim
         OPTIM_STRONG_INLINE
         void flush()
         {
-            BMO_SWAP(this->prev_x, this->cur_x);
+            if (low_memory)
+                x_step = 0; // the current point is the start of the next search
+            else
+                BMO_SWAP(this->prev_x, this->cur_x);
+            this->cur_grad_fresh = false;
             BMO_SWAP(this->prev_grad, this->cur_grad);
             this->prev_loss = this->cur_loss;
         }
     };
 
-    template <typename fp_t>
-    struct LineSearchArgs<fp_t, true> final
-        : public BaseLineSearchArgs<fp_t>
+    template <typename fp_t, int N, int K>
+    struct LineSearchArgs<fp_t, true, N, K> final
+        : public BaseLineSearchArgs<fp_t, N, K>
     {
-        using Problem = internal::ProxOperator<fp_t, GradProblem>;
+        using Problem = internal::ProxOperator<fp_t, GradProblem, N, K>;
+        using MatType = Mat<fp_t, N, K>;
 
-        Mat<fp_t> prev_grad_map; ///< previous gradient mapping
-        Mat<fp_t> cur_grad_map;  ///< current gradient mapping
+        MatType prev_grad_map; ///< previous gradient mapping
+        MatType cur_grad_map;  ///< current gradient mapping
 
         fp_t prev_sm_loss;  ///< previous smooth loss
         fp_t prev_nsm_loss; ///< previous non-smooth loss
@@ -107,15 +187,24 @@ namespace optim
         fp_t cur_sm_loss;  ///< current smooth loss
         fp_t cur_nsm_loss; ///< current non-smooth loss
 
-        Mat<fp_t> tmp; ///< storage tmp value
+        MatType tmp; ///< storage tmp value
 
     public:
+        LineSearchArgs() = default;
+
         /// @brief malloc the memory for the line search arguments and assign x to the current point
         /// @param x initial point
-        LineSearchArgs(Mat<fp_t> &x)
+        LineSearchArgs(const MatType &x) { init(x); }
+
+        /// @brief size the buffers like x and assign x to the current point
+        /// @details memory is only reallocated when the shape of x changes, so a workspace can be reused across solve() calls.
+        /// @param x initial point
+        void init(const MatType &x)
         {
             const Index n = BMO_ROWS(x),
                         m = BMO_COLS(x);
+            this->cur_grad_fresh = false;
+            BMO_RESIZE(this->cur_x, n, m);
             this->cur_x = x;
             BMO_RESIZE(this->prev_x, n, m);
             BMO_RESIZE(this->prev_grad, n, m);
@@ -127,47 +216,86 @@ namespace optim
         }
 
         /// @brief  Step forward to the next point
+        template <typename P>
         OPTIM_STRONG_INLINE void
-        step_forward(Problem *prob)
+        step_forward(P *prob)
         {
+            this->cur_grad_fresh = false;
             this->cur_x = this->prev_x + this->step * this->direction;
+            internal::instrument::count(internal::instrument::Eval::Prox);
+            internal::trace::Span trace("prox");
+            internal::instrument::Timer timer(internal::instrument::Phase::Prox);
+            internal::AllowMallocScope allow_malloc;
             prob->prox(this->step, this->cur_x, tmp);
             BMO_SWAP(this->cur_x, tmp);
         }
 
         /// @brief Update the current loss
+        template <typename P>
         OPTIM_STRONG_INLINE void
-        update_cur_loss(Problem *prob)
+        update_cur_loss(P *prob)
         {
+            internal::instrument::count(internal::instrument::Eval::Loss);
+            internal::trace::Span trace("loss");
+            internal::AllowMallocScope allow_malloc;
             cur_sm_loss = prob->sm_loss(this->cur_x);
             cur_nsm_loss = prob->nsm_loss(this->cur_x);
             this->cur_loss = cur_sm_loss + cur_nsm_loss;
         }
 
         /// @brief Update the current gradient
+        template <typename P>
         OPTIM_STRONG_INLINE void
-        update_cur_grad(Problem *prob)
+        update_cur_grad(P *prob)
         {
+            internal::instrument::count(internal::instrument::Eval::Grad);
+            internal::trace::Span trace("grad");
+            internal::AllowMallocScope allow_malloc;
             prob->grad(this->cur_x, this->cur_grad);
+            this->cur_grad_fresh = true;
             // this->cur_grad_map = this->cur_x - this->cur_grad;
             // prob->prox(1, this->cur_grad_map, this->tmp);
             // this->cur_grad_map = (this->cur_x - this->tmp) / this->step;
         }
 
+        /// @brief Update the current loss and (smooth part) gradient in one evaluation
+        template <typename P>
+        OPTIM_STRONG_INLINE void
+        update_cur_loss_grad(P *prob)
+        {
+            internal::instrument::count(internal::instrument::Eval::LossGrad);
+            internal::trace::Span trace("loss_grad");
+            internal::AllowMallocScope allow_malloc;
+            cur_sm_loss = prob->sm_loss_and_grad(this->cur_x, this->cur_grad);
+            cur_nsm_loss = prob->nsm_loss(this->cur_x);
+            this->cur_loss = cur_sm_loss + cur_nsm_loss;
+            this->cur_grad_fresh = true;
+        }
+
         /// @brief Update the previous gradient mapping
+        template <typename P>
         OPTIM_STRONG_INLINE void
-        update_prev_grad_map(Problem *prob)
+        update_prev_grad_map(P *prob)
         {
             this->prev_grad_map = this->prev_x - this->step * this->prev_grad;
+            internal::instrument::count(internal::instrument::Eval::Prox);
+            internal::trace::Span trace("prox");
+            internal::instrument::Timer timer(internal::instrument::Phase::Prox);
+            internal::AllowMallocScope allow_malloc;
             prob->prox(this->step, this->prev_grad_map, this->tmp);
             this->prev_grad_map = (this->prev_x - this->tmp) / this->step;
         }
 
         /// @brief Update the current gradient mapping
+        template <typename P>
         OPTIM_STRONG_INLINE void
-        update_cur_grad_map(Problem *prob)
+        update_cur_grad_map(P *prob)
         {
             cur_grad_map = this->cur_x - this->step * this->cur_grad;
+            internal::instrument::count(internal::instrument::Eval::Prox);
+            internal::trace::Span trace("prox");
+            internal::instrument::Timer timer(internal::instrument::Phase::Prox);
+            internal::AllowMallocScope allow_malloc;
             prob->prox(this->step, cur_grad_map, tmp);
             cur_grad_map = (this->cur_x - tmp) / this->step;
         }
@@ -186,23 +314,88 @@ namespace optim
             BMO_SWAP(this->prev_x, this->cur_x);
             BMO_SWAP(this->prev_grad, this->cur_grad);
             BMO_SWAP(prev_grad_map, cur_grad_map);
+            this->cur_grad_fresh = false;
             prev_sm_loss = cur_sm_loss;
             prev_nsm_loss = cur_nsm_loss;
             this->prev_loss = this->cur_loss;
         }
     };
 
+    /// @brief how a backtracking line search shrinks a rejected step
+    enum class Backtracking
+    {
+        Fixed,        ///< multiply the step by `decay_rate`
+        Interpolation ///< minimize a quadratic, then cubic, model of the loss along the direction
+    };
+
+    /// @cond
+    namespace internal
+    {
+        /// @brief next step of a backtracking line search, from the trial losses seen so far
+        /// @details the first rejected step is replaced by the minimizer of the quadratic through \f$ \phi(0), \phi'(0), \phi(\alpha) \f$, the later ones by that of the cubic through the last two trials, see Nocedal and Wright, Numerical Optimization, 3.5. The result is kept in \f$ [\alpha / 1000, \alpha / 2] \f$: a step orders of magnitude too long is cut back in one or two trials, while a poor model can neither stall the search nor collapse the step. It falls back to \f$ \text{decay_rate}\ \alpha \f$ when the model has no minimum or the loss is not finite.
+        template <typename fp_t>
+        class Backtrack
+        {
+            fp_t a_prev = 0, f_prev = 0;
+            bool has_prev = false;
+
+        public:
+            /// @brief forget the trials of the last search
+            void reset() { has_prev = false; }
+
+            /// @param f_0 loss at the start point
+            /// @param g_0 directional derivative at the start point, negative
+            /// @param a rejected step
+            /// @param f_a loss at the rejected step
+            fp_t next(Backtracking policy, fp_t decay_rate,
+                      fp_t f_0, fp_t g_0, fp_t a, fp_t f_a)
+            {
+                using std::sqrt;
+                const fp_t fixed = a * decay_rate;
+                if (policy == Backtracking::Fixed || !std::isfinite(f_a))
+                {
+                    has_prev = false;
+                    return fixed;
+                }
+                const fp_t d_a = f_a - f_0 - g_0 * a; // curvature term of the trial
+                fp_t t = -g_0 * a * a / (2 * d_a);
+                if (has_prev)
+                {
+                    const fp_t d_p = f_prev - f_0 - g_0 * a_prev,
+                               den = a_prev * a_prev * a * a * (a - a_prev),
+                               c3 = (a_prev * a_prev * d_a - a * a * d_p) / den,
+                               c2 = (a * a * a * d_p - a_prev * a_prev * a_prev * d_a) / den,
+                               disc = c2 * c2 - 3 * c3 * g_0;
+                    if (c3 == 0)
+                        t = -g_0 / (2 * c2);
+                    else if (disc >= 0)
+                        t = (-c2 + sqrt(disc)) / (3 * c3);
+                }
+                a_prev = a, f_prev = f_a, has_prev = true;
+                if (std::isnan(t) || t <= 0) // no minimum along the direction
+                    return fixed;
+                return std::min(std::max(t, a / 1000), a / 2);
+            }
+        };
+    }
+    /// @endcond
+
     /// @brief  Line search base class
     /// @details step forward without any line search.
     /// @tparam fp_t floating-point type
     /// @tparam use_prox whether to use proximal operator
-    template <typename fp_t, bool use_prox = false>
+    /// @tparam P problem type the loss and gradient are called through. A concrete (ideally `final`) problem class lets the compiler inline them, see StaticGradientDescent. The arguments take the compile-time size of its points.
+    template <typename fp_t, bool use_prox = false,
+              typename P = ProxWrapper<fp_t, GradProblem, use_prox>>
     struct LineSearch
     {
-        using Problem = ProxWrapper<
-            fp_t, GradProblem, use_prox>;
+        static constexpr int N = P::rows_at_compile_time,
+                             K = P::cols_at_compile_time;
+        static_assert(std::is_base_of_v<ProxWrapper<fp_t, GradProblem, use_prox, N, K>, P>,
+                      "the problem type does not match use_prox");
+        using Problem = P;
         using Constant = OptimConst<fp_t>;
-        using Args = LineSearchArgs<fp_t, use_prox>;
+        using Args = LineSearchArgs<fp_t, use_prox, N, K>;
 
     protected:
         std::shared_ptr<Problem> prob;
@@ -231,20 +424,55 @@ namespace optim
         /// @param arg Line Search arguments
         virtual void line_search(Args &arg)
         {
+            internal::instrument::Timer timer(internal::instrument::Phase::LineSearch);
+            internal::trace::Span trace("line_search");
+            internal::instrument::ls_trials(1);
             arg.step_forward(prob.get());
-            arg.update_cur_loss(prob.get());
-            arg.update_cur_grad(prob.get());
+            if (update_cur_grad)
+                arg.update_cur_loss_grad(prob.get());
+            else
+                arg.update_cur_loss(prob.get());
         }
 
+        /// @brief start a resumable line search
+        /// @details ask/tell counterpart of line_search() for smooth problems whose loss and gradient are evaluated by the caller, see AskTellSolver. Requires the same arguments as line_search() and sets cur_x to the first trial point. The caller then writes the loss and gradient at cur_x to cur_loss and cur_grad and calls tell() until it returns true. `update_cur_grad` is ignored, the gradient comes with every loss.
+        /// @param arg Line Search arguments
+        virtual void start(Args &arg) { arg.step_forward(prob.get()); }
+
+        /// @brief take the loss and gradient at cur_x
+        /// @param arg Line Search arguments with cur_loss and cur_grad evaluated at cur_x
+        /// @return true if the search is over with the accepted point in cur_x, cur_loss and cur_grad, false if cur_x holds the next trial point
+        virtual bool tell(Args &) { return true; }
+
         virtual ~LineSearch() = default;
     };
 
-    template <typename fp_t, bool use_prox = false>
-    struct LSBaseSolver : public BaseSolver<fp_t>
+    template <typename fp_t, bool use_prox = false,
+              int N = Dynamic, int K = Dynamic>
+    struct LSBaseSolver : public BaseSolver<fp_t, N, K>
     {
-        using LineSearchImp = LineSearch<fp_t, use_prox>;
+        using LineSearchImp = LineSearch<
+            fp_t, use_prox, ProxWrapper<fp_t, GradProblem, use_prox, N, K>>;
+        using Workspace = LineSearchArgs<fp_t, use_prox, N, K>;
 
         std::shared_ptr<LineSearchImp> ls;
+
+        /// @brief line search arguments reused across solve() calls
+        /// @details created on the first solve() and only reallocated when the shape of x changes. Solvers that run one after another on same-shaped problems may share one workspace.
+        std::shared_ptr<Workspace> workspace;
+
+        /// @brief free the memory kept for the next solve() call
+        virtual void release() { workspace.reset(); }
+
+    protected:
+        /// @brief get the workspace sized like x with cur_x = x
+        Workspace &prepare_workspace(const Mat<fp_t, N, K> &x)
+        {
+            if (!workspace)
+                workspace = std::make_shared<Workspace>();
+            workspace->init(x);
+            return *workspace;
+        }
     };
 }
 
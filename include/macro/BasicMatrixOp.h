@@ -118,6 +118,13 @@
 #elif defined(BMO_USE_ARMA)
 #define BMO_INIT_MAP_COL(M, X, n) M(X.memptr(), n, false, true)
 #endif
+/*------------------- No alias -------------------*/
+// evaluate a product directly into X without a temporary
+#if defined(BMO_USE_EIGEN)
+#define BMO_NOALIAS(X) (X).noalias()
+#elif defined(BMO_USE_ARMA)
+#define BMO_NOALIAS(X) (X)
+#endif
 /*-------------------  Swap  -------------------*/
 #if defined(BMO_USE_EIGEN)
 #define BMO_SWAP(X, Y) (X).swap(Y)
@@ -133,11 +140,44 @@
 /*------------------ Inverse ------------------*/
 #if defined(BMO_USE_EIGEN)
 #define BMO_LDLT_SOLVE(X, Y) (X).ldlt().solve(Y)
+#define BMO_LU_SOLVE(X, Y) (X).partialPivLu().solve(Y)
 #define BMO_INVERSE(X) (X).inverse()
 #elif defined(BMO_USE_ARMA)
 #define BMO_LDLT_SOLVE(X, Y) arma::solve(X, Y, arma::solve_opts::fast)
+#define BMO_LU_SOLVE(X, Y) arma::solve(X, Y)
 #define BMO_INVERSE(X) arma::inv(X)
 #endif
+/*------------- Symmetric eigendecomposition -------------*/
+// X = V diag(val) V^T, eigenvalues in increasing order
+#if defined(BMO_USE_EIGEN)
+#define BMO_EIG_SYM(val, V, X)                                                \
+    do                                                                        \
+    {                                                                         \
+        Eigen::SelfAdjointEigenSolver<std::decay_t<decltype(X)>> eig_sym_(X); \
+        val = eig_sym_.eigenvalues();                                         \
+        V = eig_sym_.eigenvectors();                                          \
+    } while (0)
+#elif defined(BMO_USE_ARMA)
+#define BMO_EIG_SYM(val, V, X) arma::eig_sym(val, V, X)
+#endif
+/*----------- Symmetric and triangular products -----------*/
+// A symmetric, only its lower triangle is read and written with Eigen.
+// L lower triangular, v a vector updated in place.
+#if defined(BMO_USE_EIGEN)
+#define BMO_SYM_MUL(out, A, v) (out).noalias() = (A).template selfadjointView<Eigen::Lower>() * (v)
+#define BMO_SYM_RANK2_UPDATE(A, u, v) (A).template selfadjointView<Eigen::Lower>().rankUpdate(u, v)
+#define BMO_TRIL_MUL(out, L, v) (out).noalias() = (L).template triangularView<Eigen::Lower>() * (v)
+#define BMO_TRIL_T_MUL(out, L, v) (out).noalias() = (L).transpose().template triangularView<Eigen::Upper>() * (v)
+#define BMO_TRIL_SOLVE(L, v) (L).template triangularView<Eigen::Lower>().solveInPlace(v)
+#define BMO_TRIL_T_SOLVE(L, v) (L).transpose().template triangularView<Eigen::Upper>().solveInPlace(v)
+#elif defined(BMO_USE_ARMA)
+#define BMO_SYM_MUL(out, A, v) (out) = (A) * (v)
+#define BMO_SYM_RANK2_UPDATE(A, u, v) (A) += (u) * (v).t() + (v) * (u).t()
+#define BMO_TRIL_MUL(out, L, v) (out) = arma::trimatl(L) * (v)
+#define BMO_TRIL_T_MUL(out, L, v) (out) = arma::trimatu((L).t()) * (v)
+#define BMO_TRIL_SOLVE(L, v) (v) = arma::solve(arma::trimatl(L), v)
+#define BMO_TRIL_T_SOLVE(L, v) (v) = arma::solve(arma::trimatu((L).t()), v)
+#endif
 /*-------------------- Sum --------------------*/
 #if defined(BMO_USE_EIGEN)
 #define BMO_SUM(X) (X).array().sum()
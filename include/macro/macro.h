@@ -25,6 +25,10 @@
 
 #ifdef OPTIM_USE_EIGEN
 #define BMO_USE_EIGEN
+// debug mode: assert that solvers do not allocate in their main loop
+#if defined(OPTIM_CHECK_NO_MALLOC) && !defined(EIGEN_RUNTIME_NO_MALLOC)
+#define EIGEN_RUNTIME_NO_MALLOC
+#endif
 #include <Eigen/Eigen>
 #elif defined(OPTIM_USE_ARMA)
 #define BMO_USE_ARMA
@@ -37,13 +41,17 @@ namespace optim
 {
 #if defined(OPTIM_USE_EIGEN)
     using Index = Eigen::Index;
-    
-    template <typename fp_t>
-    using Mat = Eigen::Matrix<fp_t, Eigen::Dynamic, Eigen::Dynamic>;
+    /// @brief size known at runtime only
+    constexpr int Dynamic = Eigen::Dynamic;
+
+    /// @brief dense matrix, N x K fixed at compile time if given
+    /// @details fixed sizes live on the stack and their loops are unrolled, for problems with a handful of variables.
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
+    using Mat = Eigen::Matrix<fp_t, N, K>;
     template <typename fp_t>
     using SpMat = Eigen::SparseMatrix<fp_t>;
-    template <typename fp_t>
-    using MapMat = Eigen::Map<Mat<fp_t>>;
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
+    using MapMat = Eigen::Map<Mat<fp_t, N, K>>;
     template <typename fp_t>
     using MapSpMat = Eigen::Map<SpMat<fp_t>>;
 
@@ -66,11 +74,14 @@ namespace optim
     using MapSpRow = Eigen::Map<SpRow<fp_t>>;
 #elif defined(OPTIM_USE_ARMA)
     using Index = arma::uword;
-    template <typename fp_t>
+    constexpr int Dynamic = -1;
+
+    /// @brief dense matrix, the compile-time size is ignored with Armadillo
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
     using Mat = arma::Mat<fp_t>;
     template <typename fp_t>
     using SpMat = arma::SpMat<fp_t>;
-    template <typename fp_t>
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
     using MapMat = arma::Mat<fp_t>;
 
     template <typename fp_t>
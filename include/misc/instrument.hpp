@@ -0,0 +1,174 @@
+#pragma once
+#ifndef _OPTIM_MISC_INSTRUMENT_HPP_
+#define _OPTIM_MISC_INSTRUMENT_HPP_
+
+#include "macro/macro.h"
+
+namespace optim
+{
+    /// @brief evaluation counts and phase times of the last solve()
+    /// @details only filled when `OPTIM_INSTRUMENT` is defined, all zero otherwise. Times are wall-clock seconds. The line-search time includes the evaluations and proximal operators it calls, so the phases overlap. A solver run inside another one, e.g. the subproblem solver of ALM, keeps its own statistics. LevenbergMarquardt counts residuals as losses and Jacobians as gradients, StochasticGradient counts mini-batch gradients.
+    struct SolverStats
+    {
+        long n_loss = 0;          ///< loss evaluations
+        long n_grad = 0;          ///< gradient evaluations
+        long n_loss_grad = 0;     ///< loss and gradient evaluated together
+        long n_prox = 0;          ///< proximal operator calls
+        long n_hess = 0;          ///< Hessian products, solves or assemblies
+        long n_ls_trials = 0;     ///< points tried by the line searches
+        long n_ls_rejected = 0;   ///< trial points not taken as the step
+        double t_direction = 0;   ///< computing search directions
+        double t_line_search = 0; ///< in line searches
+        double t_prox = 0;        ///< in proximal operators
+        double t_check = 0;       ///< checking the stop criteria
+        double t_total = 0;       ///< in solve()
+    };
+}
+
+/// @cond
+namespace optim::internal::instrument
+{
+    enum class Eval
+    {
+        Loss,
+        Grad,
+        LossGrad,
+        Prox,
+        Hess
+    };
+
+    enum class Phase
+    {
+        Direction,
+        LineSearch,
+        Prox,
+        Check
+    };
+
+#if defined(OPTIM_INSTRUMENT)
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief statistics of the solve() running on this thread
+    inline thread_local SolverStats *current = nullptr;
+
+    inline void count(Eval e)
+    {
+        if (!current)
+            return;
+        switch (e)
+        {
+        case Eval::Loss:
+            current->n_loss++;
+            break;
+        case Eval::Grad:
+            current->n_grad++;
+            break;
+        case Eval::LossGrad:
+            current->n_loss_grad++;
+            break;
+        case Eval::Prox:
+            current->n_prox++;
+            break;
+        case Eval::Hess:
+            current->n_hess++;
+            break;
+        }
+    }
+
+    /// @brief a line search tried n points to take one
+    inline void ls_trials(int n)
+    {
+        if (!current)
+            return;
+        current->n_ls_trials += n;
+        current->n_ls_rejected += n - 1;
+    }
+
+    /// @brief adds its lifetime to a phase
+    class Timer
+    {
+        double *t;
+        Clock::time_point t0;
+
+    public:
+        explicit Timer(Phase p)
+        {
+            if (!current)
+            {
+                t = nullptr;
+                return;
+            }
+            switch (p)
+            {
+            case Phase::Direction:
+                t = &current->t_direction;
+                break;
+            case Phase::LineSearch:
+                t = &current->t_line_search;
+                break;
+            case Phase::Prox:
+                t = &current->t_prox;
+                break;
+            case Phase::Check:
+                t = &current->t_check;
+                break;
+            }
+            t0 = Clock::now();
+        }
+
+        ~Timer()
+        {
+            if (t)
+                *t += std::chrono::duration<double>(Clock::now() - t0).count();
+        }
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+    };
+
+    /// @brief resets stats and collects into them for its lifetime
+    class Scope
+    {
+        SolverStats &stats;
+        SolverStats *prev;
+        Clock::time_point t0;
+
+    public:
+        explicit Scope(SolverStats &stats)
+            : stats(stats), prev(current), t0(Clock::now())
+        {
+            stats = SolverStats();
+            current = &stats;
+        }
+
+        ~Scope()
+        {
+            stats.t_total = std::chrono::duration<double>(Clock::now() - t0).count();
+            current = prev;
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+#else
+    inline void count(Eval) {}
+
+    inline void ls_trials(int) {}
+
+    struct Timer
+    {
+        explicit Timer(Phase) {}
+    };
+
+    struct Scope
+    {
+        explicit Scope(SolverStats &) {}
+    };
+
+    static_assert(std::is_empty_v<Timer> && std::is_empty_v<Scope>,
+                  "instrumentation must compile to nothing when disabled");
+#endif
+}
+/// @endcond
+
+#endif
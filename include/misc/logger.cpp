@@ -17,48 +17,63 @@ namespace optim
 
     Logger::Logger()
     {
-        cur_type = LogType::CONSOLE;
-        cur_logger = spdlog::stdout_color_mt("console");
-        cur_logger->set_pattern("[%^%L%$] %v");
-        cur_logger->set_level(spdlog::level::warn);
+        console = spdlog::stdout_color_mt("console");
+        console->set_pattern("[%^%L%$] %v");
+        console->set_level(spdlog::level::warn);
+        use(LogType::CONSOLE, console);
+    }
+
+    void Logger::use(LogType type, std::shared_ptr<spdlog::logger> lg)
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        cur_type = type;
+        if (cur_output && cur_output != lg)
+            outputs.push_back(cur_output);
+        cur_output = lg;
+        cur_logger.store(lg.get());
+        // a thread logging from now on loads lg, the old outputs go once none is left
+        if (n_logging.load() == 0)
+            outputs.clear();
     }
 
     void Logger::write_to_console()
     {
-        cur_type = LogType::CONSOLE;
-        cur_logger = spdlog::stdout_color_mt("console");
+        use(LogType::CONSOLE, console);
     }
 
     void Logger::write_to_file(const char *filename)
     {
-        cur_type = LogType::FILE;
-        cur_logger = spdlog::basic_logger_mt("file_logger", filename);
+        // not registered with spdlog, which would keep it alive and refuse a second file
+        auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(filename);
+        use(LogType::FILE, std::make_shared<spdlog::logger>("file_logger", file_sink));
     }
 
     void Logger::write_to_oss(std::ostream &os)
     {
-        cur_type = LogType::OSTREAM;
         auto ostream_sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(os);
-        cur_logger = std::make_shared<spdlog::logger>("custom_logger", ostream_sink);
+        use(LogType::OSTREAM, std::make_shared<spdlog::logger>("custom_logger", ostream_sink));
     }
 
     void Logger::set_verbosity(int verbosity)
     {
+        std::lock_guard<std::mutex> lk(mtx);
         if (verbosity > 4)
-            cur_logger->set_level(verbosity_to_log_level[4]);
+            cur_output->set_level(verbosity_to_log_level[4]);
         else if (verbosity < 0)
-            cur_logger->set_level(spdlog::level::warn);
+            cur_output->set_level(spdlog::level::warn);
         else
-            cur_logger->set_level(verbosity_to_log_level[verbosity]);
+            cur_output->set_level(verbosity_to_log_level[verbosity]);
     }
 
     void Logger::set_verbosity(const char *level)
     {
-        cur_logger->set_level(spdlog::level::from_str(level));
+        std::lock_guard<std::mutex> lk(mtx);
+        cur_output->set_level(spdlog::level::from_str(level));
     }
 
     void Logger::set_pattern(const char *pattern)
     {
-        cur_logger->set_pattern(pattern);
+        std::lock_guard<std::mutex> lk(mtx);
+        cur_output->set_pattern(pattern);
     }
 }
\ No newline at end of file
@@ -5,13 +5,18 @@
 #define OPTIM_DEFAULT_VERBOSE 2
 
 #include "macro/macro.h"
+#include "misc/malloc_guard.hpp"
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/ostream_sink.h"
 #include "spdlog/sinks/basic_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
+#include <atomic>
+#include <mutex>
 
 namespace optim
 {
+    /// @brief Logger shared by all solvers
+    /// @details safe to call from several threads at once, e.g. solvers running in parallel: messages are written whole, and the output and verbosity may be changed while other threads log. A message below the verbosity is dropped before it is formatted. An output switched away from is freed at the first switch made while no thread is logging.
     class Logger
     {
         std::shared_ptr<spdlog::sinks::basic_file_sink_mt> file_sink;
@@ -25,7 +30,29 @@ namespace optim
         };
 
         LogType cur_type;
-        std::shared_ptr<spdlog::logger> cur_logger;
+        std::mutex mtx; // guards the switch of output
+        // outputs switched away from, kept alive until no thread is logging
+        std::vector<std::shared_ptr<spdlog::logger>> outputs;
+        std::shared_ptr<spdlog::logger> console, cur_output;
+        std::atomic<spdlog::logger *> cur_logger{nullptr};
+        std::atomic<int> n_logging{0}; // threads between loading cur_logger and the end of the message
+
+        void use(LogType type, std::shared_ptr<spdlog::logger> lg);
+
+        template <typename... Args>
+        void log(spdlog::level::level_enum level,
+                 spdlog::format_string_t<Args...> fmt, Args &&...args)
+        {
+            // counted before the load, so use() never frees the logger loaded
+            n_logging.fetch_add(1);
+            spdlog::logger *lg = cur_logger.load();
+            if (lg->should_log(level))
+            {
+                internal::AllowMallocScope allow_malloc;
+                lg->log(level, fmt, std::forward<Args>(args)...);
+            }
+            n_logging.fetch_sub(1, std::memory_order_release);
+        }
 
     public:
         Logger();
@@ -41,37 +68,37 @@ namespace optim
         template <typename... Args>
         void trace(spdlog::format_string_t<Args...> fmt, Args &&...args)
         {
-            cur_logger->log(spdlog::level::trace, fmt, std::forward<Args>(args)...);
+            log(spdlog::level::trace, fmt, std::forward<Args>(args)...);
         }
 
         template <typename... Args>
         void debug(spdlog::format_string_t<Args...> fmt, Args &&...args)
         {
-            cur_logger->log(spdlog::level::debug, fmt, std::forward<Args>(args)...);
+            log(spdlog::level::debug, fmt, std::forward<Args>(args)...);
         }
 
         template <typename... Args>
         void info(spdlog::format_string_t<Args...> fmt, Args &&...args)
         {
-            cur_logger->log(spdlog::level::info, fmt, std::forward<Args>(args)...);
+            log(spdlog::level::info, fmt, std::forward<Args>(args)...);
         }
 
         template <typename... Args>
         void warn(spdlog::format_string_t<Args...> fmt, Args &&...args)
         {
-            cur_logger->log(spdlog::level::warn, fmt, std::forward<Args>(args)...);
+            log(spdlog::level::warn, fmt, std::forward<Args>(args)...);
         }
 
         template <typename... Args>
         void error(spdlog::format_string_t<Args...> fmt, Args &&...args)
         {
-            cur_logger->log(spdlog::level::err, fmt, std::forward<Args>(args)...);
+            log(spdlog::level::err, fmt, std::forward<Args>(args)...);
         }
 
         template <typename... Args>
         void critical(spdlog::format_string_t<Args...> fmt, Args &&...args)
         {
-            cur_logger->log(spdlog::level::critical, fmt, std::forward<Args>(args)...);
+            log(spdlog::level::critical, fmt, std::forward<Args>(args)...);
         }
     };
 
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef _OPTIM_MISC_MALLOC_GUARD_HPP_
+#define _OPTIM_MISC_MALLOC_GUARD_HPP_
+
+#include "macro/macro.h"
+
+/// @cond
+namespace optim::internal
+{
+    /// @brief RAII switch of Eigen's runtime heap allocation check.
+    /// @details Only active when `OPTIM_CHECK_NO_MALLOC` is defined (Eigen backend, assertions enabled). Solvers forbid allocations in their main loop and allow them again around user callbacks, so any allocation made by the solver itself in steady state trips an assertion. Eigen keeps the switch in one process-wide flag, so only check single-threaded runs.
+    template <bool allowed>
+    struct MallocScope
+    {
+#if defined(OPTIM_CHECK_NO_MALLOC) && defined(OPTIM_USE_EIGEN)
+    private:
+        bool prev;
+
+    public:
+        MallocScope()
+        {
+            prev = Eigen::internal::is_malloc_allowed();
+            Eigen::internal::set_is_malloc_allowed(allowed);
+        }
+
+        ~MallocScope()
+        {
+            Eigen::internal::set_is_malloc_allowed(prev);
+        }
+#else
+        MallocScope() {}
+#endif
+        MallocScope(const MallocScope &) = delete;
+        MallocScope &operator=(const MallocScope &) = delete;
+    };
+
+    using NoMallocScope = MallocScope<false>;
+    using AllowMallocScope = MallocScope<true>;
+}
+/// @endcond
+
+#endif
@@ -0,0 +1,197 @@
+#pragma once
+#ifndef _OPTIM_MISC_THREAD_POOL_HPP_
+#define _OPTIM_MISC_THREAD_POOL_HPP_
+
+#include "macro/macro.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace optim
+{
+    /// @brief Work-stealing thread pool for data-parallel loops
+    /// @details Each worker owns a task queue. parallel_for() deals the tasks round-robin, a worker pops from the front of its own queue and steals from the back of the others once it runs dry. The calling thread works on a queue of its own, so a pool with 0 workers runs everything serially on the caller. A parallel_for() called from a task of the same pool, e.g. a FiniteSumProblem solved under a MultiStart sharing its pool, runs serially on the calling thread.
+    class ThreadPool
+    {
+        struct Job
+        {
+            const std::function<void(Index)> *fn;
+            std::atomic<Index> remaining;
+            std::atomic<bool> failed{false};
+            std::exception_ptr error; // first exception thrown by fn, written once failed is set
+        };
+
+        struct Task
+        {
+            Job *job;
+            Index i;
+        };
+
+        struct Queue
+        {
+            std::mutex mtx;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::thread> workers;
+        std::unique_ptr<Queue[]> queues; // one per worker, the last one for the caller
+        std::mutex mtx;
+        std::condition_variable cv_work, cv_done;
+        std::atomic<Index> queued{0};
+        std::mutex run_mtx; // one parallel_for at a time
+        bool stop = false;
+
+        /// @brief the pool whose tasks the calling thread runs, nullptr outside of any
+        static const ThreadPool *&current()
+        {
+            static thread_local const ThreadPool *pool = nullptr;
+            return pool;
+        }
+
+        bool pop(unsigned self, Task &task)
+        {
+            const unsigned n_queue = workers.size() + 1;
+            { // own queue, front
+                Queue &q = queues[self];
+                std::lock_guard<std::mutex> lk(q.mtx);
+                if (!q.tasks.empty())
+                {
+                    task = q.tasks.front();
+                    q.tasks.pop_front();
+                    return true;
+                }
+            }
+            for (unsigned k = 1; k < n_queue; k++)
+            { // steal from the back of the others
+                Queue &q = queues[(self + k) % n_queue];
+                std::lock_guard<std::mutex> lk(q.mtx);
+                if (!q.tasks.empty())
+                {
+                    task = q.tasks.back();
+                    q.tasks.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void drain(unsigned self)
+        {
+            Task task;
+            while (pop(self, task))
+            {
+                queued--;
+                Job &job = *task.job;
+                if (!job.failed.load(std::memory_order_relaxed))
+                    try
+                    {
+                        (*job.fn)(task.i);
+                    }
+                    catch (...)
+                    { // the rest of the job is skipped, parallel_for() rethrows
+                        if (!job.failed.exchange(true))
+                            job.error = std::current_exception();
+                    }
+                // the job may be gone once remaining hits 0
+                if (task.job->remaining.fetch_sub(1) == 1)
+                {
+                    std::lock_guard<std::mutex> lk(mtx);
+                    cv_done.notify_all();
+                }
+            }
+        }
+
+        void work(unsigned self)
+        {
+            current() = this;
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lk(mtx);
+                    cv_work.wait(lk, [this]
+                                 { return stop || queued > 0; });
+                    if (stop)
+                        return;
+                }
+                drain(self);
+            }
+        }
+
+    public:
+        /// @param n_workers number of worker threads besides the caller
+        explicit ThreadPool(
+            unsigned n_workers = std::max(1u, std::thread::hardware_concurrency()) - 1)
+        {
+            queues.reset(new Queue[n_workers + 1]);
+            workers.reserve(n_workers);
+            for (unsigned i = 0; i < n_workers; i++)
+                workers.emplace_back([this, i]
+                                     { work(i); });
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                stop = true;
+            }
+            cv_work.notify_all();
+            for (auto &t : workers)
+                t.join();
+        }
+
+        /// @brief number of threads taking part in parallel_for(), the caller included
+        unsigned size() const { return workers.size() + 1; }
+
+        /// @brief run fn(i) for i in [0, n) and wait for all of them
+        /// @details the order in which tasks run is unspecified, fn must be safe to call concurrently for different i. If fn throws, the tasks not started yet are skipped and the first exception is rethrown once the running ones are done.
+        void parallel_for(Index n, const std::function<void(Index)> &fn)
+        {
+            if (n <= 0)
+                return;
+            // the workers may all be waiting on the task making this call
+            if (workers.empty() || n == 1 || current() == this)
+            {
+                for (Index i = 0; i < n; i++)
+                    fn(i);
+                return;
+            }
+            std::lock_guard<std::mutex> run_lk(run_mtx);
+            Job job;
+            job.fn = &fn;
+            job.remaining = n;
+            const unsigned n_queue = size(), self = n_queue - 1;
+            for (Index i = 0; i < n; i++)
+            {
+                Queue &q = queues[i % n_queue];
+                std::lock_guard<std::mutex> lk(q.mtx);
+                q.tasks.push_back({&job, i});
+            }
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                queued += n;
+            }
+            cv_work.notify_all();
+            const ThreadPool *outer = current();
+            current() = this;
+            drain(self);
+            current() = outer;
+            {
+                std::unique_lock<std::mutex> lk(mtx);
+                cv_done.wait(lk, [&job]
+                             { return job.remaining == 0; });
+            }
+            if (job.error)
+                std::rethrow_exception(job.error);
+        }
+    };
+}
+
+#endif
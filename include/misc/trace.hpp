@@ -0,0 +1,332 @@
+#pragma once
+#ifndef _OPTIM_MISC_TRACE_HPP_
+#define _OPTIM_MISC_TRACE_HPP_
+
+#include "macro/macro.h"
+#include "misc/malloc_guard.hpp"
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#if defined(OPTIM_TRACE) && (defined(__x86_64__) || defined(__i386__))
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+/// @cond
+namespace optim::internal::trace
+{
+    using Clock = std::chrono::steady_clock;
+
+#if defined(OPTIM_TRACE)
+    /// @brief time stamp counter where available, converted to ns when written
+    inline OPTIM_STRONG_INLINE int64_t ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return int64_t(__rdtsc());
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   Clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    /// @brief a span, written as a Chrome trace complete event
+    struct Event
+    {
+        const char *name;
+        int64_t t0, dur; ///< ticks
+    };
+
+    /// @brief events of one thread, written by it and read by the flusher
+    class Ring
+    {
+    public:
+        static constexpr uint64_t capacity = 1 << 14;
+        static constexpr uint64_t high_water = capacity / 2; ///< fill level at which the flusher is woken early
+
+    private:
+        Event buf[capacity];
+        std::atomic<uint64_t> head{0}, tail{0};
+
+    public:
+        const int tid;
+        std::atomic<long> dropped{0}; ///< only written by the producer
+
+        explicit Ring(int tid) : tid(tid) {}
+
+        /// @brief producer side, drops the event if the ring is full
+        /// @return true if the event filled the ring up to the high-water mark
+        OPTIM_STRONG_INLINE bool push(const Event &e)
+        {
+            const uint64_t h = head.load(std::memory_order_relaxed),
+                           used = h - tail.load(std::memory_order_acquire);
+            if (used >= capacity)
+                OPTIM_UNLIKELY
+                {
+                    dropped.store(dropped.load(std::memory_order_relaxed) + 1,
+                                  std::memory_order_relaxed);
+                    return false;
+                }
+            buf[h & (capacity - 1)] = e;
+            head.store(h + 1, std::memory_order_release);
+            return used + 1 == high_water;
+        }
+
+        /// @brief consumer side, hands the pending events to f
+        template <typename F>
+        void drain(F &&f)
+        {
+            const uint64_t h = head.load(std::memory_order_acquire);
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            for (; t != h; t++)
+                f(buf[t & (capacity - 1)]);
+            tail.store(t, std::memory_order_release);
+        }
+    };
+
+    /// @brief rings of all threads and the thread writing them to the file
+    class Sink
+    {
+        std::mutex mtx;
+        std::vector<std::shared_ptr<Ring>> rings;
+        std::thread flusher;
+        std::condition_variable cv;
+        bool stopping = false;
+        std::atomic<bool> wake_up{false}; ///< a ring reached its high-water mark
+        std::FILE *file = nullptr;
+        bool first_event = true;
+        char out[1 << 16]; ///< formatted events not yet written to file
+        size_t n_out = 0;
+
+        void flush_out()
+        {
+            std::fwrite(out, 1, n_out, file);
+            n_out = 0;
+        }
+
+        void put(const char *str, size_t n)
+        {
+            if (n_out + n > sizeof(out))
+                flush_out();
+            std::memcpy(out + n_out, str, n);
+            n_out += n;
+        }
+
+        /// @brief put ns as microseconds with three decimals
+        void put_us(int64_t ns)
+        {
+            char buf[32], *p = buf;
+            if (ns < 0)
+                *p++ = '-', ns = -ns;
+            p = std::to_chars(p, buf + sizeof(buf), ns / 1000).ptr;
+            const int frac = int(ns % 1000);
+            *p++ = '.';
+            *p++ = char('0' + frac / 100);
+            *p++ = char('0' + frac / 10 % 10);
+            *p++ = char('0' + frac % 10);
+            put(buf, p - buf);
+        }
+
+        /// @brief format the event by hand, fprintf would take longer than recording it
+        void write_event(const Event &e, int tid, double ns_per_tick)
+        {
+            static constexpr char name[] = "\n{\"name\":\"", mid[] = "\",\"ph\":\"X\",\"pid\":1,\"tid\":",
+                                  ts[] = ",\"ts\":", dur[] = ",\"dur\":";
+            char buf[16];
+            if (!first_event)
+                put(",", 1);
+            first_event = false;
+            put(name, sizeof(name) - 1);
+            put(e.name, std::strlen(e.name));
+            put(mid, sizeof(mid) - 1);
+            put(buf, std::to_chars(buf, buf + sizeof(buf), tid).ptr - buf);
+            put(ts, sizeof(ts) - 1);
+            put_us(std::llround(double(e.t0 - tick_start) * ns_per_tick));
+            put(dur, sizeof(dur) - 1);
+            put_us(std::llround(double(e.dur) * ns_per_tick));
+            put("}", 1);
+        }
+
+        void write_pending()
+        {
+            std::vector<std::shared_ptr<Ring>> rs;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                rs = rings;
+            }
+            // ticks to ns, measured over the whole trace so far
+            const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t_start).count();
+            const int64_t n_ticks = ticks() - tick_start;
+            const double ns_per_tick = n_ticks > 0 ? ns / double(n_ticks) : 1;
+            for (auto &r : rs)
+                r->drain([&](const Event &e)
+                         { write_event(e, r->tid, ns_per_tick); });
+            flush_out();
+        }
+
+        /// @brief register the calling thread
+        Ring &new_ring()
+        {
+            internal::AllowMallocScope allow_malloc;
+            std::lock_guard<std::mutex> lock(mtx);
+            rings.push_back(std::make_shared<Ring>(int(rings.size())));
+            return *rings.back();
+        }
+
+    public:
+        std::atomic<bool> enabled{false};
+        Clock::time_point t_start;
+        int64_t tick_start = 0;
+
+        /// @brief have the flusher drain the rings now rather than at the end of its period
+        void wake()
+        {
+            wake_up.store(true, std::memory_order_release);
+            cv.notify_one();
+        }
+
+        static Sink &get()
+        {
+            static Sink sink;
+            return sink;
+        }
+
+        /// @brief ring of the calling thread, registered on first use
+        /// @details the sink owns the rings, so the events of a thread that exited are still written.
+        OPTIM_STRONG_INLINE Ring &ring()
+        {
+            thread_local Ring *r = nullptr;
+            if (!r)
+                OPTIM_UNLIKELY r = &new_ring();
+            return *r;
+        }
+
+        bool start(const char *path, std::chrono::milliseconds period)
+        {
+            if (enabled.load())
+                return false;
+            file = std::fopen(path, "w");
+            if (!file)
+                return false;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                for (auto &r : rings) // forget events of an earlier trace
+                    r->drain([](const Event &) {});
+            }
+            std::fputs("{\"traceEvents\":[", file);
+            first_event = true;
+            stopping = false;
+            t_start = Clock::now();
+            tick_start = ticks();
+            enabled.store(true, std::memory_order_release);
+            flusher = std::thread([this, period]
+                                  {
+                std::unique_lock<std::mutex> lock(mtx);
+                while (!stopping)
+                {
+                    cv.wait_for(lock, period, [this]
+                                { return stopping || wake_up.load(std::memory_order_acquire); });
+                    wake_up.store(false, std::memory_order_relaxed);
+                    lock.unlock();
+                    write_pending();
+                    lock.lock();
+                } });
+            return true;
+        }
+
+        long stop()
+        {
+            if (!enabled.load())
+                return 0;
+            enabled.store(false, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            cv.notify_one();
+            flusher.join();
+            write_pending(); // spans closed after the flusher's last pass
+            std::fputs("\n],\"displayTimeUnit\":\"ns\"}\n", file);
+            std::fclose(file);
+            file = nullptr;
+            long dropped = 0;
+            std::lock_guard<std::mutex> lock(mtx);
+            for (auto &r : rings)
+                dropped += r->dropped.exchange(0);
+            return dropped;
+        }
+
+        ~Sink() { stop(); }
+    };
+
+    /// @brief records its lifetime as an event named `name`, which must outlive the trace
+    class Span
+    {
+        const char *name;
+        int64_t t0 = 0;
+
+    public:
+        OPTIM_STRONG_INLINE explicit Span(const char *name)
+            : name(Sink::get().enabled.load(std::memory_order_relaxed) ? name : nullptr)
+        {
+            if (this->name)
+                t0 = ticks();
+        }
+
+        OPTIM_STRONG_INLINE ~Span()
+        {
+            if (name)
+            {
+                Sink &sink = Sink::get();
+                if (sink.ring().push({name, t0, ticks() - t0}))
+                    OPTIM_UNLIKELY sink.wake();
+            }
+        }
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+    };
+#else
+    struct Span
+    {
+        explicit Span(const char *) {}
+    };
+
+    static_assert(std::is_empty_v<Span>, "tracing must compile to nothing when disabled");
+#endif
+}
+/// @endcond
+
+namespace optim::trace
+{
+    /// @brief start writing solver spans to a Chrome trace JSON file
+    /// @details needs `OPTIM_TRACE` to be defined, returns false otherwise, or if a trace is running or the file can not be opened. Every thread records solve() calls, iterations, line-search trials and problem evaluations into its own lock-free ring buffer, and a background thread writes them to `path` every `period`, or as soon as a ring is half full. Events are dropped while a ring is full, see stop(). Open the file in chrome://tracing or ui.perfetto.dev.
+    inline bool start([[maybe_unused]] const char *path,
+                      [[maybe_unused]] std::chrono::milliseconds period = std::chrono::milliseconds(20))
+    {
+#if defined(OPTIM_TRACE)
+        return internal::trace::Sink::get().start(path, period);
+#else
+        return false;
+#endif
+    }
+
+    /// @brief write the remaining events and close the file
+    /// @return number of events dropped because a ring buffer was full
+    inline long stop()
+    {
+#if defined(OPTIM_TRACE)
+        return internal::trace::Sink::get().stop();
+#else
+        return 0;
+#endif
+    }
+}
+
+#endif
@@ -6,17 +6,29 @@
 
 #include "base/BaseSolver.hpp"
 #include "base/Recorder.hpp"
+#include "base/FiniteSumProblem.hpp"
+#include "base/MultiStart.hpp"
+#include "base/CachedProblem.hpp"
 
 #include "line_search/Armijo.hpp"
 #include "line_search/More_Thuente.hpp"
-#include "line_search/Zhang_Hager.hpp"
+#include "line_search/Zhang_Hager.hpp"
+#include "line_search/Hager_Zhang.hpp"
 
 #include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "unconstrained/gradient/Stochastic_Gradient.hpp"
+#include "unconstrained/gradient/Conjugate_Gradient.hpp"
+#include "unconstrained/gradient/FISTA.hpp"
 
 #include "unconstrained/newton/BFGS.hpp"
 #include "unconstrained/newton/LBFGS.hpp"
-#include "unconstrained/newton/NewtonLDLT.hpp"
+#include "unconstrained/newton/CompactLBFGS.hpp"
+#include "unconstrained/newton/LBFGSB.hpp"
+#include "unconstrained/newton/SparseNewton.hpp"
+#include "unconstrained/newton/NewtonMethod.hpp"
 #include "unconstrained/newton/NewtonCG.hpp"
+#include "unconstrained/newton/TrustRegionNewton.hpp"
+#include "unconstrained/newton/LevenbergMarquardt.hpp"
 
 #include "constrained/ALM.hpp"
 
@@ -0,0 +1,116 @@
+#pragma once
+#ifndef _OPTIM_ASK_TELL_GD_HPP_
+#define _OPTIM_ASK_TELL_GD_HPP_
+
+#include "AskTellSolver.hpp"
+#include "unconstrained/gradient/Step_Sceduler.hpp"
+
+namespace optim
+{
+    /// @brief Gradient descent with the ask/tell interface
+    /// @details same iterates as GradientDescent without accelerator, with the same step scheduler, line search and parameters, see AskTellSolver for the interface. Accelerators are not supported since they evaluate gradients at points of their own within an iteration.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class AskTellGD final : public AskTellSolver<fp_t>
+    {
+    public:
+        using LineSearchImp = typename AskTellSolver<fp_t>::LineSearchImp;
+        using lrScheduler = StepScheduler<fp_t>;
+
+    private:
+        using AskTellSolver<fp_t>::arg;
+        using AskTellSolver<fp_t>::iter;
+        using AskTellSolver<fp_t>::ls;
+
+        enum class Phase
+        {
+            first_point,
+            first_search,
+            search
+        } phase;
+
+        Mat<fp_t> last_x;
+
+    public:
+        std::shared_ptr<lrScheduler> lr_scheduler;
+
+        int max_iter = 1000;
+        fp_t step = 1e-2;
+        fp_t xtol = 1e-6,
+             ftol = 1e-4,
+             gtol = 1e-4;
+
+        AskTellGD()
+            : AskTellSolver<fp_t>(std::make_shared<LineSearchImp>()),
+              lr_scheduler(std::make_shared<lrScheduler>()) {}
+
+        explicit AskTellGD(std::shared_ptr<LineSearchImp> ls)
+            : AskTellSolver<fp_t>(ls),
+              lr_scheduler(std::make_shared<lrScheduler>()) {}
+
+    protected:
+        void init(const Mat<fp_t> &x) override
+        {
+            BMO_RESIZE(last_x, BMO_ROWS(x), BMO_COLS(x));
+            last_x = x;
+            phase = Phase::first_point;
+        }
+
+        bool advance() override
+        {
+            switch (phase)
+            {
+            case Phase::first_point:
+                arg.step = step;
+                if (arg.grad_norm() < gtol)
+                {
+                    this->status = 0;
+                    return true;
+                }
+                arg.direction = -arg.cur_grad;
+                ls->init(nullptr, arg);
+                arg.flush();
+                ls->start(arg);
+                phase = Phase::first_search;
+                return false;
+            case Phase::first_search:
+                if (!ls->tell(arg))
+                    return false;
+                lr_scheduler->init(arg);
+                iter = 1;
+                break;
+            case Phase::search:
+                if (!ls->tell(arg))
+                    return false;
+                {
+                    last_x -= arg.cur_x;
+                    const fp_t diff_x_nrm = BMO_FRO_NORM(last_x),
+                               diff_abs_f = std::abs(arg.cur_loss - arg.prev_loss),
+                               g_nrm = arg.grad_norm();
+                    logger.trace("[GD] iter: {:<5d}| loss: {:<16g}| step: {:<10g}\n|g_nrm: {:<12g}| diff_x_nrm: {:<10g}| diff_abs_f: {:<10g}", iter, arg.cur_loss, arg.step, g_nrm, diff_x_nrm, diff_abs_f);
+                    if (g_nrm < gtol || (diff_x_nrm < xtol && diff_abs_f < ftol))
+                    {
+                        this->status = 0;
+                        return true;
+                    }
+                }
+                if (++iter > max_iter)
+                {
+                    this->status = 1;
+                    return true;
+                }
+                break;
+            }
+            // steepest descent, then the next line search
+            arg.direction = -arg.cur_grad;
+            lr_scheduler->update(iter, arg);
+            BMO_SWAP(arg.prev_x, last_x);
+            arg.flush();
+            ls->start(arg);
+            phase = Phase::search;
+            return false;
+        }
+    };
+}
+
+#endif
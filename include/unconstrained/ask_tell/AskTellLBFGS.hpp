@@ -0,0 +1,139 @@
+#pragma once
+#ifndef _OPTIM_ASK_TELL_LBFGS_HPP_
+#define _OPTIM_ASK_TELL_LBFGS_HPP_
+
+#include "AskTellSolver.hpp"
+#include "unconstrained/newton/LBFGS.ipp"
+
+namespace optim
+{
+    /// @brief L-BFGS with the ask/tell interface
+    /// @details same iterates as LBFGS with the same line search and parameters, see AskTellSolver for the interface.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class AskTellLBFGS final : public AskTellSolver<fp_t>
+    {
+        using Storage = internal::LBFGS::Storage<fp_t>;
+
+    public:
+        using LineSearchImp = typename AskTellSolver<fp_t>::LineSearchImp;
+        using Constant = OptimConst<fp_t>;
+
+    private:
+        using AskTellSolver<fp_t>::arg;
+        using AskTellSolver<fp_t>::iter;
+        using AskTellSolver<fp_t>::ls;
+
+        enum class Phase
+        {
+            first_point,
+            first_search,
+            search
+        } phase;
+
+        CircularArray<Storage> memory;
+        Storage sy;
+
+    public:
+        int max_iter = 100; ///< max number of iterations
+        fp_t xtol = 1e-6;   ///< stop if |x_{k+1} - x_k| < xtol
+        fp_t ftol = 1e-6;   ///< stop if |f_{k+1} - f_k| < ftol
+        fp_t gtol = 1e-4;   ///< stop if |g_{k}| < gtol
+        fp_t step = 1e-2;   ///< initial step size
+        int m = 4;          ///< number of memory
+
+        AskTellLBFGS()
+            : AskTellSolver<fp_t>(std::make_shared<MTLS<fp_t, false>>()) {}
+
+        explicit AskTellLBFGS(std::shared_ptr<LineSearchImp> ls)
+            : AskTellSolver<fp_t>(ls) {}
+
+    protected:
+        void init(const Mat<fp_t> &x) override
+        {
+            const Index n = BMO_ROWS(x),
+                        k = BMO_COLS(x);
+            memory.reset(m);
+            for (int i = 0; i < m; i++)
+            {
+                BMO_RESIZE(memory.data[i].s, n, k);
+                BMO_RESIZE(memory.data[i].y, n, k);
+            }
+            BMO_RESIZE(sy.s, n, k);
+            BMO_RESIZE(sy.y, n, k);
+            phase = Phase::first_point;
+        }
+
+        bool advance() override
+        {
+            switch (phase)
+            {
+            case Phase::first_point:
+                ls->init(nullptr, arg);
+                arg.step = step;
+                arg.direction = -arg.cur_grad;
+                arg.flush();
+                ls->start(arg);
+                phase = Phase::first_search;
+                return false;
+            case Phase::first_search:
+                if (!ls->tell(arg))
+                    return false;
+                update_sy();
+                memory.push_back(std::move(sy));
+                iter = 1;
+                break;
+            case Phase::search:
+                if (!ls->tell(arg))
+                    return false;
+                update_sy();
+                {
+                    const fp_t g_nrm = BMO_FRO_NORM(arg.cur_grad),
+                               x_diff_nrm = BMO_FRO_NORM(sy.s),
+                               f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
+                                        (std::abs(arg.cur_loss) + fp_t(1));
+                    if (g_nrm < gtol && x_diff_nrm < xtol && f_diff < ftol)
+                    {
+                        this->status = 0;
+                        return true;
+                    }
+                }
+                memory.push_back(std::move(sy));
+                if (++iter > max_iter)
+                {
+                    this->status = 1;
+                    return true;
+                }
+                break;
+            }
+            // compute d = H * -grad and start the next line search
+            arg.direction = -arg.cur_grad;
+            internal::LBFGS::lbfgs_update_direction(arg.step, memory, arg.direction);
+            arg.step = fp_t(1), arg.flush();
+            ls->start(arg);
+            phase = Phase::search;
+            return false;
+        }
+
+    private:
+        /// @brief store the last pair and set arg.step to the Barzilai-Borwein step, as LBFGS does
+        void update_sy()
+        {
+            sy.s = arg.cur_x - arg.prev_x;
+            sy.y = arg.cur_grad - arg.prev_grad;
+            const fp_t sTy = BMO_MAT_DOT_PROD(sy.s, sy.y);
+            const fp_t y_nrm2 = BMO_SQUARE_NORM(sy.y);
+            if (y_nrm2 < Constant::eps || sTy < 0)
+                OPTIM_UNLIKELY
+                { // too small to storage!
+                    arg.step = step;
+                    return;
+                }
+            arg.step = std::min(
+                std::max(ls->min_step, sTy / y_nrm2), ls->max_step);
+            sy.rho = 1. / sTy;
+        }
+    };
+}
+
+#endif
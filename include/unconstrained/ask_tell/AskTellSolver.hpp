@@ -0,0 +1,86 @@
+#pragma once
+#ifndef _OPTIM_ASK_TELL_SOLVER_HPP_
+#define _OPTIM_ASK_TELL_SOLVER_HPP_
+
+#include "line_search/More_Thuente.hpp"
+
+namespace optim
+{
+    /// @brief Base class of the ask/tell solvers
+    /// @details the solver does not call a problem: ask() gives the point whose loss and gradient it needs next and tell() hands them over, then the solver moves on to its next point. One thread can thus drive many solves at once and evaluate their points together, e.g. in one request to a simulation service:
+    /// ```
+    /// for (auto &s : solvers) s.start(x0);
+    /// while (any solver is not done)
+    ///     evaluate ask() of the running solvers in one batch, then tell() each its values
+    /// ```
+    /// Each solver holds the state of one solve between the calls. The line search runs through its resumable interface, see LineSearch::start() and LineSearch::tell(), and is given no problem.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class AskTellSolver
+    {
+    public:
+        using Constant = OptimConst<fp_t>;
+        using LineSearchImp = LineSearch<fp_t, false>;
+        using Workspace = LineSearchArgs<fp_t, false>;
+
+    protected:
+        Workspace arg;
+        int iter = 0;
+        bool finished = true;
+
+    public:
+        std::shared_ptr<LineSearchImp> ls;
+
+        int status = 0; ///< 0 converged, 1 reaches max_iter
+
+    public:
+        explicit AskTellSolver(std::shared_ptr<LineSearchImp> ls) : ls(ls) {}
+
+        virtual ~AskTellSolver() = default;
+
+        /// @brief number of iterations
+        int n_iter() const { return iter; }
+
+        /// @brief start a solve at x
+        void start(const Mat<fp_t> &x)
+        {
+            arg.init(x);
+            iter = 0;
+            finished = false;
+            init(x);
+        }
+
+        /// @brief point to evaluate next
+        const Mat<fp_t> &ask() const { return arg.cur_x; }
+
+        /// @brief hand over the loss and gradient at ask()
+        /// @return true if the solve is over
+        bool tell(fp_t loss, const Mat<fp_t> &grad)
+        {
+            optim_assert(!finished, "tell() called on a finished solve.");
+            arg.cur_loss = loss;
+            arg.cur_grad = grad;
+            finished = advance();
+            return finished;
+        }
+
+        /// @brief whether the solve is over
+        bool done() const { return finished; }
+
+        /// @brief solution of the last solve, valid once done()
+        const Mat<fp_t> &x() const { return arg.cur_x; }
+
+        /// @brief loss at x()
+        fp_t loss() const { return arg.cur_loss; }
+
+    protected:
+        /// @brief set up the state of the derived solver
+        virtual void init(const Mat<fp_t> &) {}
+
+        /// @brief move on with cur_loss and cur_grad evaluated at cur_x
+        /// @return true if the solve is over, otherwise cur_x holds the next point to evaluate
+        virtual bool advance() = 0;
+    };
+}
+
+#endif
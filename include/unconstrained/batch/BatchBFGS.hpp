@@ -0,0 +1,125 @@
+#pragma once
+#ifndef _OPTIM_BATCH_BFGS_HPP_
+#define _OPTIM_BATCH_BFGS_HPP_
+
+#include "BatchSolver.hpp"
+
+namespace optim
+{
+    /// @brief Batched BFGS
+    /// @details the inverse Hessian approximations of all rows are kept as one k x n^2 matrix, column i + j n holding entry (i, j) of every row, so the products and the rank-2 updates run column by column on all rows at once. Meant for a few dozen variables at most. The first pair of a row scales its H to \f$ s^T y / y^T y \f$ before the update, pairs with \f$ s^T y \f$ too small are skipped.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class BatchBFGS final : public BatchSolver<fp_t>
+    {
+    public:
+        using Problem = typename BatchSolver<fp_t>::Problem;
+        using Constant = OptimConst<fp_t>;
+
+    private:
+        Mat<fp_t> H;                     ///< inverse Hessians, one row per problem
+        Mat<fp_t> S, Y, Hy;              ///< shaped like the batch
+        Mat<fp_t> sTy, yTy, yHy, g_nrm2; ///< one entry per row
+        std::vector<char> fresh;         ///< H is still the identity
+        Index n = 0;                     ///< number of variables
+
+        /// @brief set H of row r to a I
+        void set_identity(Index r, fp_t a)
+        {
+            for (Index i = 0; i < n; i++)
+                for (Index j = 0; j < n; j++)
+                    H(r, i + j * n) = i == j ? a : fp_t(0);
+        }
+
+    public:
+        explicit BatchBFGS(std::shared_ptr<Problem> p) : BatchSolver<fp_t>(p) {}
+
+    protected:
+        void init(Index B, Index n_var) override
+        {
+            n = n_var;
+            BMO_RESIZE(H, B, n * n);
+            fresh.assign(B, 1);
+            for (Index r = 0; r < B; r++)
+                set_identity(r, 1);
+        }
+
+        void direction() override
+        {
+            using namespace internal::batch;
+            const Index k = BMO_ROWS(this->G);
+            BMO_SET_ZERO(this->D);
+            fp_t *d = BMO_GET_DATA(this->D);
+            const fp_t *h = BMO_GET_DATA(H), *g = BMO_GET_DATA(this->G);
+            for (Index j = 0; j < n; j++)
+                for (Index i = 0; i < n; i++)
+                    for (Index r = 0; r < k; r++) // d_i -= H_ij g_j
+                        d[i * k + r] -= h[(i + j * n) * k + r] * g[j * k + r];
+            row_dot(this->G, this->G, g_nrm2);
+            for (Index r = 0; r < k; r++)
+                this->step(r) = fresh[r]
+                                    ? std::min(fp_t(1), fp_t(1) / std::sqrt(g_nrm2(r)))
+                                    : fp_t(1);
+        }
+
+        void update() override
+        {
+            using namespace internal::batch;
+            const Index k = BMO_ROWS(this->G);
+            S = this->X - this->prev_X;
+            Y = this->G - this->prev_G;
+            row_dot(S, Y, sTy);
+            row_dot(Y, Y, yTy);
+            for (Index r = 0; r < k; r++)
+            {
+                if (!(sTy(r) > Constant::eps * yTy(r)))
+                    sTy(r) = 0; // skip the pair
+                else if (fresh[r])
+                    set_identity(r, sTy(r) / yTy(r)), fresh[r] = 0;
+            }
+            // Hy = H y, yHy = y^T H y
+            BMO_RESIZE(Hy, k, n);
+            BMO_SET_ZERO(Hy);
+            fp_t *hy = BMO_GET_DATA(Hy), *h = BMO_GET_DATA(H);
+            const fp_t *s = BMO_GET_DATA(S), *y = BMO_GET_DATA(Y);
+            for (Index j = 0; j < n; j++)
+                for (Index i = 0; i < n; i++)
+                    for (Index r = 0; r < k; r++)
+                        hy[i * k + r] += h[(i + j * n) * k + r] * y[j * k + r];
+            row_dot(Y, Hy, yHy);
+            // H += (rho + rho^2 y^T H y) s s^T - rho (Hy s^T + s Hy^T)
+            for (Index r = 0; r < k; r++)
+            {
+                const fp_t rho = sTy(r) > 0 ? 1 / sTy(r) : fp_t(0);
+                sTy(r) = rho;                      // coefficient of the cross terms
+                yHy(r) = rho + rho * rho * yHy(r); // coefficient of s s^T
+            }
+            const fp_t *c1 = BMO_GET_DATA(yHy), *c2 = BMO_GET_DATA(sTy);
+            for (Index j = 0; j < n; j++)
+                for (Index i = 0; i < n; i++)
+                    for (Index r = 0; r < k; r++)
+                    {
+                        const fp_t si = s[i * k + r], sj = s[j * k + r];
+                        h[(i + j * n) * k + r] += c1[r] * si * sj -
+                                                  c2[r] * (hy[i * k + r] * sj + si * hy[j * k + r]);
+                    }
+        }
+
+        void reset(Index r) override
+        {
+            set_identity(r, 1);
+            fresh[r] = 1;
+            this->step(r) = std::min(fp_t(1), fp_t(1) / std::sqrt(g_nrm2(r)));
+        }
+
+        void compact(const std::vector<Index> &keep) override
+        {
+            internal::batch::keep_rows(H, keep);
+            for (Index i = 0; i < Index(keep.size()); i++)
+                fresh[i] = fresh[keep[i]];
+            fresh.resize(keep.size());
+        }
+    };
+}
+
+#endif
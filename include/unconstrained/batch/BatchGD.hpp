@@ -0,0 +1,55 @@
+#pragma once
+#ifndef _OPTIM_BATCH_GD_HPP_
+#define _OPTIM_BATCH_GD_HPP_
+
+#include "BatchSolver.hpp"
+
+namespace optim
+{
+    /// @brief Batched gradient descent
+    /// @details steepest descent on every row with its own Barzilai-Borwein step \f$ s^T s / s^T y \f$ as first trial of the line search.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class BatchGD final : public BatchSolver<fp_t>
+    {
+    public:
+        using Problem = typename BatchSolver<fp_t>::Problem;
+
+    private:
+        Mat<fp_t> S, Y, sTs, sTy;
+
+    public:
+        fp_t init_step = 1e-2; ///< first trial step of the first iteration
+        fp_t min_step = 1e-10; ///< bounds of the Barzilai-Borwein step
+        fp_t max_step = 1e10;
+
+        explicit BatchGD(std::shared_ptr<Problem> p) : BatchSolver<fp_t>(p) {}
+
+    protected:
+        void init(Index B, Index) override
+        {
+            for (Index r = 0; r < B; r++)
+                this->step(r) = init_step;
+        }
+
+        void direction() override
+        {
+            this->D = -this->G;
+        }
+
+        void update() override
+        {
+            using namespace internal::batch;
+            S = this->X - this->prev_X;
+            Y = this->G - this->prev_G;
+            row_dot(S, S, sTs);
+            row_dot(S, Y, sTy);
+            for (Index r = 0; r < BMO_ROWS(S); r++)
+                this->step(r) = sTy(r) > 0
+                                    ? std::min(std::max(sTs(r) / sTy(r), min_step), max_step)
+                                    : init_step;
+        }
+    };
+}
+
+#endif
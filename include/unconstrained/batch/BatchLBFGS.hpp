@@ -0,0 +1,118 @@
+#pragma once
+#ifndef _OPTIM_BATCH_LBFGS_HPP_
+#define _OPTIM_BATCH_LBFGS_HPP_
+
+#include "BatchSolver.hpp"
+
+namespace optim
+{
+    /// @brief Batched limited-memory BFGS
+    /// @details the m last pairs (s, y) of every row are kept as m matrices shaped like the batch, so the two-loop recursion works column by column on all rows at once. A pair with \f$ s^T y \f$ too small gets \f$ \rho = 0 \f$, which makes it a no-op in the recursion: rows skip updates without leaving the lockstep.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class BatchLBFGS final : public BatchSolver<fp_t>
+    {
+    public:
+        using Problem = typename BatchSolver<fp_t>::Problem;
+        using Constant = OptimConst<fp_t>;
+
+    private:
+        std::vector<Mat<fp_t>> S, Y, rho, alpha; ///< ring of the m last pairs
+        Mat<fp_t> gamma, sTy, yTy, g_nrm2, coef; ///< one entry per row
+        int head = 0, count = 0;
+
+    public:
+        int m = 6; ///< number of memory
+
+        explicit BatchLBFGS(std::shared_ptr<Problem> p) : BatchSolver<fp_t>(p) {}
+
+    protected:
+        void init(Index B, Index n) override
+        {
+            S.resize(m), Y.resize(m), rho.resize(m), alpha.resize(m);
+            for (int i = 0; i < m; i++)
+            {
+                BMO_RESIZE(S[i], B, n), BMO_RESIZE(Y[i], B, n);
+                BMO_RESIZE(rho[i], B, 1), BMO_RESIZE(alpha[i], B, 1);
+                BMO_SET_ZERO(rho[i]);
+            }
+            BMO_RESIZE(gamma, B, 1);
+            BMO_SET_ZERO(gamma);
+            head = count = 0;
+        }
+
+        void direction() override
+        {
+            using namespace internal::batch;
+            const Index k = BMO_ROWS(this->G);
+            // two-loop recursion, D holds q then r
+            this->D = this->G;
+            for (int c = 0, i = (head + m - 1) % m; c < count; c++, i = (i + m - 1) % m)
+            {
+                row_dot(S[i], this->D, alpha[i]);
+                for (Index r = 0; r < k; r++)
+                    alpha[i](r) *= -rho[i](r);
+                row_axpy(alpha[i], Y[i], this->D); // q -= alpha y
+            }
+            row_dot(this->G, this->G, g_nrm2);
+            for (Index r = 0; r < k; r++)
+            {
+                if (gamma(r) > 0)
+                    this->step(r) = 1;
+                else // no pair yet, start with a step of length 1
+                    this->step(r) = std::min(fp_t(1), fp_t(1) / std::sqrt(g_nrm2(r)));
+            }
+            for (Index j = 0; j < BMO_COLS(this->D); j++)
+                for (Index r = 0; r < k; r++)
+                    this->D(r, j) *= gamma(r) > 0 ? gamma(r) : fp_t(1);
+            for (int c = 0, i = (head + m - count) % m; c < count; c++, i = (i + 1) % m)
+            {
+                row_dot(Y[i], this->D, coef); // beta / rho
+                for (Index r = 0; r < k; r++)
+                    coef(r) = -alpha[i](r) - rho[i](r) * coef(r);
+                row_axpy(coef, S[i], this->D); // r += s (alpha - beta)
+            }
+            this->D = -this->D;
+        }
+
+        void update() override
+        {
+            using namespace internal::batch;
+            const Index k = BMO_ROWS(this->G);
+            S[head] = this->X - this->prev_X;
+            Y[head] = this->G - this->prev_G;
+            row_dot(S[head], Y[head], sTy);
+            row_dot(Y[head], Y[head], yTy);
+            for (Index r = 0; r < k; r++)
+            {
+                if (sTy(r) > Constant::eps * yTy(r))
+                    rho[head](r) = 1 / sTy(r), gamma(r) = sTy(r) / yTy(r);
+                else // skip the pair
+                    rho[head](r) = 0;
+            }
+            head = (head + 1) % m;
+            count = std::min(count + 1, m);
+        }
+
+        void reset(Index r) override
+        {
+            for (int i = 0; i < m; i++)
+                rho[i](r) = 0;
+            gamma(r) = 0;
+            this->step(r) = std::min(fp_t(1), fp_t(1) / std::sqrt(g_nrm2(r)));
+        }
+
+        void compact(const std::vector<Index> &keep) override
+        {
+            using internal::batch::keep_rows;
+            for (int i = 0; i < m; i++)
+            {
+                keep_rows(S[i], keep), keep_rows(Y[i], keep);
+                keep_rows(rho[i], keep), keep_rows(alpha[i], keep);
+            }
+            keep_rows(gamma, keep);
+        }
+    };
+}
+
+#endif
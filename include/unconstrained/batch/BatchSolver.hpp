@@ -0,0 +1,298 @@
+#pragma once
+#ifndef _OPTIM_BATCH_SOLVER_HPP_
+#define _OPTIM_BATCH_SOLVER_HPP_
+
+#include "base/BatchProblem.hpp"
+#include "misc/logger.hpp"
+
+/// @cond
+namespace optim::internal::batch
+{
+    // the k x n matrices below hold one problem per row. Loops run over the
+    // rows innermost, i.e. over the problems of one column, which the
+    // compiler turns into SIMD code.
+
+    /// @brief out_r = sum_j A_rj B_rj
+    template <typename fp_t>
+    void row_dot(const Mat<fp_t> &A, const Mat<fp_t> &B, Mat<fp_t> &out)
+    {
+        const Index k = BMO_ROWS(A),
+                    n = BMO_COLS(A);
+        BMO_RESIZE(out, k, 1);
+        fp_t *o = BMO_GET_DATA(out);
+        const fp_t *a = BMO_GET_DATA(A), *b = BMO_GET_DATA(B);
+        for (Index r = 0; r < k; r++)
+            o[r] = 0;
+        for (Index j = 0; j < n; j++)
+            for (Index r = 0; r < k; r++)
+                o[r] += a[j * k + r] * b[j * k + r];
+    }
+
+    /// @brief Y_rj += a_r X_rj
+    template <typename fp_t>
+    void row_axpy(const Mat<fp_t> &a, const Mat<fp_t> &X, Mat<fp_t> &Y)
+    {
+        const Index k = BMO_ROWS(X),
+                    n = BMO_COLS(X);
+        const fp_t *pa = BMO_GET_DATA(a), *x = BMO_GET_DATA(X);
+        fp_t *y = BMO_GET_DATA(Y);
+        for (Index j = 0; j < n; j++)
+            for (Index r = 0; r < k; r++)
+                y[j * k + r] += pa[r] * x[j * k + r];
+    }
+
+    /// @brief keep the rows keep (increasing) of M, in order
+    template <typename fp_t>
+    void keep_rows(Mat<fp_t> &M, const std::vector<Index> &keep)
+    {
+        const Index k = BMO_ROWS(M),
+                    n = BMO_COLS(M),
+                    m = Index(keep.size());
+        if (m == k)
+            return;
+        Mat<fp_t> tmp(m, n);
+        const fp_t *src = BMO_GET_DATA(M);
+        fp_t *dst = BMO_GET_DATA(tmp);
+        for (Index j = 0; j < n; j++)
+            for (Index i = 0; i < m; i++)
+                dst[j * m + i] = src[j * k + keep[i]];
+        BMO_SWAP(M, tmp);
+    }
+}
+/// @endcond
+
+namespace optim
+{
+    /// @brief Base class of the batched solvers
+    /// @details advances the problems of a BatchGradProblem in lockstep, one row per problem. Each iteration the derived solver computes the directions of all rows, then a backtracking Armijo line search runs with a step per row: every trial evaluates only the rows that have not accepted their step yet, gathered into a smaller batch. Rows that meet a stop criterion are written to the output and compacted out at the end of the iteration, so the remaining problems stay contiguous.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class BatchSolver
+    {
+    public:
+        using Problem = BatchGradProblem<fp_t>;
+        using Constant = OptimConst<fp_t>;
+
+    protected:
+        std::shared_ptr<Problem> prob;
+        int iter = 0;
+
+        // state of the running rows, row r is problem lanes[r]
+        std::vector<Index> lanes;
+        Mat<fp_t> X, G, D, prev_X, prev_G; ///< one row per problem
+        Mat<fp_t> f, prev_f, step, dg;     ///< one entry per problem
+
+    private:
+        std::vector<int> row_status;          ///< -1 while running
+        std::vector<Index> search, sub_lanes; ///< rows still in the line search
+        Mat<fp_t> sub_X, sub_G, sub_f, tmp;
+
+    public:
+        int max_iter = 100;    ///< max number of iterations
+        int max_ls_iter = 30;  ///< max number of trials of the line search
+        fp_t xtol = 1e-8;      ///< stop if |x_{k+1} - x_k| < xtol and |f_{k+1} - f_k| < ftol
+        fp_t ftol = 1e-10;     ///< relative to 1 + |f_{k+1}|
+        fp_t gtol = 1e-6;      ///< stop if |g_k| < gtol
+        fp_t armijo_c = 1e-4;  ///< sufficient decrease parameter
+        fp_t decay_rate = 0.5; ///< step shrink factor of the line search
+
+        std::vector<int> n_iter_lane; ///< iterations of each problem
+        /// @brief status of each problem: 0 converged, 1 reaches max_iter, 2 line search failed
+        std::vector<int> status;
+
+    public:
+        explicit BatchSolver(std::shared_ptr<Problem> p) : prob(p) {}
+
+        virtual ~BatchSolver() = default;
+
+        /// @brief number of lockstep iterations of the last solve()
+        int n_iter() const { return iter; }
+
+        /// @brief solve every problem of the batch
+        /// @param x B x n starting points, one row per problem, replaced by the solutions
+        /// @param out_f B x 1 losses at the solutions
+        void solve(Mat<fp_t> &x, Mat<fp_t> &out_f)
+        {
+            using namespace internal::batch;
+            const Index B = BMO_ROWS(x),
+                        n = BMO_COLS(x);
+            lanes.resize(B);
+            std::iota(lanes.begin(), lanes.end(), Index(0));
+            n_iter_lane.assign(B, 0);
+            status.assign(B, 1);
+            BMO_RESIZE(out_f, B, 1);
+            X = x;
+            BMO_RESIZE(G, B, n), BMO_RESIZE(D, B, n);
+            BMO_RESIZE(prev_X, B, n), BMO_RESIZE(prev_G, B, n);
+            BMO_RESIZE(f, B, 1), BMO_RESIZE(prev_f, B, 1);
+            BMO_RESIZE(step, B, 1), BMO_RESIZE(dg, B, 1);
+            init(B, n);
+            prob->loss_and_grad(X, lanes, f, G);
+            iter = 0;
+            row_status.assign(B, -1);
+            row_dot(G, G, tmp);
+            for (Index r = 0; r < B; r++)
+                if (std::sqrt(tmp(r)) < gtol)
+                    row_status[r] = 0;
+            finish(x, out_f);
+            for (iter = 1; iter <= max_iter && !lanes.empty(); iter++)
+            {
+                const Index k = Index(lanes.size());
+                direction();
+                row_dot(G, D, dg);
+                for (Index r = 0; r < k; r++)
+                    if (!(dg(r) < 0))
+                        OPTIM_UNLIKELY
+                        { // not a descent direction, restart the row
+                            reset(r);
+                            dg(r) = 0;
+                            for (Index j = 0; j < n; j++)
+                                D(r, j) = -G(r, j), dg(r) -= G(r, j) * G(r, j);
+                        }
+                BMO_SWAP(prev_X, X);
+                BMO_SWAP(prev_G, G);
+                BMO_SWAP(prev_f, f);
+                line_search();
+                update();
+                // stop criteria of every row
+                row_dot(G, G, tmp);
+                sub_G = X - prev_X;
+                row_dot(sub_G, sub_G, sub_f);
+                for (Index r = 0; r < k; r++)
+                {
+                    n_iter_lane[lanes[r]] = iter;
+                    if (row_status[r] >= 0)
+                        continue;
+                    const fp_t f_diff = std::abs(f(r) - prev_f(r)) / (std::abs(f(r)) + fp_t(1));
+                    if (std::sqrt(tmp(r)) < gtol ||
+                        (std::sqrt(sub_f(r)) < xtol && f_diff < ftol))
+                        row_status[r] = 0;
+                }
+                logger.trace("[Batch] iter: {:<5d}| running: {:<8d}", iter, k);
+                finish(x, out_f);
+            }
+            iter--; // the loop stops one past the last iteration
+            for (Index r = 0; r < Index(lanes.size()); r++)
+            { // reaches max_iter
+                for (Index j = 0; j < n; j++)
+                    x(lanes[r], j) = X(r, j);
+                out_f(lanes[r]) = f(r);
+            }
+            logger.info("[Batch] {} problems in {} iterations, {} not converged.",
+                        B, iter, lanes.size());
+        }
+
+    protected:
+        /// @brief set up the per-row state of the derived solver
+        /// @param B number of problems
+        /// @param n number of variables
+        virtual void init([[maybe_unused]] Index B, [[maybe_unused]] Index n) {}
+
+        /// @brief compute the direction D and the first trial step of every row from G and the history of the row
+        virtual void direction() = 0;
+
+        /// @brief update the history with the accepted steps X - prev_X and G - prev_G
+        virtual void update() {}
+
+        /// @brief forget the history of row r, whose direction was not a descent direction
+        virtual void reset([[maybe_unused]] Index r) {}
+
+        /// @brief keep the rows keep (increasing) of the per-row state of the derived solver
+        virtual void compact([[maybe_unused]] const std::vector<Index> &keep) {}
+
+    private:
+        /// @brief Armijo backtracking with one step per row
+        void line_search()
+        {
+            const Index k = Index(lanes.size()),
+                        n = BMO_COLS(X);
+            search.resize(k);
+            std::iota(search.begin(), search.end(), Index(0));
+            for (int ls_iter = 0; ls_iter < max_ls_iter && !search.empty(); ls_iter++)
+            {
+                const Index m = Index(search.size());
+                if (m == k)
+                { // every row, column by column
+                    X = prev_X;
+                    internal::batch::row_axpy(step, D, X);
+                    prob->loss_and_grad(X, lanes, f, G);
+                }
+                else
+                { // gather the rows still searching
+                    BMO_RESIZE(sub_X, m, n);
+                    sub_lanes.resize(m);
+                    for (Index j = 0; j < n; j++)
+                        for (Index i = 0; i < m; i++)
+                        {
+                            const Index r = search[i];
+                            sub_X(i, j) = X(r, j) = prev_X(r, j) + step(r) * D(r, j);
+                        }
+                    for (Index i = 0; i < m; i++)
+                        sub_lanes[i] = lanes[search[i]];
+                    BMO_RESIZE(sub_f, m, 1), BMO_RESIZE(sub_G, m, n);
+                    prob->loss_and_grad(sub_X, sub_lanes, sub_f, sub_G);
+                    for (Index j = 0; j < n; j++)
+                        for (Index i = 0; i < m; i++)
+                            G(search[i], j) = sub_G(i, j);
+                    for (Index i = 0; i < m; i++)
+                        f(search[i]) = sub_f(i);
+                }
+                Index m_next = 0;
+                for (Index i = 0; i < m; i++)
+                {
+                    const Index r = search[i];
+                    // written so that a NaN loss fails the test
+                    if (!(f(r) <= prev_f(r) + armijo_c * step(r) * dg(r)))
+                    {
+                        step(r) *= decay_rate;
+                        search[m_next++] = r;
+                    }
+                }
+                search.resize(m_next);
+            }
+            for (Index r : search)
+            { // no decrease found, stay at the previous point
+                for (Index j = 0; j < n; j++)
+                    X(r, j) = prev_X(r, j), G(r, j) = prev_G(r, j);
+                f(r) = prev_f(r);
+                row_status[r] = 2;
+            }
+        }
+
+        /// @brief write the finished rows to the output and compact the others
+        void finish(Mat<fp_t> &x, Mat<fp_t> &out_f)
+        {
+            using internal::batch::keep_rows;
+            const Index k = Index(lanes.size()),
+                        n = BMO_COLS(X);
+            std::vector<Index> keep;
+            keep.reserve(k);
+            for (Index r = 0; r < k; r++)
+            {
+                if (row_status[r] < 0)
+                {
+                    keep.push_back(r);
+                    continue;
+                }
+                const Index lane = lanes[r];
+                for (Index j = 0; j < n; j++)
+                    x(lane, j) = X(r, j);
+                out_f(lane) = f(r);
+                status[lane] = row_status[r];
+            }
+            if (Index(keep.size()) == k)
+                return;
+            for (Index i = 0; i < Index(keep.size()); i++)
+                lanes[i] = lanes[keep[i]], row_status[i] = -1;
+            lanes.resize(keep.size()), row_status.resize(keep.size());
+            keep_rows(X, keep), keep_rows(G, keep);
+            keep_rows(D, keep);
+            keep_rows(prev_X, keep), keep_rows(prev_G, keep);
+            keep_rows(f, keep), keep_rows(prev_f, keep);
+            keep_rows(step, keep), keep_rows(dg, keep);
+            compact(keep);
+        }
+    };
+}
+
+#endif
@@ -3,6 +3,7 @@
 #define _OPTIM_GRADIENT_ACCELERATOR_HPP_
 
 #include "line_search/base.hpp"
+#include <typeinfo>
 
 namespace optim
 {
@@ -14,6 +15,10 @@ namespace optim
 
         virtual void init(BaseArgs &){};
 
+        /// @brief whether `update` only needs the gradient at the accepted point
+        /// @details if true, the solver lets the line search evaluate the gradient at the accepted point together with the loss, and `grad_f(arg.cur_x, arg.cur_grad)` becomes free as long as `arg.cur_grad_fresh` is set. Accelerators opt in, only the plain GDAccelerator does by default, and one that writes `cur_x` before evaluating the gradient has to clear `arg.cur_grad_fresh`.
+        virtual bool reuse_ls_grad() const { return typeid(*this) == typeid(GDAccelerator); }
+
         /// @brief update cur_x, direction and cur_grad base on current prev_x, prev_grad and cur_x.
         /// @param iter current iteration
         /// @param grad_f for computing gradient
@@ -22,14 +27,24 @@ namespace optim
             int iter,
             GradFunc grad_f,
             BaseArgs &arg)
+        {
+            apply(iter, grad_f, arg);
+        };
+
+        /// @brief `update` for any callable grad_f
+        /// @details StaticGradientDescent calls it directly on accelerators held by value, so neither the call nor grad_f goes through a virtual or a std::function. An accelerator that overrides `update` has to hide `apply` with the actual code and let `update` forward to it.
+        template <typename GradF>
+        void apply([[maybe_unused]] int iter, GradF &grad_f, BaseArgs &arg)
         {
             grad_f(arg.cur_x, arg.cur_grad);
             arg.direction = -arg.cur_grad;
-        };
+        }
 
         virtual void release(){};
     };
 
+    /// @brief Nesterov momentum with the (k - 1) / (k + 2) schedule
+    /// @details the gradient is taken at the extrapolated point, but the line search then steps from prev_x, so combined with ProxGD it is not an accelerated proximal method. Use FISTA for composite problems.
     template <typename fp_t>
     struct Nesterov
         : public GDAccelerator<fp_t>
@@ -43,12 +58,26 @@ namespace optim
         Mat<fp_t> v; ///< velocity = x_{k+1} - x_k
 
     public:
+        void init(BaseArgs &arg) override
+        {
+            BMO_RESIZE(v, BMO_ROWS(arg.cur_x), BMO_COLS(arg.cur_x));
+        }
+
+        bool reuse_ls_grad() const override { return false; }
+
         void update(
             int iter, GradFunc grad_f, BaseArgs &arg) override
+        {
+            apply(iter, grad_f, arg);
+        }
+
+        template <typename GradF>
+        void apply(int iter, GradF &grad_f, BaseArgs &arg)
         {
             momentum = fp_t(iter - 1) / fp_t(iter + 2);
             v = arg.cur_x - arg.prev_x;
             arg.cur_x = arg.prev_x + momentum * v;
+            arg.cur_grad_fresh = false;
             grad_f(arg.cur_x, arg.cur_grad);
             arg.direction = -arg.cur_grad;
         }
@@ -79,8 +108,16 @@ namespace optim
             RG = BMO_INIT_ZERO(Mat<fp_t>, n, k);
         }
 
+        bool reuse_ls_grad() const override { return true; }
+
         void update(
             int iter, GradFunc grad_f, BaseArgs &arg) override
+        {
+            apply(iter, grad_f, arg);
+        }
+
+        template <typename GradF>
+        void apply([[maybe_unused]] int iter, GradF &grad_f, BaseArgs &arg)
         {
             grad_f(arg.cur_x, arg.cur_grad);
             G += BMO_ARRAY_MUL(arg.cur_grad, arg.cur_grad);
@@ -117,8 +154,16 @@ namespace optim
             RM = BMO_INIT_ZERO(Mat<fp_t>, n, k);
         }
 
+        bool reuse_ls_grad() const override { return true; }
+
         void update(
             int iter, GradFunc grad_f, BaseArgs &arg) override
+        {
+            apply(iter, grad_f, arg);
+        }
+
+        template <typename GradF>
+        void apply([[maybe_unused]] int iter, GradF &grad_f, BaseArgs &arg)
         {
             grad_f(arg.cur_x, arg.cur_grad);
             M = pho * M + (1 - pho) * BMO_ARRAY_MUL(arg.cur_grad, arg.cur_grad);
@@ -157,8 +202,16 @@ namespace optim
             v = BMO_INIT_ZERO(Mat<fp_t>, n, k);
         }
 
+        bool reuse_ls_grad() const override { return true; }
+
         void update(
             int iter, GradFunc grad_f, BaseArgs &arg) override
+        {
+            apply(iter, grad_f, arg);
+        }
+
+        template <typename GradF>
+        void apply([[maybe_unused]] int iter, GradF &grad_f, BaseArgs &arg)
         {
             grad_f(arg.cur_x, arg.cur_grad);
             M = pho * M + (1 - pho) * BMO_ARRAY_MUL(arg.cur_grad, arg.cur_grad);
@@ -202,8 +255,16 @@ namespace optim
             S = BMO_INIT_ZERO(Mat<fp_t>, n, k);
         }
 
+        bool reuse_ls_grad() const override { return true; }
+
         void update(
             int iter, GradFunc grad_f, BaseArgs &arg) override
+        {
+            apply(iter, grad_f, arg);
+        }
+
+        template <typename GradF>
+        void apply([[maybe_unused]] int iter, GradF &grad_f, BaseArgs &arg)
         {
             grad_f(arg.cur_x, arg.cur_grad);
             S = pho1 * S + (1 - pho1) * arg.cur_grad;
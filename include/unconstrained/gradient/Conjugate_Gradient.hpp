@@ -0,0 +1,201 @@
+#pragma once
+#ifndef _OPTIM_GRADIENT_CONJUGATE_GRADIENT_HPP_
+#define _OPTIM_GRADIENT_CONJUGATE_GRADIENT_HPP_
+
+#include "line_search/Hager_Zhang.hpp"
+
+namespace optim
+{
+    /// @brief choice of \f$ \beta_k \f$ in the nonlinear CG direction \f$ d_{k+1} = -g_{k+1} + \beta_k d_k \f$, with \f$ y_k = g_{k+1} - g_k \f$
+    enum class CGBeta
+    {
+        PRPlus,           ///< Polak-Ribiere+, \f$ \max(g_{k+1}^T y_k / |g_k|^2, 0) \f$
+        HestenesStiefel,  ///< \f$ g_{k+1}^T y_k / d_k^T y_k \f$
+        DaiYuan,          ///< \f$ |g_{k+1}|^2 / d_k^T y_k \f$
+        HagerZhang        ///< \f$ (y_k - 2 d_k |y_k|^2 / d_k^T y_k)^T g_{k+1} / d_k^T y_k \f$, bounded below by \f$ -1 / (|d_k| \min(\eta, |g_k|)) \f$
+    };
+
+    /// @brief Nonlinear conjugate gradient method
+    /// @details Every \f$ \beta \f$ is computed from inner products of the two gradients and the direction, so no \f$ y_k \f$ or \f$ s_k \f$ is stored. The direction is reset to \f$ -g \f$ every `restart` iterations, when it is not a descent direction, and, if `nu` is set, when successive gradients are far from orthogonal, \f$ |g_{k+1}^T g_k| \geq \nu |g_{k+1}|^2 \f$ (Powell). Powell's test is off by default, as it restarts about every other iteration on a Rosenbrock chain and slows all four betas down. The default line search is HZLineSearch, the one of CG_DESCENT. The first step of each search is the last step scaled by \f$ d_k^T g_k / d_{k+1}^T g_{k+1} \f$.
+    ///
+    /// With `low_memory`, the line-search arguments keep no previous point and move x in place (see LineSearchArgs::init_low_memory), and x itself is the current point. The solver then holds x, the two gradients and the direction, where L-BFGS with m = 4 holds 15 vectors with its line search. Use it with HZLS, ZHLS or Armijo, solve() throws std::invalid_argument with MTLS.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class NonlinearCG final
+        : public LSBaseSolver<fp_t>
+    {
+    public:
+        using Constant = OptimConst<fp_t>;
+        using Problem = GradProblem<fp_t>;
+        using LineSearchImp = typename LSBaseSolver<fp_t, false>::LineSearchImp;
+
+        using BaseSolver<fp_t>::iter;
+        using LSBaseSolver<fp_t>::ls;
+
+    private:
+        std::shared_ptr<Problem> prob;
+
+    public:
+        int max_iter = 1000;
+        fp_t xtol = 1e-10; ///< stop if |x_{k+1} - x_k| < xtol and the loss changes less than ftol
+        fp_t ftol = 1e-10; ///< relative change of the loss
+        fp_t gtol = 1e-6;  ///< stop if |g_k| < gtol
+        fp_t step = 0;     ///< first step size, 0 for \f$ 0.01 |x_0| / |g_0| \f$, or \f$ 0.01 |f_0| / |g_0|^2 \f$ at x_0 = 0
+        CGBeta beta = CGBeta::HagerZhang;
+        int restart = -1;  ///< restart every `restart` iterations, -1 for the problem size
+        fp_t nu = Constant::inf; ///< Powell restart threshold, e.g. 0.1 or 0.2, disabled by default
+        fp_t eta = 0.01;   ///< lower bound parameter of the Hager-Zhang beta
+        bool low_memory = false;
+        int n_restart = 0; ///< restarts in the last solve()
+        int status;
+
+        explicit NonlinearCG(std::shared_ptr<Problem> prob)
+        {
+            this->prob = prob;
+            this->ls = std::make_shared<HZLS<fp_t, false>>();
+        }
+
+        explicit NonlinearCG(
+            std::shared_ptr<Problem> prob,
+            std::shared_ptr<LineSearchImp> ls)
+        {
+            this->prob = prob;
+            this->ls = ls;
+        }
+
+        fp_t solve(Mat<fp_t> &x) override
+        {
+            using std::abs;
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("NonlinearCG");
+            if (!this->workspace)
+                this->workspace = std::make_shared<typename LSBaseSolver<fp_t>::Workspace>();
+            auto &arg = *this->workspace;
+            if (low_memory)
+                arg.init_low_memory(x);
+            else
+                arg.init(x);
+            const int restart_iter = restart < 0 ? int(BMO_SIZE(arg.cur_x)) : restart;
+            fp_t g_nrm2, x_diff_nrm, f_diff, dTg;
+            arg.update_cur_loss_grad(prob.get());
+            try
+            { // MTLS rejects low-memory arguments, hand x back first
+                ls->init(prob, arg);
+            }
+            catch (...)
+            {
+                if (low_memory)
+                    arg.release_low_memory(x);
+                throw;
+            }
+            g_nrm2 = BMO_SQUARE_NORM(arg.cur_grad);
+            arg.direction = -arg.cur_grad;
+            dTg = -g_nrm2;
+            if (step > 0 || g_nrm2 == 0)
+                arg.step = step;
+            else
+            {
+                const fp_t x_nrm = BMO_FRO_NORM(arg.cur_x);
+                arg.step = x_nrm > 0 ? fp_t(0.01) * x_nrm / std::sqrt(g_nrm2)
+                                     : fp_t(0.01) * std::max(abs(arg.cur_loss), fp_t(1)) / g_nrm2;
+            }
+            n_restart = 0;
+            status = g_nrm2 > 0; // already stationary otherwise
+            internal::NoMallocScope no_malloc;
+            for (iter = 1; iter <= max_iter && status; iter++)
+            {
+                internal::trace::Span trace_iter("iter");
+                arg.step = std::min(std::max(arg.step, ls->min_step), ls->max_step);
+                arg.flush();
+                ls->line_search(arg);
+                const fp_t g_old_nrm2 = g_nrm2;
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                    g_nrm2 = BMO_SQUARE_NORM(arg.cur_grad);
+                    x_diff_nrm = BMO_FRO_NORM(arg.direction) * arg.step;
+                    f_diff = abs(arg.cur_loss - arg.prev_loss) /
+                             (abs(arg.cur_loss) + fp_t(1));
+                }
+                if (iter % 10 == 0)
+                    logger.info("[NCG] iter: {:<5d}| loss: {:<16g}| step: {:<10g}| g_nrm: {:<12g}| restarts: {}",
+                                iter, arg.cur_loss, arg.step, std::sqrt(g_nrm2), n_restart);
+                if (std::sqrt(g_nrm2) < gtol || (x_diff_nrm < xtol && f_diff < ftol))
+                {
+                    status = 0;
+                    break;
+                }
+                internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                const fp_t dTg_old = dTg,
+                           gTg_old = BMO_MAT_DOT_PROD(arg.cur_grad, arg.prev_grad);
+                dTg = BMO_MAT_DOT_PROD(arg.direction, arg.cur_grad);
+                fp_t b = 0;
+                if (iter % restart_iter != 0 && abs(gTg_old) < nu * g_nrm2)
+                    b = compute_beta(arg, g_nrm2, g_old_nrm2, dTg, dTg_old);
+                // d = -g + beta d
+                arg.direction *= b;
+                arg.direction -= arg.cur_grad;
+                const fp_t dTg_new = b * dTg - g_nrm2;
+                if (b == 0 || !(dTg_new < 0))
+                { // restart along -g
+                    if (b != 0)
+                        arg.direction = -arg.cur_grad;
+                    n_restart++;
+                    dTg = -g_nrm2;
+                }
+                else
+                    dTg = dTg_new;
+                arg.step *= dTg_old / dTg;
+            }
+            if (low_memory)
+                arg.release_low_memory(x);
+            else
+                BMO_SWAP(x, arg.cur_x);
+            return arg.cur_loss;
+        }
+
+    private:
+        /// @details \f$ y_k^T g_{k+1} \f$ and \f$ |y_k|^2 \f$ are taken from the two gradients, expanding them in \f$ |g|^2 \f$ and \f$ g_{k+1}^T g_k \f$ cancels near convergence.
+        /// @param arg line-search arguments holding \f$ g_{k+1} \f$, \f$ g_k \f$ and \f$ d_k \f$
+        /// @param g_nrm2 \f$ |g_{k+1}|^2 \f$
+        /// @param g_old_nrm2 \f$ |g_k|^2 \f$
+        /// @param dTg \f$ d_k^T g_{k+1} \f$
+        /// @param dTg_old \f$ d_k^T g_k \f$
+        template <typename Args>
+        fp_t compute_beta(const Args &arg, fp_t g_nrm2, fp_t g_old_nrm2,
+                          fp_t dTg, fp_t dTg_old) const
+        {
+            const fp_t dTy = dTg - dTg_old;
+            fp_t b = 0;
+            switch (beta)
+            {
+            case CGBeta::PRPlus:
+                b = std::max(yTg(arg) / g_old_nrm2, fp_t(0));
+                break;
+            case CGBeta::HestenesStiefel:
+                b = yTg(arg) / dTy;
+                break;
+            case CGBeta::DaiYuan:
+                b = g_nrm2 / dTy;
+                break;
+            case CGBeta::HagerZhang:
+            {
+                const fp_t y_nrm2 = BMO_SQUARE_NORM(arg.cur_grad - arg.prev_grad),
+                           d_nrm = BMO_FRO_NORM(arg.direction);
+                b = (yTg(arg) - 2 * y_nrm2 * dTg / dTy) / dTy;
+                b = std::max(b, -1 / (d_nrm * std::min(eta, std::sqrt(g_old_nrm2))));
+                break;
+            }
+            }
+            return std::isfinite(b) ? b : fp_t(0);
+        }
+
+        /// @return \f$ g_{k+1}^T y_k \f$, y_k stays a lazy expression
+        template <typename Args>
+        static fp_t yTg(const Args &arg)
+        {
+            return BMO_MAT_DOT_PROD(arg.cur_grad, arg.cur_grad - arg.prev_grad);
+        }
+    };
+}
+
+#endif
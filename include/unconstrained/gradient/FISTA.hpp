@@ -0,0 +1,209 @@
+#pragma once
+#ifndef _OPTIM_GRADIENT_FISTA_HPP_
+#define _OPTIM_GRADIENT_FISTA_HPP_
+
+#include "base/BaseSolver.hpp"
+#include "misc/malloc_guard.hpp"
+
+namespace optim
+{
+    /// @brief when FISTA resets its momentum
+    enum class FISTARestart
+    {
+        None,     ///< never, the O(1/k^2) method of Beck and Teboulle
+        Function, ///< when the loss goes up, \f$ F(z_k) > F(x_{k-1}) \f$
+        Gradient  ///< when the momentum points uphill, \f$ (y_k - z_k)^T (z_k - x_{k-1}) > 0 \f$
+    };
+
+    /// @brief Fast Iterative Shrinkage-Thresholding Algorithm
+    /// @details Accelerated proximal gradient for \f$ F = f + h \f$ with a smooth f, see Beck and Teboulle, A Fast Iterative Shrinkage-Thresholding Algorithm for Linear Inverse Problems, 2009. Each iteration takes the proximal gradient step \f$ z_k = \text{prox}_{h/L}(y_k - \nabla f(y_k) / L) \f$ from the extrapolated point \f$ y_k \f$ and sets \f$ y_{k+1} = x_k + \frac{t_k - 1}{t_{k+1}} (x_k - x_{k-1}) \f$ with \f$ t_{k+1} = (1 + \sqrt{1 + 4 t_k^2}) / 2 \f$.
+    ///
+    /// L is found by backtracking: it is multiplied by `eta` until \f$ f(z_k) \leq f(y_k) + \nabla f(y_k)^T (z_k - y_k) + \frac{L}{2} |z_k - y_k|^2 \f$. The gradient at \f$ y_k \f$ is evaluated once and reused by every trial, which only costs a proximal operator and a smooth loss. With `monotone`, \f$ x_k \f$ is the better of \f$ z_k \f$ and \f$ x_{k-1} \f$ (MFISTA). Restarting the momentum, see O'Donoghue and Candes, Adaptive Restart for Accelerated Gradient Schemes, 2015, keeps the O(1/k^2) rate early on and recovers linear convergence on strongly convex problems such as a LASSO whose support has been found.
+    ///
+    /// Stops when the gradient mapping \f$ L |y_k - z_k| \f$ is below gtol, or when both \f$ |z_k - x_{k-1}| \f$ and the relative change of the loss are below xtol and ftol.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class FISTA final
+        : public BaseSolver<fp_t>
+    {
+    public:
+        using Constant = OptimConst<fp_t>;
+        using Problem = ProxGradProblem<fp_t>;
+
+        using BaseSolver<fp_t>::iter;
+
+    private:
+        std::shared_ptr<Problem> prob;
+        Mat<fp_t> x_prev, ///< x_{k-1}
+            y,            ///< extrapolated point
+            g,            ///< gradient of the smooth part at y
+            z,            ///< proximal gradient step from y
+            tmp;
+
+    public:
+        int max_iter = 1000;
+        fp_t xtol = 1e-10; ///< stop if |z_k - x_{k-1}| < xtol and the loss changes less than ftol
+        fp_t ftol = 1e-10; ///< relative change of the loss
+        fp_t gtol = 1e-6;  ///< stop if the gradient mapping is below gtol
+        fp_t step = 1;     ///< first step size 1/L
+        fp_t eta = 2;      ///< factor of L when the sufficient decrease fails
+        fp_t shrink = 1;   ///< factor of L at each iteration, below 1 lets L decrease again where the curvature drops
+        FISTARestart restart = FISTARestart::Gradient;
+        bool monotone = false;
+        int n_restart = 0; ///< restarts in the last solve()
+        int status;
+
+        explicit FISTA(std::shared_ptr<Problem> prob) : prob(prob) {}
+
+        fp_t solve(Mat<fp_t> &x) override
+        {
+            using std::abs;
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("FISTA");
+            const Index n = BMO_ROWS(x),
+                        m = BMO_COLS(x);
+            BMO_RESIZE(x_prev, n, m);
+            BMO_RESIZE(y, n, m);
+            BMO_RESIZE(g, n, m);
+            BMO_RESIZE(z, n, m);
+            BMO_RESIZE(tmp, n, m);
+            fp_t L = 1 / step, t = 1,
+                 f_x, F_x, f_y, f_z, F_z;
+            y = x;
+            f_y = f_x = sm_loss_and_grad(y);
+            F_x = f_x + nsm_loss(x);
+            n_restart = 0;
+            status = 1;
+            internal::NoMallocScope no_malloc;
+            for (iter = 1; iter <= max_iter; iter++)
+            {
+                internal::trace::Span trace_iter("iter");
+                { // z = prox(y - g / L) with the smallest L = shrink^i eta^j L
+                    internal::instrument::Timer timer(internal::instrument::Phase::LineSearch);
+                    internal::trace::Span trace_ls("backtracking");
+                    int trials = 0;
+                    L *= shrink;
+                    for (;;)
+                    {
+                        internal::trace::Span trace_trial("ls_trial");
+                        trials++;
+                        tmp = y - (1 / L) * g;
+                        prox(1 / L, tmp, z);
+                        f_z = sm_loss(z);
+                        tmp = z - y;
+                        const fp_t Q = f_y + BMO_MAT_DOT_PROD(g, tmp) +
+                                       L / 2 * BMO_SQUARE_NORM(tmp);
+                        // slack for the rounding of f once the steps are tiny
+                        if (f_z <= Q + 10 * Constant::eps * abs(f_y) || !std::isfinite(L))
+                            break;
+                        L *= eta;
+                    }
+                    internal::instrument::ls_trials(trials);
+                }
+                F_z = f_z + nsm_loss(z);
+                fp_t g_nrm, x_diff_nrm, f_diff;
+                bool reset;
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                    y = z - x; // y is not needed again before the next extrapolation
+                    g_nrm = L * BMO_FRO_NORM(tmp);
+                    x_diff_nrm = BMO_FRO_NORM(y);
+                    f_diff = abs(F_z - F_x) / (abs(F_z) + 1);
+                    reset = (restart == FISTARestart::Function && F_z > F_x) ||
+                            (restart == FISTARestart::Gradient && BMO_MAT_DOT_PROD(tmp, y) < 0);
+                }
+                if (iter % 10 == 0)
+                    logger.info("[FISTA] iter: {:<5d}| loss: {:<16g}| L: {:<10g}| g_nrm: {:<12g}| restarts: {}",
+                                iter, std::min(F_z, F_x), L, g_nrm, n_restart);
+                internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                const fp_t t_next = (1 + std::sqrt(1 + 4 * t * t)) / 2;
+                if (!monotone || F_z <= F_x)
+                { // x_k = z_k, y = x_k + (t_k - 1) / t_{k+1} (x_k - x_{k-1})
+                    y *= (t - 1) / t_next;
+                    y += z;
+                    BMO_SWAP(x_prev, x);
+                    BMO_SWAP(x, z);
+                    f_x = f_z, F_x = F_z;
+                }
+                else
+                { // x_k = x_{k-1}, y = x_k + t_k / t_{k+1} (z_k - x_k)
+                    y *= t / t_next;
+                    y += x;
+                    x_prev = x;
+                }
+                if (g_nrm < gtol || (x_diff_nrm < xtol && f_diff < ftol))
+                {
+                    status = 0;
+                    break;
+                }
+                if (reset)
+                {
+                    t = 1;
+                    y = x;
+                    n_restart++;
+                    f_y = f_x;
+                    grad(y);
+                }
+                else
+                {
+                    t = t_next;
+                    f_y = sm_loss_and_grad(y);
+                }
+            }
+            return F_x;
+        }
+
+        /// @brief free the memory kept for the next solve() call
+        void release()
+        {
+            BMO_RESIZE(x_prev, 0, 0);
+            BMO_RESIZE(y, 0, 0);
+            BMO_RESIZE(g, 0, 0);
+            BMO_RESIZE(z, 0, 0);
+            BMO_RESIZE(tmp, 0, 0);
+        }
+
+    private:
+        /// @return smooth loss at x, with its gradient in g
+        fp_t sm_loss_and_grad(const Mat<fp_t> &x)
+        {
+            internal::instrument::count(internal::instrument::Eval::LossGrad);
+            internal::trace::Span trace("loss_grad");
+            internal::AllowMallocScope allow_malloc;
+            return prob->sm_loss_and_grad(x, g);
+        }
+
+        void grad(const Mat<fp_t> &x)
+        {
+            internal::instrument::count(internal::instrument::Eval::Grad);
+            internal::trace::Span trace("grad");
+            internal::AllowMallocScope allow_malloc;
+            prob->grad(x, g);
+        }
+
+        fp_t sm_loss(const Mat<fp_t> &x)
+        {
+            internal::instrument::count(internal::instrument::Eval::Loss);
+            internal::trace::Span trace("loss");
+            internal::AllowMallocScope allow_malloc;
+            return prob->sm_loss(x);
+        }
+
+        fp_t nsm_loss(const Mat<fp_t> &x)
+        {
+            internal::AllowMallocScope allow_malloc;
+            return prob->nsm_loss(x);
+        }
+
+        void prox(fp_t s, const Mat<fp_t> &in_x, Mat<fp_t> &out_x)
+        {
+            internal::instrument::count(internal::instrument::Eval::Prox);
+            internal::trace::Span trace("prox");
+            internal::instrument::Timer timer(internal::instrument::Phase::Prox);
+            internal::AllowMallocScope allow_malloc;
+            prob->prox(s, in_x, out_x);
+        }
+    };
+}
+
+#endif
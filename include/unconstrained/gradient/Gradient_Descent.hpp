@@ -10,30 +10,104 @@
 
 namespace optim
 {
-    /// @brief Gradient Descent
-    /// @details Gradient Descent is a first-order optimization algorithm that using negative gradient as the line search direction. You can specify the line search criterion, step scheduler and accelerator.
+    /// @cond
+    namespace internal
+    {
+        template <typename T>
+        struct is_shared_ptr : std::false_type
+        {
+        };
+
+        template <typename T>
+        struct is_shared_ptr<std::shared_ptr<T>> : std::true_type
+        {
+        };
+
+        /// @brief a component held by value, or the object behind a shared_ptr
+        template <typename T>
+        inline OPTIM_STRONG_INLINE auto &deref(T &x)
+        {
+            if constexpr (is_shared_ptr<T>::value)
+                return *x;
+            else
+                return x;
+        }
+
+        template <typename T>
+        T make_component()
+        {
+            if constexpr (is_shared_ptr<T>::value)
+                return std::make_shared<typename T::element_type>();
+            else
+                return T();
+        }
+
+        /// @brief line search and workspace of a StaticGradientDescent whose line search is not the type-erased one of LSBaseSolver
+        template <typename fp_t, bool use_prox, typename LS>
+        struct StaticGDBase : public BaseSolver<fp_t>
+        {
+            LS ls = make_component<LS>();
+            std::shared_ptr<LineSearchArgs<fp_t, use_prox>> workspace;
+
+            virtual void release() { workspace.reset(); }
+        };
+
+        /// @brief LSBaseSolver when LS is its `std::shared_ptr<LineSearchImp>`, so the solver can be held through it
+        template <typename fp_t, bool use_prox, typename LS>
+        using static_gd_base_t = std::conditional_t<
+            std::is_same_v<LS, std::shared_ptr<typename LSBaseSolver<fp_t, use_prox>::LineSearchImp>>,
+            LSBaseSolver<fp_t, use_prox>,
+            StaticGDBase<fp_t, use_prox, LS>>;
+
+        template <typename T>
+        struct member_class;
+
+        template <typename C, typename R, typename... Args>
+        struct member_class<R (C::*)(Args...)>
+        {
+            using type = C;
+        };
+    }
+    /// @endcond
+
+    /// @brief Gradient Descent composed at compile time
+    /// @details Same algorithm as GradientDescent, with the problem, accelerator, step scheduler and line search as template parameters. Components given by value are called through their own type and the gradient callback handed to the accelerator is a plain lambda, so the compiler can inline the whole iteration, which matters for small problems. Declare the problem class `final` to also inline the loss and gradient, and pass the line search the problem type (e.g. `MTLS<double, false, MyProblem>`). Any component may instead be a `std::shared_ptr` to a base class for runtime polymorphism; GradientDescent is this class with every component type-erased. With `std::shared_ptr<LineSearch<fp_t, use_prox>>` as line search the solver derives from LSBaseSolver, like the other line-search solvers.
     /// @tparam fp_t floating-point type
-    /// @tparam use_prox whether to use proximal operator
-    template <typename fp_t, bool use_prox = false>
-    class GradientDescent
-        : public LSBaseSolver<fp_t, use_prox>
+    /// @tparam Problem problem type, a GradProblem or a ProxGradProblem
+    /// @tparam Accel accelerator, see GDAccelerator
+    /// @tparam Scheduler step scheduler, see StepScheduler
+    /// @tparam LS line search, see LineSearch
+    template <typename fp_t,
+              typename Problem,
+              typename Accel = GDAccelerator<fp_t>,
+              typename Scheduler = StepScheduler<fp_t>,
+              typename LS = LineSearch<
+                  fp_t, std::is_base_of_v<ProxGradProblem<fp_t>, Problem>, Problem>>
+    class StaticGradientDescent
+        : public internal::static_gd_base_t<
+              fp_t, std::is_base_of_v<ProxGradProblem<fp_t>, Problem>, LS>
     {
     public:
-        using Problem = ProxWrapper<
-            fp_t, GradProblem, use_prox>;
-        using Accel = GDAccelerator<fp_t>;
-        using lrScheduler = StepScheduler<fp_t>;
-        using LineSearchImp = typename LSBaseSolver<fp_t, use_prox>::LineSearchImp;
+        static_assert(Problem::rows_at_compile_time == Dynamic &&
+                          Problem::cols_at_compile_time == Dynamic,
+                      "accelerators and step schedulers work on dynamic-size matrices");
+        static constexpr bool use_prox =
+            std::is_base_of_v<ProxGradProblem<fp_t>, Problem>;
+        using Base = internal::static_gd_base_t<fp_t, use_prox, LS>;
+        using Workspace = LineSearchArgs<fp_t, use_prox>;
 
         using BaseSolver<fp_t>::iter;
-        using LSBaseSolver<fp_t, use_prox>::ls;
+        using Base::ls;
+        /// @brief line search arguments reused across solve() calls
+        using Base::workspace;
 
-    private:
+    protected:
         std::shared_ptr<Problem> prob;
+        Mat<fp_t> last_x; ///< kept across solve() calls
 
     public:
-        std::shared_ptr<Accel> accelerator;
-        std::shared_ptr<lrScheduler> lr_scheduler;
+        Accel accelerator;
+        Scheduler lr_scheduler;
 
         int max_iter = 1000;
         fp_t step = 1e-2;
@@ -42,68 +116,143 @@ namespace optim
              gtol = 1e-4;
 
     public:
-        GradientDescent(std::shared_ptr<Problem> p)
+        explicit StaticGradientDescent(std::shared_ptr<Problem> p)
+            : prob(p),
+              accelerator(internal::make_component<Accel>()),
+              lr_scheduler(internal::make_component<Scheduler>())
         {
-            prob = p;
-            accelerator.reset(new GDAccelerator<fp_t>());
-            ls.reset(new LineSearch<fp_t, use_prox>());
-            lr_scheduler.reset(new StepScheduler<fp_t>());
+            if constexpr (std::is_same_v<Base, LSBaseSolver<fp_t, use_prox>>)
+                ls = internal::make_component<LS>();
         };
 
         fp_t solve(Mat<fp_t> &x) override
         {
+            using internal::deref;
+            constexpr bool erased_accel = internal::is_shared_ptr<Accel>::value;
+            using AccelImp = std::remove_reference_t<decltype(deref(accelerator))>;
+            using GradFunc = typename AccelImp::GradFunc;
+            if constexpr (!erased_accel)
+                static_assert(
+                    std::is_same_v<
+                        typename internal::member_class<decltype(&AccelImp::update)>::type,
+                        typename internal::member_class<decltype(&AccelImp::template apply<const GradFunc>)>::type>,
+                    "an accelerator held by value must hide `apply` where it overrides `update`");
+            auto &acc = deref(accelerator);
+            auto &sched = deref(lr_scheduler);
+            auto &lsi = deref(ls);
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("GD");
             iter = 0;
-            LineSearchArgs<fp_t, use_prox> arg(x);
-            Mat<fp_t> prev_x = x;
+            if (!workspace)
+                workspace = std::make_shared<Workspace>();
+            auto &arg = *workspace;
+            arg.init(x);
+            BMO_RESIZE(last_x, BMO_ROWS(x), BMO_COLS(x));
+            last_x = x;
             fp_t diff_x_nrm, diff_abs_f, g_nrm;
-            ls->update_cur_grad = false;
+            // let the line search hand over the gradient at the accepted
+            // point if the accelerator only needs that one
+            lsi.update_cur_grad = acc.reuse_ls_grad();
+            const auto grad_f =
+                [this, &arg, &lsi](const Mat<fp_t> &in_x, Mat<fp_t> &out_grad)
+            {
+                if (lsi.update_cur_grad && arg.cur_grad_fresh &&
+                    &in_x == &arg.cur_x && &out_grad == &arg.cur_grad)
+                    return; // already evaluated by the line search
+                internal::AllowMallocScope allow_malloc;
+                internal::trace::Span trace("grad");
+                prob->grad(in_x, out_grad);
+                internal::instrument::count(internal::instrument::Eval::Grad);
+            };
+            const GradFunc erased_grad_f = grad_f;
             // first step
             arg.step = this->step;
-            arg.update_cur_loss(prob.get());
-            arg.update_cur_grad(prob.get());
+            arg.update_cur_loss_grad(prob.get());
             if constexpr (use_prox)
                 arg.update_cur_grad_map(prob.get());
             g_nrm = arg.grad_norm();
             if (g_nrm < gtol)
                 goto over;
             arg.direction = -arg.cur_grad;
-            ls->init(prob, arg);
+            lsi.init(prob, arg);
             arg.flush(); // move cur to prev
-            ls->line_search(arg);
-            accelerator->init(arg); // initialize the accelerator
-            for (iter = 1; iter <= max_iter; iter++)
+            lsi.line_search(arg);
+            acc.init(arg); // initialize the accelerator
+            sched.init(arg);
             {
-                // update direction, cur_x and cur_grad
-                auto grad_f = [this](const Mat<fp_t> &in_x,
-                                     Mat<fp_t> &out_grad)
-                { prob->grad(in_x, out_grad); };
-                accelerator->update(iter, grad_f, arg);
-                // update step size
-                lr_scheduler->update(iter, arg);
-                // line search
-                BMO_SWAP(arg.prev_x, prev_x);
-                arg.flush(); // move cur to prev
-                ls->line_search(arg);
-                // check stop criteria
-                prev_x -= arg.cur_x, diff_x_nrm = BMO_FRO_NORM(prev_x);
-                diff_abs_f = std::abs(arg.cur_loss - arg.prev_loss);
-                if constexpr (use_prox)
-                    arg.update_cur_grad_map(prob.get());
-                g_nrm = arg.grad_norm();
-                if (iter % 5 == 0)
-                    logger.info("[GD] iter: {:<5d}| loss: {:<16g}| step: {:<10g}\n|g_nrm: {:<12g}| diff_x_nrm: {:<10g}| diff_abs_f: {:<10g}",
-                                iter, arg.cur_loss, arg.step, g_nrm, diff_x_nrm, diff_abs_f);
-                else
-                    logger.trace("[GD] iter: {:<5d}| loss: {:<16g}| step: {:<10g}\n|g_nrm: {:<12g}| diff_x_nrm: {:<10g}| diff_abs_f: {:<10g}", iter, arg.cur_loss, arg.step, g_nrm, diff_x_nrm, diff_abs_f);
-                if (g_nrm < gtol || (diff_x_nrm < xtol && diff_abs_f < ftol))
-                    goto over;
+                internal::NoMallocScope no_malloc;
+                for (iter = 1; iter <= max_iter; iter++)
+                {
+                    internal::trace::Span trace_iter("iter");
+                    { // update direction, cur_x and cur_grad, then step size
+                        internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                        if constexpr (erased_accel)
+                            acc.update(iter, erased_grad_f, arg);
+                        else
+                            acc.apply(iter, grad_f, arg);
+                        sched.update(iter, arg);
+                    }
+                    // line search
+                    BMO_SWAP(arg.prev_x, last_x);
+                    arg.flush(); // move cur to prev
+                    lsi.line_search(arg);
+                    if constexpr (use_prox)
+                        arg.update_cur_grad_map(prob.get());
+                    { // check stop criteria
+                        internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                        last_x -= arg.cur_x, diff_x_nrm = BMO_FRO_NORM(last_x);
+                        diff_abs_f = std::abs(arg.cur_loss - arg.prev_loss);
+                        g_nrm = arg.grad_norm();
+                    }
+                    if (iter % 5 == 0)
+                        logger.info("[GD] iter: {:<5d}| loss: {:<16g}| step: {:<10g}\n|g_nrm: {:<12g}| diff_x_nrm: {:<10g}| diff_abs_f: {:<10g}",
+                                    iter, arg.cur_loss, arg.step, g_nrm, diff_x_nrm, diff_abs_f);
+                    else
+                        logger.trace("[GD] iter: {:<5d}| loss: {:<16g}| step: {:<10g}\n|g_nrm: {:<12g}| diff_x_nrm: {:<10g}| diff_abs_f: {:<10g}", iter, arg.cur_loss, arg.step, g_nrm, diff_x_nrm, diff_abs_f);
+                    if (g_nrm < gtol || (diff_x_nrm < xtol && diff_abs_f < ftol))
+                        goto over;
+                }
             }
         over:
-            accelerator->release();
-            lr_scheduler->release();
-            x = std::move(arg.cur_x);
+            BMO_SWAP(x, arg.cur_x);
             return arg.cur_loss;
         };
+
+        /// @brief free the memory kept for the next solve() call, including the accelerator and step scheduler state
+        void release() override
+        {
+            internal::deref(accelerator).release();
+            internal::deref(lr_scheduler).release();
+            BMO_RESIZE(last_x, 0, 0);
+            workspace.reset();
+        }
+    };
+
+    /// @brief Gradient Descent
+    /// @details Gradient Descent is a first-order optimization algorithm that using negative gradient as the line search direction. You can specify the line search criterion, step scheduler and accelerator. The components are chosen at runtime through `std::shared_ptr`, use StaticGradientDescent to fix them at compile time.
+    /// @tparam fp_t floating-point type
+    /// @tparam use_prox whether to use proximal operator
+    template <typename fp_t, bool use_prox = false>
+    class GradientDescent
+        : public StaticGradientDescent<
+              fp_t, ProxWrapper<fp_t, GradProblem, use_prox>,
+              std::shared_ptr<GDAccelerator<fp_t>>,
+              std::shared_ptr<StepScheduler<fp_t>>,
+              std::shared_ptr<LineSearch<fp_t, use_prox>>>
+    {
+    public:
+        using Problem = ProxWrapper<
+            fp_t, GradProblem, use_prox>;
+        using Accel = GDAccelerator<fp_t>;
+        using lrScheduler = StepScheduler<fp_t>;
+        using LineSearchImp = typename LSBaseSolver<fp_t, use_prox>::LineSearchImp;
+
+        GradientDescent(std::shared_ptr<Problem> p)
+            : StaticGradientDescent<
+                  fp_t, Problem,
+                  std::shared_ptr<Accel>,
+                  std::shared_ptr<lrScheduler>,
+                  std::shared_ptr<LineSearchImp>>(p){};
     };
 
     template <typename T>
@@ -112,4 +261,4 @@ namespace optim
     using ProxGD = GradientDescent<T, true>;
 };
 
-#endif // !_OPTIM_PROXIMAL_GRADIENT_DESCENT_HPP_
\ No newline at end of file
+#endif // !_OPTIM_PROXIMAL_GRADIENT_DESCENT_HPP_
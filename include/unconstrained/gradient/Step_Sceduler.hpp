@@ -9,6 +9,7 @@ namespace optim
     {
         using BaseArgs = BaseLineSearchArgs<fp_t>;
 
+        virtual void init(BaseArgs &){};
         virtual void update(int iter, BaseArgs &arg){};
         virtual void release(){};
     };
@@ -21,6 +22,12 @@ namespace optim
 
         Mat<fp_t> s, y;
 
+        void init(BaseArgs &arg) override
+        {
+            BMO_RESIZE(s, BMO_ROWS(arg.cur_x), BMO_COLS(arg.cur_x));
+            BMO_RESIZE(y, BMO_ROWS(arg.cur_x), BMO_COLS(arg.cur_x));
+        }
+
         void update(int iter, BaseArgs &arg) override
         {
             // update s and y
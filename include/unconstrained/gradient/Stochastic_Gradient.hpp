@@ -0,0 +1,265 @@
+#pragma once
+#ifndef _OPTIM_GRADIENT_STOCHASTIC_GRADIENT_HPP_
+#define _OPTIM_GRADIENT_STOCHASTIC_GRADIENT_HPP_
+
+#include "base/FiniteSumProblem.hpp"
+#include "line_search/base.hpp"
+#include "Accelerator.hpp"
+#include "Step_Sceduler.hpp"
+
+namespace optim
+{
+    /// @brief mini-batch gradient estimator
+    /// @details estimates the full gradient sum_i grad f_i(x) by N / |B| * sum_{i in B} grad f_i(x).
+    template <typename fp_t>
+    struct StochasticGradEstimator
+    {
+        using Problem = FiniteSumProblem<fp_t>;
+
+        /// @brief called once per solve() at the initial point
+        virtual void init(Problem &, const Mat<fp_t> &){};
+
+        /// @brief called at the start of every pass over the data
+        virtual void epoch(Problem &, const Mat<fp_t> &){};
+
+        /// @brief g = estimate of the full gradient at x from the shards in batch
+        virtual void estimate(
+            Problem &prob,
+            const Index *batch, Index n,
+            const Mat<fp_t> &x, Mat<fp_t> &g)
+        {
+            prob.batch_grad(batch, n, x, g);
+            g *= fp_t(prob.n_shards()) / fp_t(n);
+        }
+
+        virtual void release(){};
+
+        virtual ~StochasticGradEstimator() = default;
+    };
+
+    /// @brief stochastic variance reduced gradient (SVRG)
+    /// @details keeps a snapshot x~ and its full gradient mu, refreshed at the start of every pass: g = N / |B| * sum_{i in B} (grad f_i(x) - grad f_i(x~)) + mu.
+    template <typename fp_t>
+    struct SVRGEstimator
+        : public StochasticGradEstimator<fp_t>
+    {
+        using Problem = typename StochasticGradEstimator<fp_t>::Problem;
+
+    private:
+        Mat<fp_t> snapshot, mu, tmp;
+
+    public:
+        void epoch(Problem &prob, const Mat<fp_t> &x) override
+        {
+            snapshot = x;
+            prob.grad(snapshot, mu);
+        }
+
+        void estimate(
+            Problem &prob,
+            const Index *batch, Index n,
+            const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            prob.batch_grad(batch, n, x, g);
+            prob.batch_grad(batch, n, snapshot, tmp);
+            g -= tmp;
+            g *= fp_t(prob.n_shards()) / fp_t(n);
+            g += mu;
+        }
+
+        void release() override
+        {
+            BMO_RESIZE(snapshot, 0, 0);
+            BMO_RESIZE(mu, 0, 0);
+            BMO_RESIZE(tmp, 0, 0);
+        }
+    };
+
+    /// @brief SAGA
+    /// @details keeps the last gradient seen of every shard and their sum: g = N / |B| * sum_{i in B} (grad f_i(x) - table_i) + sum_j table_j. The table costs one gradient-sized matrix per shard and is filled by a full pass at the initial point.
+    template <typename fp_t>
+    struct SAGAEstimator
+        : public StochasticGradEstimator<fp_t>
+    {
+        using Problem = typename StochasticGradEstimator<fp_t>::Problem;
+
+    private:
+        std::vector<Mat<fp_t>> table, fresh;
+        Mat<fp_t> table_sum;
+
+    public:
+        void init(Problem &prob, const Mat<fp_t> &x) override
+        {
+            const Index n_shards = prob.n_shards();
+            table.resize(n_shards);
+            prob.thread_pool().parallel_for(n_shards, [&](Index i)
+                                            {
+                BMO_RESIZE(table[i], BMO_ROWS(x), BMO_COLS(x));
+                BMO_SET_ZERO(table[i]);
+                prob.shard_grad(i, x, table[i]); });
+            table_sum = BMO_INIT_ZERO(Mat<fp_t>, BMO_ROWS(x), BMO_COLS(x));
+            for (Index i = 0; i < n_shards; i++)
+                table_sum += table[i];
+        }
+
+        void estimate(
+            Problem &prob,
+            const Index *batch, Index n,
+            const Mat<fp_t> &x, Mat<fp_t> &g) override
+        {
+            if (Index(fresh.size()) < n)
+                fresh.resize(n);
+            prob.thread_pool().parallel_for(n, [&](Index k)
+                                            {
+                BMO_RESIZE(fresh[k], BMO_ROWS(x), BMO_COLS(x));
+                BMO_SET_ZERO(fresh[k]);
+                prob.shard_grad(batch[k], x, fresh[k]); });
+            BMO_RESIZE(g, BMO_ROWS(x), BMO_COLS(x));
+            BMO_SET_ZERO(g);
+            for (Index k = 0; k < n; k++)
+            { // the table takes the new gradient, fresh[k] the old one
+                Mat<fp_t> &old = table[batch[k]];
+                g += fresh[k] - old;
+                BMO_SWAP(old, fresh[k]);
+            }
+            // g = diff, table_sum = old sum + diff,
+            // so N / n * diff + old sum = (N / n - 1) * diff + table_sum
+            table_sum += g;
+            g *= fp_t(prob.n_shards()) / fp_t(n) - 1;
+            g += table_sum;
+        }
+
+        void release() override
+        {
+            table = std::vector<Mat<fp_t>>();
+            fresh = std::vector<Mat<fp_t>>();
+            BMO_RESIZE(table_sum, 0, 0);
+        }
+    };
+
+    /// @brief Stochastic gradient method over a finite-sum problem
+    /// @details Every pass over the data visits the shards in a fresh random order, `batch_size` shards per step. The gradient estimate comes from `estimator` (plain mini-batch, SVRG or SAGA), the accelerator turns it into a direction and the step scheduler adjusts the step, exactly as in GradientDescent, but without line search. The full loss is evaluated once per pass.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class StochasticGradient
+        : public BaseSolver<fp_t>
+    {
+    public:
+        using Problem = FiniteSumProblem<fp_t>;
+        using Estimator = StochasticGradEstimator<fp_t>;
+        using Accel = GDAccelerator<fp_t>;
+        using lrScheduler = StepScheduler<fp_t>;
+
+        using BaseSolver<fp_t>::iter;
+
+    private:
+        std::shared_ptr<Problem> prob;
+        LineSearchArgs<fp_t, false> arg; ///< kept across solve() calls
+        std::vector<Index> order;
+
+    public:
+        std::shared_ptr<Estimator> estimator;
+        std::shared_ptr<Accel> accelerator;
+        std::shared_ptr<lrScheduler> lr_scheduler;
+
+        int max_epoch = 10;    ///< max number of passes over the data
+        Index batch_size = 1;  ///< shards per step
+        fp_t step = 1e-3;      ///< initial step size
+        fp_t ftol = 1e-6;      ///< stop if |f_{k+1} - f_k| / (|f_k| + 1) < ftol between passes
+        unsigned seed = 42;    ///< seed of the shard shuffling
+        int epoch = 0;         ///< number of passes done
+
+    public:
+        explicit StochasticGradient(
+            std::shared_ptr<Problem> p,
+            std::shared_ptr<Estimator> est = std::make_shared<Estimator>())
+        {
+            prob = p;
+            estimator = est;
+            accelerator = std::make_shared<Accel>();
+            lr_scheduler = std::make_shared<lrScheduler>();
+        }
+
+        fp_t solve(Mat<fp_t> &x) override
+        {
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("SG");
+            const Index n_shards = prob->n_shards(),
+                        bs = std::max(Index(1), std::min(batch_size, n_shards));
+            std::mt19937_64 rng(seed);
+            order.resize(n_shards);
+            std::iota(order.begin(), order.end(), Index(0));
+            arg.init(x);
+            arg.step = step;
+            {
+                internal::trace::Span trace("loss");
+                arg.cur_loss = prob->loss(arg.cur_x);
+            }
+            internal::instrument::count(internal::instrument::Eval::Loss);
+            const Index *batch = nullptr;
+            Index n_batch = 0;
+            const typename Accel::GradFunc grad_f =
+                [this, &batch, &n_batch](const Mat<fp_t> &in_x, Mat<fp_t> &out_grad)
+            {
+                internal::trace::Span trace("grad");
+                estimator->estimate(*prob, batch, n_batch, in_x, out_grad);
+                internal::instrument::count(internal::instrument::Eval::Grad); // a mini-batch gradient
+            };
+            estimator->init(*prob, arg.cur_x);
+            accelerator->init(arg);
+            lr_scheduler->init(arg);
+            fp_t last_loss = arg.cur_loss;
+            iter = 0;
+            for (epoch = 1; epoch <= max_epoch; epoch++)
+            {
+                internal::trace::Span trace_epoch("epoch");
+                estimator->epoch(*prob, arg.cur_x);
+                std::shuffle(order.begin(), order.end(), rng);
+                for (Index k = 0; k < n_shards; k += bs)
+                {
+                    internal::trace::Span trace_iter("iter");
+                    iter++;
+                    batch = order.data() + k;
+                    n_batch = std::min(bs, n_shards - k);
+                    { // update direction and cur_grad at cur_x
+                        internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                        accelerator->update(iter, grad_f, arg);
+                        lr_scheduler->update(iter, arg);
+                    }
+                    arg.flush();
+                    arg.step_forward(prob.get());
+                }
+                {
+                    internal::trace::Span trace("loss");
+                    arg.cur_loss = prob->loss(arg.cur_x);
+                }
+                internal::instrument::count(internal::instrument::Eval::Loss);
+                const fp_t f_diff = std::abs(arg.cur_loss - last_loss) /
+                                    (std::abs(last_loss) + fp_t(1));
+                logger.info("[SG] epoch: {:<4d}| iter: {:<7d}| loss: {:<16g}| step: {:<10g}",
+                            epoch, iter, arg.cur_loss, arg.step);
+                last_loss = arg.cur_loss;
+                if (f_diff < ftol)
+                    break;
+            }
+            epoch = std::min(epoch, max_epoch);
+            BMO_SWAP(x, arg.cur_x);
+            return arg.cur_loss;
+        }
+
+        /// @brief free the memory kept for the next solve() call, including the estimator, accelerator and step scheduler state
+        void release()
+        {
+            estimator->release();
+            accelerator->release();
+            lr_scheduler->release();
+            arg = LineSearchArgs<fp_t, false>();
+            order = std::vector<Index>();
+        }
+    };
+
+    template <typename T>
+    using SGD = StochasticGradient<T>;
+}
+
+#endif
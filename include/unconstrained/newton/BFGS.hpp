@@ -7,22 +7,30 @@
 namespace optim
 {
     /// @brief Broyden-Fletcher-Goldfarb-Shanno (BFGS) algorithm
-    /// @details Using a symmetric
+    /// @details Keeps a dense nk x nk approximation of the inverse Hessian and updates it by a symmetric rank-2 product on its lower triangle, O((nk)^2) per iteration. With `cholesky`, keeps the Cholesky factor of the Hessian approximation instead, updated by a rank-one update and a downdate, which stays positive definite up to rounding and is reset to the identity if a downdate fails. The initial identity is scaled by s^T y / y^T y of the first pair, and pairs with s^T y <= eps |s| |y| are skipped in both variants.
     /// @tparam fp_t floating-point type
-    template <typename fp_t = double>
+    /// @tparam N number of rows of x if fixed at compile time
+    /// @tparam K number of columns of x if fixed at compile time. With both sizes fixed, the inverse Hessian and all buffers live in the solver and the line search arguments, no heap allocation is made and the products are unrolled.
+    template <typename fp_t = double, int N = Dynamic, int K = Dynamic>
     class BFGS final
-        : public LSBaseSolver<fp_t, false>
+        : public LSBaseSolver<fp_t, false, N, K>
     {
     public:
-        using Problem = GradProblem<fp_t>;
+        /// @brief number of variables if fixed at compile time
+        static constexpr int NK = (N == Dynamic || K == Dynamic) ? Dynamic : N * K;
+        using HessMat = Mat<fp_t, NK, NK>;
+        using Problem = GradProblem<fp_t, N, K>;
         using Constant = OptimConst<fp_t>;
-        using LineSearchImp = typename LSBaseSolver<fp_t, false>::LineSearchImp;
+        using LineSearchImp = typename LSBaseSolver<fp_t, false, N, K>::LineSearchImp;
 
-        using BaseSolver<fp_t>::iter;
-        using LSBaseSolver<fp_t, false>::ls;
+        using BaseSolver<fp_t, N, K>::iter;
+        using LSBaseSolver<fp_t, false, N, K>::ls;
 
     private:
         std::shared_ptr<Problem> prob;
+        Mat<fp_t, N, K> s, y;   ///< kept across solve() calls
+        Mat<fp_t, NK, 1> u, w;  ///< kept across solve() calls
+        HessMat H;              ///< inverse Hessian, or Cholesky factor of the Hessian, kept across solve() calls
 
     public:
         int max_iter = 100; ///< max number of iterations
@@ -30,13 +38,14 @@ namespace optim
         fp_t ftol = 1e-6;   ///< stop if |f_{k+1} - f_k| < ftol
         fp_t gtol = 1e-4;   ///< stop if |g_{k}| < gtol
         fp_t step = 1e-4;   ///< initial step size
+        bool cholesky = false; ///< keep the Cholesky factor of the Hessian instead of the inverse Hessian
         int status;         // wether solve successfully
 
     public:
         explicit BFGS(std::shared_ptr<Problem> prob)
         {
             this->prob = prob;
-            this->ls = std::make_shared<MTLS<fp_t, false>>();
+            this->ls = std::make_shared<MTLS<fp_t, false, Problem>>();
         }
 
         explicit BFGS(
@@ -47,56 +56,155 @@ namespace optim
             this->ls = ls;
         }
 
-        fp_t solve(Mat<fp_t> &x) override
+        fp_t solve(Mat<fp_t, N, K> &x) override
         {
-            const size_t n = BMO_ROWS(x),
-                         k = BMO_COLS(x),
-                         nk = n * k;
-            LineSearchArgs<fp_t, false> arg(x);
-            Mat<fp_t> s(n, k), y(n, k), Hy(nk, 1),
-                H = BMO_IDENTITY(Mat<fp_t>, nk, nk);
-            // H: approximate inverse Hessian
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("BFGS");
+            const Index n = BMO_ROWS(x),
+                        k = BMO_COLS(x),
+                        nk = n * k;
+            auto &arg = this->prepare_workspace(x);
+            BMO_RESIZE(s, n, k), BMO_RESIZE(y, n, k);
+            BMO_RESIZE(u, nk, 1), BMO_RESIZE(w, nk, 1);
+            BMO_RESIZE(H, nk, nk);
+            // H = L = I, whether it is the inverse Hessian or the factor
+            H = BMO_IDENTITY(HessMat, nk, nk);
             fp_t sTy, g_nrm, x_diff_nrm, f_diff;
             arg.step = step;
-            arg.step_forward(this->prob.get());
-            arg.update_cur_loss(this->prob.get());
-            arg.update_cur_grad(this->prob.get());
+            arg.update_cur_loss_grad(this->prob.get());
             arg.direction = -arg.cur_grad;
             ls->init(this->prob, arg);
             arg.flush();
             ls->line_search(arg);
+            internal::NoMallocScope no_malloc;
             for (iter = 1; iter < max_iter; ++iter)
             {
+                internal::trace::Span trace_iter("iter");
                 s = arg.cur_x - arg.prev_x;
                 y = arg.cur_grad - arg.prev_grad;
-                // check convergence condition
-                x_diff_nrm = BMO_FRO_NORM(s);
-                g_nrm = BMO_FRO_NORM(arg.cur_grad);
-                f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
-                         (std::abs(arg.cur_loss) + fp_t(1));
+                { // check convergence condition
+                    internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                    x_diff_nrm = BMO_FRO_NORM(s);
+                    g_nrm = BMO_FRO_NORM(arg.cur_grad);
+                    f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
+                             (std::abs(arg.cur_loss) + fp_t(1));
+                }
                 if (g_nrm < gtol && x_diff_nrm < xtol && f_diff < ftol)
                 {
                     status = 0;
-                    x = std::move(arg.cur_x);
+                    BMO_SWAP(x, arg.cur_x);
                     return arg.cur_loss;
                 }
-                BMO_RESIZE(s, nk, 1), BMO_RESIZE(y, nk, 1);
-                sTy = BMO_MAT_DOT_PROD(s, y), Hy = H * y;
-                // update H
-                H -= (Hy * BMO_TRANSPOSE(s)) / sTy;
-                Hy = BMO_TRANSPOSE(H) * y;
-                H -= s * BMO_TRANSPOSE(Hy) / sTy;
-                H += (s * BMO_TRANSPOSE(s)) / sTy;
-                arg.direction = -H * arg.cur_grad;
-                BMO_RESIZE(arg.direction, n, k);
-                BMO_RESIZE(s, n, k), BMO_RESIZE(y, n, k);
+                // the updates work on x flattened to a vector
+                MapMat<fp_t, NK, 1> BMO_INIT_MAP_MAT(vs, s, nk, 1);
+                MapMat<fp_t, NK, 1> BMO_INIT_MAP_MAT(vy, y, nk, 1);
+                MapMat<fp_t, NK, 1> BMO_INIT_MAP_MAT(g, arg.cur_grad, nk, 1);
+                MapMat<fp_t, NK, 1> BMO_INIT_MAP_MAT(d, arg.direction, nk, 1);
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    sTy = BMO_MAT_DOT_PROD(s, y);
+                    const fp_t yTy = BMO_SQUARE_NORM(y);
+                    const bool curved = sTy > Constant::eps * x_diff_nrm * std::sqrt(yTy);
+                    if (curved && iter == 1) // scale the initial identity by s^T y / y^T y
+                        H = BMO_IDENTITY(HessMat, nk, nk) *
+                            (cholesky ? std::sqrt(yTy / sTy) : sTy / yTy);
+                    if (cholesky)
+                    {
+                        if (curved)
+                            update_factor(vs, vy, sTy);
+                        // d = -(L L^T)^{-1} g
+                        d = -g;
+                        BMO_TRIL_SOLVE(H, d);
+                        BMO_TRIL_T_SOLVE(H, d);
+                    }
+                    else
+                    {
+                        if (curved)
+                        { // H += s w^T + w s^T, the product form expanded with u = H y
+                            BMO_SYM_MUL(u, H, vy);
+                            const fp_t rho = 1 / sTy,
+                                       a = rho * rho * BMO_DOT_PROD(vy, u) + rho;
+                            w = (fp_t(0.5) * a) * vs - rho * u;
+                            // through a map, Eigen would copy a plain vector
+                            MapMat<fp_t, NK, 1> BMO_INIT_MAP_MAT(vw, w, nk, 1);
+                            BMO_SYM_RANK2_UPDATE(H, vs, vw);
+                        }
+                        BMO_SYM_MUL(d, H, g);
+                        d = -d;
+                    }
+                }
                 // update prev values
                 arg.flush();
                 arg.step = fp_t(1);
                 ls->line_search(arg);
             }
+            status = 1;
+            BMO_SWAP(x, arg.cur_x);
             return arg.cur_loss;
         }
+
+        void release() override
+        {
+            BMO_RESIZE(s, 0, 0), BMO_RESIZE(y, 0, 0);
+            BMO_RESIZE(u, 0, 0), BMO_RESIZE(w, 0, 0);
+            BMO_RESIZE(H, 0, 0);
+            LSBaseSolver<fp_t, false, N, K>::release();
+        }
+
+    private:
+        /// @brief B + y y^T / s^T y - B s s^T B / s^T B s into the factor H of B
+        template <typename V>
+        void update_factor(const V &vs, const V &vy, const fp_t sTy)
+        {
+            BMO_TRIL_T_MUL(w, H, vs); // L^T s
+            const fp_t sBs = BMO_SQUARE_NORM(w);
+            BMO_TRIL_MUL(u, H, w); // B s
+            w = vy / std::sqrt(sTy);
+            u /= std::sqrt(sBs);
+            if (!update_downdate())
+                OPTIM_UNLIKELY
+                {
+                    logger.warn("[BFGS] Cholesky downdate failed, reset to identity.");
+                    H = BMO_IDENTITY(HessMat, BMO_ROWS(H), BMO_COLS(H));
+                }
+        }
+
+        /// @brief L L^T + w w^T - u u^T into L, overwrites w and u
+        /// @details column k of both rank-one steps only needs column k and the entries k.. of the vectors, so the update and the downdate share one pass over L, the update first so that the downdate is least likely to fail.
+        /// @return false if the result is not positive definite
+        bool update_downdate()
+        {
+            const Index nk = BMO_ROWS(H);
+            fp_t *L = BMO_GET_DATA(H), *pw = BMO_GET_DATA(w), *pu = BMO_GET_DATA(u);
+            for (Index k = 0; k < nk; k++)
+            {
+                fp_t *Lk = L + k * nk; // column k, stored contiguously
+                if (!rotate(Lk, pw, fp_t(1), k, nk) ||
+                    !rotate(Lk, pu, fp_t(-1), k, nk))
+                    return false;
+            }
+            return true;
+        }
+
+        /// @brief step k of the rank-one update (sigma = 1) or downdate (sigma = -1) of L by v
+        static OPTIM_STRONG_INLINE bool
+        rotate(fp_t *Lk, fp_t *v, const fp_t sigma, const Index k, const Index nk)
+        {
+            const fp_t l = Lk[k],
+                       r2 = l * l + sigma * v[k] * v[k];
+            if (!(r2 > 0))
+                return false;
+            const fp_t r = std::sqrt(r2), c = r / l, inv_c = l / r,
+                       t = v[k] / l, st = sigma * t;
+            Lk[k] = r;
+            for (Index i = k + 1; i < nk; i++)
+            {
+                const fp_t li = (Lk[i] + st * v[i]) * inv_c;
+                Lk[i] = li;
+                v[i] = c * v[i] - t * li;
+            }
+            return true;
+        }
     };
 }
 
@@ -0,0 +1,111 @@
+#pragma once
+#ifndef _OPTIM_NEWTON_COMPACT_LBFGS_HPP_
+#define _OPTIM_NEWTON_COMPACT_LBFGS_HPP_
+
+#include "line_search/More_Thuente.hpp"
+#include "CompactLBFGS.ipp"
+
+namespace optim
+{
+    /// @brief L-BFGS using the compact representation of the inverse Hessian
+    /// @details Same iterates as LBFGS, but the direction is computed as d = -gamma g - W q with W = [S Y] stored contiguously, so each iteration is two matrix-vector products over W plus O(m^2) work instead of 4m vector operations. Prefer it over LBFGS when n is large and m is moderate (m >= 5).
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class CompactLBFGS final : public LSBaseSolver<fp_t, false>
+    {
+        using Memory = internal::CompactLBFGS::Memory<fp_t>;
+
+    public:
+        using Problem = GradProblem<fp_t>;
+        using LineSearchImp = typename LSBaseSolver<fp_t, false>::LineSearchImp;
+
+        using BaseSolver<fp_t>::iter;
+        using LSBaseSolver<fp_t, false>::ls;
+
+    private:
+        std::shared_ptr<Problem> prob;
+        Memory memory; ///< kept across solve() calls
+
+    public:
+        int max_iter = 100; ///< max number of iterations
+        fp_t xtol = 1e-6;   ///< stop if |x_{k+1} - x_k| < xtol
+        fp_t ftol = 1e-6;   ///< stop if |f_{k+1} - f_k| < ftol
+        fp_t gtol = 1e-4;   ///< stop if |g_{k}| < gtol
+        fp_t step = 1e-2;   ///< initial step size
+        int m = 4;          ///< number of memory
+        int status;         // wether solve successfully
+
+    public:
+        explicit CompactLBFGS(std::shared_ptr<Problem> prob)
+        {
+            this->prob = prob;
+            this->ls = std::make_shared<MTLS<fp_t, false>>();
+        }
+
+        explicit CompactLBFGS(
+            std::shared_ptr<Problem> prob,
+            std::shared_ptr<LineSearchImp> ls)
+        {
+            this->prob = prob;
+            this->ls = ls;
+        }
+
+        fp_t solve(Mat<fp_t> &x) override
+        {
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("CompactLBFGS");
+            auto &arg = this->prepare_workspace(x);
+            memory.reset(BMO_ROWS(x) * BMO_COLS(x), m);
+            fp_t g_nrm, x_diff_nrm, f_diff;
+            arg.update_cur_loss_grad(this->prob.get());
+            ls->init(this->prob, arg);
+            // make step 0
+            arg.step = step;
+            arg.direction = -arg.cur_grad;
+            memory.steepest_descent();
+            arg.flush();
+            ls->line_search(arg);
+            memory.update(arg.step, arg);
+            // begin main loop
+            internal::NoMallocScope no_malloc;
+            for (iter = 1; iter <= max_iter; iter++)
+            {
+                internal::trace::Span trace_iter("iter");
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    memory.direction(arg.cur_grad, arg.direction);
+                }
+                arg.step = fp_t(1), arg.flush();
+                ls->line_search(arg);
+                { // s^T y, y^T y and W^T g of the new pair
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    memory.update(arg.step, arg);
+                }
+                { // check stop criteria
+                    internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                    g_nrm = BMO_FRO_NORM(arg.cur_grad);
+                    x_diff_nrm = arg.step * BMO_FRO_NORM(arg.direction);
+                    f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
+                             (std::abs(arg.cur_loss) + fp_t(1));
+                }
+                if (g_nrm < gtol && x_diff_nrm < xtol && f_diff < ftol)
+                {
+                    status = 0;
+                    BMO_SWAP(x, arg.cur_x);
+                    return arg.cur_loss;
+                }
+            }
+            status = 1;
+            BMO_SWAP(x, arg.cur_x);
+            return arg.cur_loss;
+        };
+
+        void release() override
+        {
+            memory.release();
+            LSBaseSolver<fp_t, false>::release();
+        }
+    };
+}
+
+#endif
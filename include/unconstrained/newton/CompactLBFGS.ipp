@@ -0,0 +1,172 @@
+#pragma once
+#include "base/BaseSolver.hpp"
+// reference: Byrd, Nocedal, Schnabel. Representations of quasi-Newton
+// matrices and their use in limited memory methods. 1994.
+/// @cond
+namespace optim
+{
+    namespace internal::CompactLBFGS
+    {
+        /// @brief L-BFGS memory in compact form
+        /// @details S and Y are stored as column blocks of one matrix W = [S Y] (nk x 2m), used as a ring buffer. S^T Y, Y^T Y and W^T g are kept up to date without touching W again, so one iteration reads W twice: W^T g after the line search and W q for the direction.
+        template <typename fp_t>
+        class Memory
+        {
+            int m = 0;    // number of slots
+            int head = 0; // slot of the oldest pair
+            int len = 0;  // number of stored pairs
+            Index nk = 0;
+
+            Mat<fp_t> W;      // [S Y], nk x 2m
+            Mat<fp_t> StY;    // StY(a, b) = s_a^T y_b, by slot
+            Mat<fp_t> YtY;    // YtY(a, b) = y_a^T y_b, by slot
+            Mat<fp_t> wg;     // W^T g at the point of the last direction
+            Mat<fp_t> wg_new; // W^T g at the new point
+            Mat<fp_t> q;      // d = -gamma * g - W q
+            Mat<fp_t> ys;     // y_a^T s of the new s, by slot
+            Mat<fp_t> t, u;   // chronological small system
+            fp_t gamma = 1;
+
+            OPTIM_INLINE int slot(int i) const { return (head + i) % m; }
+
+        public:
+            void reset(Index n_elem, int mem)
+            {
+                nk = n_elem, m = mem;
+                head = 0, len = 0, gamma = 1;
+                BMO_RESIZE(W, nk, 2 * m), BMO_SET_ZERO(W);
+                BMO_RESIZE(StY, m, m), BMO_SET_ZERO(StY);
+                BMO_RESIZE(YtY, m, m), BMO_SET_ZERO(YtY);
+                BMO_RESIZE(wg, 2 * m, 1), BMO_SET_ZERO(wg);
+                BMO_RESIZE(wg_new, 2 * m, 1);
+                BMO_RESIZE(q, 2 * m, 1), BMO_SET_ZERO(q);
+                BMO_RESIZE(ys, m, 1), BMO_RESIZE(t, m, 1), BMO_RESIZE(u, m, 1);
+            }
+
+            void release()
+            {
+                m = 0, nk = 0, head = 0, len = 0;
+                BMO_RESIZE(W, 0, 0), BMO_RESIZE(StY, 0, 0);
+                BMO_RESIZE(YtY, 0, 0), BMO_RESIZE(wg, 0, 0);
+                BMO_RESIZE(wg_new, 0, 0), BMO_RESIZE(q, 0, 0);
+                BMO_RESIZE(ys, 0, 0), BMO_RESIZE(t, 0, 0), BMO_RESIZE(u, 0, 0);
+            }
+
+            int size() const { return len; }
+
+            /// @brief the direction used was -g, no pair stored yet
+            void steepest_descent()
+            {
+                gamma = 1;
+                BMO_SET_ZERO(q);
+                BMO_SET_ZERO(wg);
+            }
+
+            /// @brief store the pair s = cur_x - prev_x, y = cur_grad - prev_grad
+            /// @param step step taken along the last direction
+            /// @return s^T y / y^T y, or a negative value if the pair is rejected
+            template <typename Args>
+            fp_t update(const fp_t step, Args &arg)
+            {
+                MapMat<fp_t> BMO_INIT_MAP_MAT(g, arg.cur_grad, nk, 1);
+                MapMat<fp_t> BMO_INIT_MAP_MAT(g0, arg.prev_grad, nk, 1);
+                MapMat<fp_t> BMO_INIT_MAP_MAT(x, arg.cur_x, nk, 1);
+                MapMat<fp_t> BMO_INIT_MAP_MAT(x0, arg.prev_x, nk, 1);
+                // W^T g_{k+1}, the only pass over W in the update
+                BMO_NOALIAS(wg_new) = BMO_TRANSPOSE(W) * g;
+                // y^T y and s^T y without materializing s and y
+                const fp_t sTy = BMO_MAT_DOT_PROD(x - x0, g - g0);
+                const fp_t yTy = BMO_SQUARE_NORM(g - g0);
+                // scale-free curvature test, tiny gradients near the
+                // solution still give usable pairs
+                if (!(sTy > OptimConst<fp_t>::eps * yTy))
+                    OPTIM_UNLIKELY
+                    { // keep the memory, only move W^T g
+                        BMO_SWAP(wg, wg_new);
+                        return fp_t(-1);
+                    }
+                // products of the new pair with the old ones:
+                // S^T y = W_S^T (g_{k+1} - g_k), Y^T y likewise,
+                // Y^T s = step * Y^T d = -step * (gamma Y^T g_k + Y^T W q)
+                for (int i = 0; i < len; i++)
+                {
+                    const int a = slot(i);
+                    fp_t yTd = gamma * wg(m + a);
+                    for (int j = 0; j < len; j++)
+                    {
+                        const int b = slot(j);
+                        yTd += StY(b, a) * q(b) + YtY(a, b) * q(m + b);
+                    }
+                    ys(a) = -step * yTd; // y_a^T s
+                }
+                int j;
+                if (len == m)
+                { // overwrite the oldest pair
+                    j = head;
+                    head = (head + 1) % m;
+                }
+                else
+                    j = slot(len++);
+                for (int i = 0; i < len; i++)
+                {
+                    const int a = slot(i);
+                    if (a == j)
+                        continue;
+                    StY(a, j) = wg_new(a) - wg(a);         // s_a^T y
+                    YtY(a, j) = wg_new(m + a) - wg(m + a); // y_a^T y
+                    YtY(j, a) = YtY(a, j);
+                    StY(j, a) = ys(a); // s^T y_a
+                }
+                StY(j, j) = sTy, YtY(j, j) = yTy;
+                W.col(j) = x - x0;
+                W.col(m + j) = g - g0;
+                BMO_SWAP(wg, wg_new);
+                wg(j) = BMO_MAT_DOT_PROD(W.col(j), g);
+                wg(m + j) = BMO_MAT_DOT_PROD(W.col(m + j), g);
+                gamma = sTy / yTy;
+                return gamma;
+            }
+
+            /// @brief d = -H g, H = gamma I + [S gamma Y] M [S gamma Y]^T
+            /// @details g must be the gradient passed to the last update().
+            void direction(Mat<fp_t> &g_mat, Mat<fp_t> &d_mat)
+            {
+                MapMat<fp_t> BMO_INIT_MAP_MAT(g, g_mat, nk, 1);
+                MapMat<fp_t> BMO_INIT_MAP_MAT(d, d_mat, nk, 1);
+                BMO_SET_ZERO(q);
+                // R = triu(S^T Y) in chronological order, solve R t = S^T g
+                for (int i = len - 1; i >= 0; i--)
+                {
+                    const int a = slot(i);
+                    fp_t sum = wg(a);
+                    for (int k = i + 1; k < len; k++)
+                        sum -= StY(a, slot(k)) * t(k);
+                    t(i) = sum / StY(a, a);
+                }
+                // u = (D + gamma Y^T Y) t - gamma Y^T g
+                for (int i = 0; i < len; i++)
+                {
+                    const int a = slot(i);
+                    fp_t sum = StY(a, a) * t(i) - gamma * wg(m + a);
+                    for (int k = 0; k < len; k++)
+                        sum += gamma * YtY(a, slot(k)) * t(k);
+                    u(i) = sum;
+                }
+                // R^T top = u
+                for (int i = 0; i < len; i++)
+                {
+                    const int a = slot(i);
+                    fp_t sum = u(i);
+                    for (int k = 0; k < i; k++)
+                        sum -= StY(slot(k), a) * q(slot(k));
+                    q(a) = sum / StY(a, a);
+                    q(m + a) = -gamma * t(i);
+                }
+                // the only pass over W to build the direction
+                d = -gamma * g;
+                BMO_NOALIAS(d) -= W * q;
+            }
+        };
+    }
+}
+/// @endcond
@@ -24,6 +24,8 @@ namespace optim
 
     private:
         std::shared_ptr<Problem> prob;
+        CircularArray<Storage> memory; ///< kept across solve() calls
+        Storage sy;
 
     public:
         int max_iter = 100; ///< max number of iterations
@@ -82,12 +84,21 @@ namespace optim
 
         fp_t solve(Mat<fp_t> &x) override
         {
-            CircularArray<Storage> memory(m);
-            Storage sy;
-            LineSearchArgs<fp_t, false> arg(x);
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("LBFGS");
+            const Index n = BMO_ROWS(x),
+                        k = BMO_COLS(x);
+            auto &arg = this->prepare_workspace(x);
+            memory.reset(m);
+            for (int i = 0; i < m; i++)
+            {
+                BMO_RESIZE(memory.data[i].s, n, k);
+                BMO_RESIZE(memory.data[i].y, n, k);
+            }
+            BMO_RESIZE(sy.s, n, k);
+            BMO_RESIZE(sy.y, n, k);
             fp_t g_nrm, x_diff_nrm, f_diff;
-            arg.update_cur_loss(this->prob.get());
-            arg.update_cur_grad(this->prob.get());
+            arg.update_cur_loss_grad(this->prob.get());
             ls->init(this->prob, arg);
             arg.step = step;
             // make step 0
@@ -98,34 +109,48 @@ namespace optim
             update_sy(sy, arg);
             memory.push_back(std::move(sy));
             // begin main loop
+            internal::NoMallocScope no_malloc;
             for (iter = 1; iter <= max_iter; iter++)
             {
-                // arg.direc = -arg.cur_grad;
-                update_direction(arg);
-                // compute d = H * -grad
-                lbfgs_update_direction(arg.step, memory, arg.direction);
+                internal::trace::Span trace_iter("iter");
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    // arg.direc = -arg.cur_grad;
+                    update_direction(arg);
+                    // compute d = H * -grad
+                    lbfgs_update_direction(arg.step, memory, arg.direction);
+                }
                 // update prev_x, prev_g, prev_loss and memory
                 arg.step = fp_t(1), arg.flush();
                 ls->line_search(arg);
                 update_sy(sy, arg);
-                // check stop criteria
-                g_nrm = BMO_FRO_NORM(arg.cur_grad);
-                x_diff_nrm = BMO_FRO_NORM(sy.s); // = norm(d) * step;
-                f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
-                         (std::abs(arg.cur_loss) + fp_t(1));
+                { // check stop criteria
+                    internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                    g_nrm = BMO_FRO_NORM(arg.cur_grad);
+                    x_diff_nrm = BMO_FRO_NORM(sy.s); // = norm(d) * step;
+                    f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
+                             (std::abs(arg.cur_loss) + fp_t(1));
+                }
                 if (g_nrm < gtol && x_diff_nrm < xtol && f_diff < ftol)
                 { // check stop criteria and resize back
                     status = 0;
-                    x = std::move(arg.cur_x);
+                    BMO_SWAP(x, arg.cur_x);
                     return arg.cur_loss;
                 }
                 // update memory
                 memory.push_back(std::move(sy));
             }
             status = 1; // TODO: log
-            x = std::move(arg.cur_x);
+            BMO_SWAP(x, arg.cur_x);
             return arg.cur_loss;
         };
+
+        void release() override
+        {
+            memory.reset(0);
+            sy = Storage();
+            LSBaseSolver<fp_t, false>::release();
+        }
     };
 }
 
@@ -1,3 +1,4 @@
+#pragma once
 #include "base/BaseSolver.hpp"
 /// @cond
 namespace optim
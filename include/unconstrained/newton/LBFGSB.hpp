@@ -0,0 +1,184 @@
+#pragma once
+#ifndef _OPTIM_NEWTON_LBFGSB_HPP_
+#define _OPTIM_NEWTON_LBFGSB_HPP_
+
+#include "line_search/More_Thuente.hpp"
+#include "LBFGSB.ipp"
+
+namespace optim
+{
+    /// @brief Limited-memory BFGS with box constraints (L-BFGS-B)
+    /// @details Solve min f(x) s.t. lower <= x <= upper. Each iteration finds the generalized Cauchy point of the L-BFGS model along the projected gradient path, minimizes the model over the variables that are still free, and runs a line search along the resulting feasible direction. Use +-OptimConst<fp_t>::inf for unbounded entries.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class LBFGSB final : public LSBaseSolver<fp_t, false>
+    {
+        using Model = internal::LBFGSB::Model<fp_t>;
+
+    public:
+        using Problem = GradProblem<fp_t>;
+        using Constant = OptimConst<fp_t>;
+        using LineSearchImp = typename LSBaseSolver<fp_t, false>::LineSearchImp;
+
+        using BaseSolver<fp_t>::iter;
+        using LSBaseSolver<fp_t, false>::ls;
+
+    private:
+        std::shared_ptr<Problem> prob;
+        Model model;    ///< kept across solve() calls
+        Mat<fp_t> xbar; ///< Cauchy point, then subspace minimizer
+
+    public:
+        Mat<fp_t> lower; ///< lower bound, same shape as x
+        Mat<fp_t> upper; ///< upper bound, same shape as x
+
+        int max_iter = 100; ///< max number of iterations
+        fp_t ftol = 1e-9;   ///< stop if (f_k - f_{k+1}) / max(|f_k|, |f_{k+1}|, 1) < ftol
+        fp_t gtol = 1e-5;   ///< stop if |P(x - g) - x|_inf < gtol
+        int m = 4;          ///< number of memory
+        int status;         // wether solve successfully
+
+    private:
+        /// @brief infinity norm of the projected gradient
+        fp_t proj_grad_norm(const Mat<fp_t> &x, const Mat<fp_t> &g) const
+        {
+            fp_t nrm = 0;
+            for (Index i = 0; i < BMO_SIZE(x); i++)
+            {
+                const fp_t pg = std::min(std::max(x(i) - g(i), lower(i)), upper(i)) - x(i);
+                nrm = std::max(nrm, std::abs(pg));
+            }
+            return nrm;
+        }
+
+        /// @brief largest step along d that stays inside the box
+        fp_t max_feasible_step(const Mat<fp_t> &x, const Mat<fp_t> &d) const
+        {
+            fp_t step = Constant::inf;
+            for (Index i = 0; i < BMO_SIZE(x); i++)
+                if (d(i) > 0)
+                    step = std::min(step, (upper(i) - x(i)) / d(i));
+                else if (d(i) < 0)
+                    step = std::min(step, (lower(i) - x(i)) / d(i));
+            return step;
+        }
+
+        /// @brief d = subspace minimizer - x
+        /// @return false if x is a stationary point
+        bool update_direction(LineSearchArgs<fp_t, false> &arg)
+        {
+            if (!model.cauchy_point(arg.cur_x, arg.cur_grad, lower, upper,
+                                    xbar, arg.direction))
+                return false;
+            model.subspace_min(arg.cur_x, arg.cur_grad, lower, upper,
+                               xbar, arg.direction);
+            arg.direction = xbar - arg.cur_x;
+            return true;
+        }
+
+    public:
+        explicit LBFGSB(
+            std::shared_ptr<Problem> prob,
+            const Mat<fp_t> &lower,
+            const Mat<fp_t> &upper)
+            : lower(lower), upper(upper)
+        {
+            this->prob = prob;
+            this->ls = std::make_shared<MTLS<fp_t, false>>();
+        }
+
+        explicit LBFGSB(
+            std::shared_ptr<Problem> prob,
+            const Mat<fp_t> &lower,
+            const Mat<fp_t> &upper,
+            std::shared_ptr<LineSearchImp> ls)
+            : lower(lower), upper(upper)
+        {
+            this->prob = prob;
+            this->ls = ls;
+        }
+
+        fp_t solve(Mat<fp_t> &x) override
+        {
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("LBFGSB");
+            const Index n = BMO_ROWS(x),
+                        k = BMO_COLS(x);
+            optim_assert(BMO_ROWS(lower) == n && BMO_COLS(lower) == k &&
+                             BMO_ROWS(upper) == n && BMO_COLS(upper) == k,
+                         "bounds must have the same shape as x.");
+            // start from the projection of x onto the box
+            for (Index i = 0; i < n * k; i++)
+                x(i) = std::min(std::max(x(i), lower(i)), upper(i));
+            auto &arg = this->prepare_workspace(x);
+            model.reset(n * k, n, k, m);
+            BMO_RESIZE(xbar, n, k);
+            const fp_t max_step = ls->max_step;
+            fp_t f_diff;
+            arg.update_cur_loss_grad(this->prob.get());
+            ls->init(this->prob, arg);
+            status = 0;
+            internal::NoMallocScope no_malloc;
+            for (iter = 0; iter < max_iter; iter++)
+            {
+                internal::trace::Span trace_iter("iter");
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                    if (proj_grad_norm(arg.cur_x, arg.cur_grad) < gtol)
+                        break;
+                }
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    if (!update_direction(arg))
+                        break;
+                    if (BMO_MAT_DOT_PROD(arg.direction, arg.cur_grad) >= 0)
+                        OPTIM_UNLIKELY
+                        { // the model went bad, restart from B = I
+                            logger.warn("[LBFGSB] not a descent direction, reset memory.");
+                            model.clear();
+                            if (!update_direction(arg) ||
+                                BMO_MAT_DOT_PROD(arg.direction, arg.cur_grad) >= 0)
+                                break;
+                        }
+                }
+                // stay inside the box during the line search
+                ls->max_step = std::min(
+                    max_step, max_feasible_step(arg.cur_x, arg.direction));
+                if (model.memory.empty())
+                    arg.step = std::min(fp_t(1) / BMO_FRO_NORM(arg.direction),
+                                        ls->max_step);
+                else
+                    arg.step = std::min(fp_t(1), ls->max_step);
+                arg.flush();
+                ls->line_search(arg);
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    model.push(arg);
+                }
+                f_diff = (arg.prev_loss - arg.cur_loss) /
+                         std::max({std::abs(arg.prev_loss), std::abs(arg.cur_loss), fp_t(1)});
+                logger.trace("[LBFGSB] iter: {:<5d}| loss: {:<16g}| step: {:<10g}| f_diff: {:<10g}",
+                             iter, arg.cur_loss, arg.step, f_diff);
+                if (f_diff < ftol)
+                {
+                    iter++;
+                    break;
+                }
+            }
+            if (iter == max_iter)
+                status = 1;
+            ls->max_step = max_step;
+            BMO_SWAP(x, arg.cur_x);
+            return arg.cur_loss;
+        };
+
+        void release() override
+        {
+            model.release();
+            BMO_RESIZE(xbar, 0, 0);
+            LSBaseSolver<fp_t, false>::release();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,291 @@
+#pragma once
+#include "LBFGS.ipp"
+#include "misc/malloc_guard.hpp"
+#include <algorithm>
+#include <vector>
+// reference: Byrd, Lu, Nocedal, Zhu. A limited memory algorithm for bound
+// constrained optimization. 1995.
+/// @cond
+namespace optim
+{
+    namespace internal::LBFGSB
+    {
+        using internal::LBFGS::Storage;
+
+        /// @brief compact L-BFGS model B = theta I - W M W^T, W = [Y theta S]
+        /// @details pairs live in a CircularArray in chronological order, S^T Y and S^T S are kept alongside and only the new row/column is computed when a pair is pushed.
+        template <typename fp_t>
+        class Model
+        {
+            using Constant = OptimConst<fp_t>;
+
+            int m = 0;
+            Mat<fp_t> SY, SS; // SY(i, j) = s_i^T y_j, chronological
+            Mat<fp_t> Minv;   // [-D L^T; L theta S^T S]
+            Storage<fp_t> sy; // buffers of the next pair
+
+            // generalized Cauchy point
+            Mat<fp_t> brk;            // breakpoints
+            std::vector<Index> heap;  // indices of finite breakpoints
+            std::vector<Index> free;  // free variables at the Cauchy point
+            Mat<fp_t> p, c, w, Mp, Mc, Mw; // 2m vectors
+            Mat<fp_t> K, N; // W_F^T W_F, I - M K / theta
+
+        public:
+            CircularArray<Storage<fp_t>> memory;
+            Mat<fp_t> M; ///< middle matrix of the compact form
+            fp_t theta = 1;
+
+            void reset(Index nk, Index n, Index k, int mem)
+            {
+                m = mem, theta = 1;
+                memory.reset(m);
+                for (int i = 0; i < m; i++)
+                {
+                    BMO_RESIZE(memory.data[i].s, n, k);
+                    BMO_RESIZE(memory.data[i].y, n, k);
+                }
+                BMO_RESIZE(sy.s, n, k), BMO_RESIZE(sy.y, n, k);
+                BMO_RESIZE(SY, m, m), BMO_RESIZE(SS, m, m);
+                BMO_RESIZE(brk, nk, 1);
+                heap.reserve(nk), free.reserve(nk);
+                heap.clear(), free.clear();
+                update_middle();
+            }
+
+            void release()
+            {
+                memory.reset(0);
+                sy = Storage<fp_t>();
+                BMO_RESIZE(SY, 0, 0), BMO_RESIZE(SS, 0, 0);
+                BMO_RESIZE(Minv, 0, 0), BMO_RESIZE(M, 0, 0);
+                BMO_RESIZE(brk, 0, 0), BMO_RESIZE(K, 0, 0);
+                BMO_RESIZE(N, 0, 0);
+                heap = std::vector<Index>(), free = std::vector<Index>();
+            }
+
+            /// @brief forget all pairs, B = I
+            void clear()
+            {
+                memory.clear(), theta = 1;
+                update_middle();
+            }
+
+            /// @brief store the pair s = cur_x - prev_x, y = cur_grad - prev_grad
+            /// @return false if the pair violates the curvature condition and is skipped
+            template <typename Args>
+            bool push(Args &arg)
+            {
+                sy.s = arg.cur_x - arg.prev_x;
+                sy.y = arg.cur_grad - arg.prev_grad;
+                const fp_t sTy = BMO_MAT_DOT_PROD(sy.s, sy.y),
+                           yTy = BMO_SQUARE_NORM(sy.y);
+                if (!(sTy > Constant::eps * yTy))
+                    OPTIM_UNLIKELY return false;
+                if (memory.size() == m)
+                    for (int i = 0; i + 1 < m; i++) // drop the oldest pair
+                        for (int j = 0; j + 1 < m; j++)
+                            SY(i, j) = SY(i + 1, j + 1), SS(i, j) = SS(i + 1, j + 1);
+                memory.push_back(std::move(sy)); // sy takes the dropped buffers
+                const int len = memory.size(), k = len - 1;
+                const auto &s = memory[k].s, &y = memory[k].y;
+                for (int j = 0; j < k; j++)
+                {
+                    SY(k, j) = BMO_MAT_DOT_PROD(s, memory[j].y);
+                    SY(j, k) = BMO_MAT_DOT_PROD(memory[j].s, y);
+                    SS(k, j) = SS(j, k) = BMO_MAT_DOT_PROD(s, memory[j].s);
+                }
+                SY(k, k) = sTy, SS(k, k) = BMO_SQUARE_NORM(s);
+                theta = yTy / sTy;
+                update_middle();
+                return true;
+            }
+
+            /// @brief row i of W = [Y theta S]
+            OPTIM_INLINE void row(Index i, Mat<fp_t> &out)
+            {
+                const int len = memory.size();
+                for (int j = 0; j < len; j++)
+                {
+                    out(j) = memory[j].y(i);
+                    out(len + j) = theta * memory[j].s(i);
+                }
+            }
+
+            /// @brief generalized Cauchy point along the projected steepest descent path
+            /// @param d on exit the part of the path left after the last breakpoint, zero on fixed variables
+            /// @return false if x is a stationary point
+            bool cauchy_point(
+                const Mat<fp_t> &x, const Mat<fp_t> &g,
+                const Mat<fp_t> &lower, const Mat<fp_t> &upper,
+                Mat<fp_t> &xcp, Mat<fp_t> &d)
+            {
+                const Index nk = BMO_SIZE(x);
+                const int len = memory.size();
+                heap.clear();
+                fp_t fp = 0; // f'(0) = -d^T d
+                for (Index i = 0; i < nk; i++)
+                {
+                    fp_t t = Constant::inf;
+                    if (g(i) < 0 && upper(i) < Constant::inf)
+                        t = (x(i) - upper(i)) / g(i);
+                    else if (g(i) > 0 && lower(i) > -Constant::inf)
+                        t = (x(i) - lower(i)) / g(i);
+                    brk(i) = t, xcp(i) = x(i);
+                    if (t <= 0)
+                        d(i) = 0; // already on the bound it is pushed to
+                    else
+                    {
+                        d(i) = -g(i), fp -= g(i) * g(i);
+                        if (t < Constant::inf)
+                            heap.push_back(i);
+                    }
+                }
+                if (fp == 0)
+                    return false;
+                BMO_SET_ZERO(c);
+                for (int j = 0; j < len; j++)
+                { // p = W^T d
+                    p(j) = BMO_MAT_DOT_PROD(memory[j].y, d);
+                    p(len + j) = theta * BMO_MAT_DOT_PROD(memory[j].s, d);
+                }
+                fp_t fpp = -theta * fp;
+                const fp_t fpp0 = fpp * Constant::eps;
+                if (len > 0)
+                {
+                    BMO_NOALIAS(Mp) = M * p;
+                    fpp -= BMO_MAT_DOT_PROD(p, Mp);
+                }
+                fp_t dt_min = -fp / fpp, t_old = 0;
+                const auto later = [this](Index a, Index b)
+                { return brk(a) > brk(b); };
+                std::make_heap(heap.begin(), heap.end(), later);
+                while (!heap.empty())
+                {
+                    const Index b = heap.front();
+                    const fp_t dt = brk(b) - t_old;
+                    if (dt_min < dt)
+                        break;
+                    std::pop_heap(heap.begin(), heap.end(), later);
+                    heap.pop_back();
+                    // x_b reaches its bound
+                    xcp(b) = d(b) > 0 ? upper(b) : lower(b);
+                    const fp_t gb = g(b), zb = xcp(b) - x(b);
+                    fp += dt * fpp + gb * gb + theta * gb * zb;
+                    fpp -= theta * gb * gb;
+                    if (len > 0)
+                    {
+                        c += dt * p;
+                        row(b, w);
+                        BMO_NOALIAS(Mc) = M * c;
+                        BMO_NOALIAS(Mp) = M * p;
+                        BMO_NOALIAS(Mw) = M * w;
+                        fp -= gb * BMO_MAT_DOT_PROD(w, Mc);
+                        fpp -= 2 * gb * BMO_MAT_DOT_PROD(w, Mp) +
+                               gb * gb * BMO_MAT_DOT_PROD(w, Mw);
+                        p += gb * w;
+                    }
+                    fpp = std::max(fpp0, fpp);
+                    d(b) = 0;
+                    dt_min = -fp / fpp;
+                    t_old = brk(b);
+                }
+                dt_min = std::max(dt_min, fp_t(0));
+                t_old += dt_min;
+                for (Index i = 0; i < nk; i++)
+                    if (d(i) != 0)
+                        xcp(i) = x(i) + t_old * d(i);
+                if (len > 0)
+                    c += dt_min * p;
+                return true;
+            }
+
+            /// @brief minimize the model over the free variables of the Cauchy point
+            /// @details direct primal method, the result is truncated to stay inside the box.
+            /// @param xbar on entry the Cauchy point, on exit the subspace minimizer
+            /// @param du storage of the free-variable step
+            void subspace_min(
+                const Mat<fp_t> &x, const Mat<fp_t> &g,
+                const Mat<fp_t> &lower, const Mat<fp_t> &upper,
+                Mat<fp_t> &xbar, Mat<fp_t> &du)
+            {
+                const Index nk = BMO_SIZE(x);
+                const int len = memory.size();
+                free.clear();
+                for (Index i = 0; i < nk; i++)
+                    if (xbar(i) > lower(i) && xbar(i) < upper(i))
+                        free.push_back(i);
+                if (free.empty())
+                    return;
+                // reduced gradient r = g + theta (xcp - x) - W M c
+                if (len > 0)
+                {
+                    BMO_NOALIAS(Mc) = M * c;
+                    BMO_SET_ZERO(Mp), BMO_SET_ZERO(K);
+                }
+                for (Index i : free)
+                {
+                    du(i) = g(i) + theta * (xbar(i) - x(i));
+                    if (len > 0)
+                    {
+                        row(i, w);
+                        du(i) -= BMO_MAT_DOT_PROD(w, Mc);
+                        Mp += du(i) * w;                      // W_F^T r
+                        BMO_NOALIAS(K) += w * BMO_TRANSPOSE(w); // W_F^T W_F
+                    }
+                }
+                if (len > 0)
+                { // v = (I - M W_F^T W_F / theta)^{-1} M W_F^T r
+                    BMO_NOALIAS(N) = M * K;
+                    N *= -1 / theta;
+                    for (int j = 0; j < 2 * len; j++)
+                        N(j, j) += 1;
+                    BMO_NOALIAS(Mc) = M * Mp;
+                    internal::AllowMallocScope allow_malloc; // 2m x 2m LU
+                    Mp = BMO_LU_SOLVE(N, Mc);
+                }
+                // du = -r / theta - W_F v / theta^2, truncated to the box
+                fp_t alpha = 1;
+                for (Index i : free)
+                {
+                    fp_t di = -du(i) / theta;
+                    if (len > 0)
+                    {
+                        row(i, w);
+                        di -= BMO_MAT_DOT_PROD(w, Mp) / (theta * theta);
+                    }
+                    du(i) = di;
+                    if (di > 0)
+                        alpha = std::min(alpha, (upper(i) - xbar(i)) / di);
+                    else if (di < 0)
+                        alpha = std::min(alpha, (lower(i) - xbar(i)) / di);
+                }
+                for (Index i : free)
+                    xbar(i) += alpha * du(i);
+            }
+
+        private:
+            /// @brief size the 2m-dimensional buffers, only allocates while the memory fills
+            void update_middle()
+            {
+                const int len = memory.size();
+                internal::AllowMallocScope allow_malloc;
+                BMO_RESIZE(p, 2 * len, 1), BMO_RESIZE(c, 2 * len, 1);
+                BMO_RESIZE(w, 2 * len, 1), BMO_RESIZE(Mp, 2 * len, 1);
+                BMO_RESIZE(Mc, 2 * len, 1), BMO_RESIZE(Mw, 2 * len, 1);
+                BMO_RESIZE(K, 2 * len, 2 * len), BMO_RESIZE(N, 2 * len, 2 * len);
+                BMO_RESIZE(Minv, 2 * len, 2 * len);
+                for (int i = 0; i < len; i++)
+                    for (int j = 0; j < len; j++)
+                    {
+                        Minv(i, j) = i == j ? -SY(i, i) : fp_t(0);
+                        Minv(len + i, j) = i > j ? SY(i, j) : fp_t(0); // L
+                        Minv(j, len + i) = Minv(len + i, j);            // L^T
+                        Minv(len + i, len + j) = theta * SS(i, j);
+                    }
+                M = BMO_INVERSE(Minv);
+            }
+        };
+    }
+}
+/// @endcond
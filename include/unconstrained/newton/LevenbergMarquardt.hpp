@@ -0,0 +1,309 @@
+#pragma once
+#ifndef _OPTIM_NEWTON_LEVENBERG_MARQUARDT_HPP_
+#define _OPTIM_NEWTON_LEVENBERG_MARQUARDT_HPP_
+
+#include "base/BaseSolver.hpp"
+#include "base/LeastSquaresProblem.hpp"
+#include "functions/functions.hpp"
+#include "misc/malloc_guard.hpp"
+
+namespace optim
+{
+    /// @brief Levenberg-Marquardt method for nonlinear least squares
+    /// @details Each step solves the damped Gauss-Newton system \f$ (J^T J + \lambda D) d = -J^T r \f$ and is accepted if the ratio \f$ \rho \f$ of actual to predicted decrease exceeds `eta`, after which \f$ \lambda \f$ shrinks by \f$ \max(1/3, 1 - (2\rho - 1)^3) \f$; otherwise it grows by a factor that doubles on every rejection (Nielsen's update). With a dense Jacobian, D is the running maximum of diag(J^T J) (More's scaling) and the scaled J^T J is eigendecomposed once per Jacobian, so every damping tried at a point costs products with the eigenvectors instead of a new factorization. With a sparse Jacobian or Jacobian products, D = I and the system is solved as \f$ \min |J d + r|^2 + \lambda |d|^2 \f$ by LSQR, which never forms J^T J. With `geodesic`, the step adds half the geodesic acceleration a of Transtrum & Sethna: the same system solved for the second directional derivative of r along d, estimated by one more residual evaluation. Steps with \f$ 2|a| / |d| > \f$ `max_accel_ratio`, in the norm scaled by \f$ D^{1/2} \f$, are rejected. It saves Jacobians on curved valleys at the cost of residual evaluations, so it pays off when the Jacobian is the expensive part.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class LevenbergMarquardt final
+        : public BaseSolver<fp_t>
+    {
+    public:
+        using Constant = OptimConst<fp_t>;
+        using Problem = LeastSquaresProblem<fp_t>;
+
+        using BaseSolver<fp_t>::iter;
+
+    private:
+        std::shared_ptr<Problem> prob;
+        JacobianType jac_type;
+        Mat<fp_t> r, r_trial, r_vv, Jd, g, d, a, x_trial; ///< kept across solve() calls
+        Mat<fp_t> J, JtJ, V, eigval, diag, scale, q, c;   ///< dense Jacobian and the eigendecomposition of the scaled J^T J
+        SpMat<fp_t> sp_J;
+        fn::lsqrWorkspace<fp_t> lsqr_ws;
+
+    public:
+        int max_iter = 100;
+        fp_t xtol = 1e-10;           ///< stop if |x_{k+1} - x_k| < xtol and |f_{k+1} - f_k| < ftol
+        fp_t ftol = 1e-10;           ///< relative to 1 + |f_{k+1}|
+        fp_t gtol = 1e-8;            ///< stop if |J^T r| < gtol
+        fp_t init_damping = 1e-3;    ///< initial damping, relative to diag(J^T J) or to an estimate of |J|^2 with LSQR
+        fp_t max_damping = 1e16;     ///< stop if the relative damping grows beyond
+        fp_t eta = 1e-4;             ///< accept a step if the actual decrease is eta times the predicted one
+        bool geodesic = false;       ///< add the geodesic acceleration to the steps
+        fp_t geodesic_h = 0.02;      ///< finite-difference step along d for the second directional derivative
+        fp_t max_accel_ratio = 0.75; ///< reject steps with 2|a|/|d| above, scaled by D^{1/2}
+        int max_lsqr_iter = -1;      ///< max LSQR iterations per solve, -1 for the problem size
+        fp_t lsqr_tol = 1e-10;       ///< relative tolerance of LSQR
+        fp_t damping;                ///< relative damping at the end of the last solve()
+        int n_eval = 0;              ///< residual evaluations in the last solve(), geodesic probes included
+        int n_jac = 0;               ///< Jacobian evaluations in the last solve()
+        int n_factor = 0;            ///< eigendecompositions of J^T J in the last solve()
+        int n_lsqr_iter = 0;         ///< LSQR iterations in the last solve()
+        int status;                  ///< 0 converged, 1 reaches max_iter, 2 damping beyond max_damping
+
+        explicit LevenbergMarquardt(std::shared_ptr<Problem> prob) : prob(prob) {}
+
+        /// @param x n x 1 initial point
+        fp_t solve(Mat<fp_t> &x) override
+        {
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("LM");
+            const Index n = BMO_ROWS(x),
+                        m = prob->n_residuals();
+            prepare_workspace(m, n);
+            n_eval = n_jac = n_factor = n_lsqr_iter = 0;
+            fp_t f = eval(x, r), g_nrm,
+                 ref = 1, // damping unit, |J|^2 estimate with LSQR
+                nu = 2;
+            damping = init_damping;
+            bool moved = true; // the Jacobian has to follow x
+            status = 1;
+            internal::NoMallocScope no_malloc;
+            for (iter = 1; iter <= max_iter; iter++)
+            {
+                internal::trace::Span trace_iter("iter");
+                if (moved)
+                {
+                    {
+                        internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                        g_nrm = update_jacobian(x);
+                    }
+                    if (g_nrm < gtol)
+                    {
+                        status = 0;
+                        break;
+                    }
+                    if (iter == 1 && jac_type != JacobianType::Dense)
+                        ref = g_nrm * g_nrm / BMO_SQUARE_NORM(r); // |J^T r|/|r| <= |J|
+                }
+                const fp_t lambda = damping * ref;
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    damped_solve(r, g, lambda, d);
+                }
+                fp_t rho = -Constant::inf, accel = 0;
+                if (geodesic)
+                { // r_vv ~ D^2 r(x)[d, d] by finite differences along d
+                    const fp_t h = geodesic_h;
+                    x_trial = x + h * d;
+                    eval(x_trial, r_trial);
+                    jac_vec(d, Jd);
+                    r_vv = (2 / h) * ((r_trial - r) / h - Jd);
+                    if (jac_type == JacobianType::Dense)
+                        BMO_NOALIAS(a) = BMO_TRANSPOSE(J) * r_vv;
+                    damped_solve(r_vv, a, lambda, a);
+                    accel = 2 * scaled_norm(a) / scaled_norm(d);
+                    if (accel <= max_accel_ratio)
+                        d += fp_t(0.5) * a;
+                }
+                const fp_t step_nrm = BMO_FRO_NORM(d);
+                fp_t f_trial = f;
+                if (!geodesic || accel <= max_accel_ratio)
+                {
+                    x_trial = x + d;
+                    f_trial = eval(x_trial, r_trial);
+                    // m(0) - m(d) = -(g^T d + |J d|^2 / 2)
+                    jac_vec(d, Jd);
+                    const fp_t pred = -(BMO_MAT_DOT_PROD(g, d) + fp_t(0.5) * BMO_SQUARE_NORM(Jd)),
+                               noise = 10 * Constant::eps * std::max(fp_t(1), std::abs(f));
+                    rho = (f - f_trial + noise) / (pred + noise);
+                }
+                moved = rho > eta;
+                if (moved)
+                {
+                    const fp_t t = 2 * rho - 1;
+                    damping *= std::max(fp_t(1) / 3, 1 - t * t * t);
+                    nu = 2;
+                }
+                else
+                {
+                    damping *= nu;
+                    nu *= 2;
+                }
+                logger.trace("[LM] iter: {:<5d}| loss: {:<16g}| g_nrm: {:<12g}| damping: {:<10g}| rho: {:<10g}| accel: {:<10g}",
+                             iter, f, g_nrm, damping, rho, accel);
+                if (moved)
+                {
+                    const fp_t f_diff = std::abs(f - f_trial) / (std::abs(f_trial) + fp_t(1));
+                    BMO_SWAP(x, x_trial);
+                    BMO_SWAP(r, r_trial);
+                    f = f_trial;
+                    if (step_nrm < xtol && f_diff < ftol)
+                    {
+                        status = 0;
+                        break;
+                    }
+                }
+                if (damping > max_damping)
+                {
+                    status = 2;
+                    logger.warn("[LM] damping {:g} beyond max_damping.", damping);
+                    break;
+                }
+            }
+            return f;
+        }
+
+        /// @brief free the memory kept for the next solve() call
+        void release()
+        {
+            BMO_RESIZE(r, 0, 0), BMO_RESIZE(r_trial, 0, 0), BMO_RESIZE(r_vv, 0, 0);
+            BMO_RESIZE(Jd, 0, 0), BMO_RESIZE(g, 0, 0), BMO_RESIZE(d, 0, 0);
+            BMO_RESIZE(a, 0, 0), BMO_RESIZE(x_trial, 0, 0);
+            BMO_RESIZE(J, 0, 0), BMO_RESIZE(JtJ, 0, 0), BMO_RESIZE(V, 0, 0);
+            BMO_RESIZE(eigval, 0, 0), BMO_RESIZE(diag, 0, 0), BMO_RESIZE(scale, 0, 0);
+            BMO_RESIZE(q, 0, 0), BMO_RESIZE(c, 0, 0);
+            sp_J = SpMat<fp_t>();
+            lsqr_ws.resize(0, 0);
+        }
+
+    private:
+        void prepare_workspace(Index m, Index n)
+        {
+            jac_type = prob->jacobian_type();
+            BMO_RESIZE(r, m, 1), BMO_RESIZE(r_trial, m, 1);
+            BMO_RESIZE(r_vv, m, 1), BMO_RESIZE(Jd, m, 1);
+            BMO_RESIZE(g, n, 1), BMO_RESIZE(d, n, 1);
+            BMO_RESIZE(a, n, 1), BMO_RESIZE(x_trial, n, 1);
+            switch (jac_type)
+            {
+            case JacobianType::Dense:
+                BMO_RESIZE(J, m, n), BMO_RESIZE(JtJ, n, n), BMO_RESIZE(V, n, n);
+                BMO_RESIZE(eigval, n, 1), BMO_RESIZE(scale, n, 1);
+                BMO_RESIZE(q, n, 1), BMO_RESIZE(c, n, 1);
+                BMO_RESIZE(diag, n, 1);
+                BMO_SET_ZERO(diag);
+                break;
+            case JacobianType::Sparse:
+                BMO_RESIZE(sp_J, m, n);
+                lsqr_ws.resize(m, n);
+                break;
+            case JacobianType::Operator:
+                lsqr_ws.resize(m, n);
+                break;
+            }
+        }
+
+        OPTIM_INLINE fp_t eval(const Mat<fp_t> &x, Mat<fp_t> &out_r)
+        {
+            internal::AllowMallocScope allow_malloc;
+            n_eval++;
+            internal::instrument::count(internal::instrument::Eval::Loss);
+            internal::trace::Span trace("residual");
+            prob->residual(x, out_r);
+            return fp_t(0.5) * BMO_SQUARE_NORM(out_r);
+        }
+
+        /// @brief move the Jacobian to x, with g = J^T r
+        /// @return |g|
+        fp_t update_jacobian(const Mat<fp_t> &x)
+        {
+            // J^T J and its eigendecomposition may allocate, once per point
+            internal::AllowMallocScope allow_malloc;
+            n_jac++;
+            internal::instrument::count(internal::instrument::Eval::Grad);
+            internal::trace::Span trace("jacobian");
+            switch (jac_type)
+            {
+            case JacobianType::Dense:
+                prob->jacobian(x, J);
+                BMO_NOALIAS(g) = BMO_TRANSPOSE(J) * r;
+                BMO_NOALIAS(JtJ) = BMO_TRANSPOSE(J) * J;
+                for (Index i = 0; i < BMO_SIZE(diag); i++)
+                {
+                    diag(i) = std::max(diag(i), JtJ(i, i));
+                    scale(i) = diag(i) > 0 ? 1 / std::sqrt(diag(i)) : fp_t(1);
+                }
+                JtJ = BMO_AS_DIAG(scale) * JtJ * BMO_AS_DIAG(scale);
+                BMO_EIG_SYM(eigval, V, JtJ);
+                for (Index i = 0; i < BMO_SIZE(eigval); i++)
+                    eigval(i) = std::max(eigval(i), fp_t(0));
+                n_factor++;
+                break;
+            case JacobianType::Sparse:
+                prob->sp_jacobian(x, sp_J);
+                BMO_NOALIAS(g) = BMO_TRANSPOSE(sp_J) * r;
+                break;
+            case JacobianType::Operator:
+                prob->update_jac(x);
+                prob->jac_backward(r, g);
+                break;
+            }
+            return BMO_FRO_NORM(g);
+        }
+
+        /// @brief |D^{1/2} v|
+        OPTIM_INLINE fp_t scaled_norm(const Mat<fp_t> &v) const
+        {
+            return jac_type == JacobianType::Dense
+                       ? BMO_FRO_NORM(BMO_ARRAY_DIV(v, scale))
+                       : BMO_FRO_NORM(v);
+        }
+
+        OPTIM_INLINE void jac_vec(const Mat<fp_t> &v, Mat<fp_t> &out)
+        {
+            switch (jac_type)
+            {
+            case JacobianType::Dense:
+                BMO_NOALIAS(out) = J * v;
+                break;
+            case JacobianType::Sparse:
+                BMO_NOALIAS(out) = sp_J * v;
+                break;
+            case JacobianType::Operator:
+            {
+                internal::AllowMallocScope allow_malloc;
+                prob->jac_forward(v, out);
+                break;
+            }
+            }
+        }
+
+        OPTIM_INLINE void jac_t_vec(const Mat<fp_t> &u, Mat<fp_t> &out)
+        {
+            if (jac_type == JacobianType::Sparse)
+                BMO_NOALIAS(out) = BMO_TRANSPOSE(sp_J) * u;
+            else
+            {
+                internal::AllowMallocScope allow_malloc;
+                prob->jac_backward(u, out);
+            }
+        }
+
+        /// @brief out = -(J^T J + lambda D)^{-1} J^T res
+        /// @param jt_res J^T res, only read with a dense Jacobian and may alias out
+        void damped_solve(const Mat<fp_t> &res, const Mat<fp_t> &jt_res,
+                          fp_t lambda, Mat<fp_t> &out)
+        {
+            if (jac_type == JacobianType::Dense)
+            { // D^{-1/2} V (Lambda + lambda I)^{-1} V^T D^{-1/2}
+                q = BMO_ARRAY_MUL(scale, jt_res);
+                BMO_NOALIAS(c) = BMO_TRANSPOSE(V) * q;
+                c = BMO_ARRAY_DIV(c, BMO_ARRAY_ADD_SCALAR(eigval, lambda));
+                BMO_NOALIAS(out) = V * c;
+                out = -BMO_ARRAY_MUL(scale, out);
+                return;
+            }
+            // argmin |J out + res|^2 + lambda |out|^2, solved for -out
+            fn::lsqr([this](const Mat<fp_t> &v, Mat<fp_t> &Jv)
+                     { jac_vec(v, Jv); },
+                     [this](const Mat<fp_t> &u, Mat<fp_t> &Jtu)
+                     { jac_t_vec(u, Jtu); },
+                     res, std::sqrt(lambda), out, lsqr_ws,
+                     fn::lsqrParams<fp_t>{max_lsqr_iter, lsqr_tol});
+            n_lsqr_iter += lsqr_ws.n_iter;
+            out = -out;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,188 @@
+#pragma once
+#ifndef _OPTIM_NEWTON_NEWTON_CG_HPP_
+#define _OPTIM_NEWTON_NEWTON_CG_HPP_
+
+#include "line_search/More_Thuente.hpp"
+#include "Preconditioner.hpp"
+
+namespace optim
+{
+    /// @brief Truncated (inexact) Newton method with preconditioned CG
+    /// @details The Newton system H d = -g is solved matrix-free by CG on `HessProblem::hess_forward`, only to the relative accuracy |H d + g| <= eta_k |g|. eta_k follows the Eisenstat-Walker choice 2, loose far from the solution and tightening as |g| drops, which keeps the number of Hessian-vector products per outer step low. CG stops at the first direction of non-positive curvature and returns the iterate so far (or the preconditioned steepest descent direction on the first inner step), so d is always a descent direction.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class NewtonCG final
+        : public LSBaseSolver<fp_t>
+    {
+    public:
+        using Constant = OptimConst<fp_t>;
+        using Problem = HessProblem<fp_t>;
+        using Precond = CGPreconditioner<fp_t>;
+        using LineSearchImp = typename LSBaseSolver<fp_t, false>::LineSearchImp;
+
+        using BaseSolver<fp_t>::iter;
+        using LSBaseSolver<fp_t>::ls;
+
+    private:
+        std::shared_ptr<Problem> prob;
+        Mat<fp_t> r, z, p, Hp; ///< CG workspace, kept across solve() calls
+
+    public:
+        std::shared_ptr<Precond> precond;
+
+        int max_iter = 100;
+        int max_cg_iter = -1; ///< max CG iterations per outer step, -1 for the problem size
+        fp_t xtol = 1e-10;
+        fp_t ftol = 1e-6;
+        fp_t gtol = 1e-6;
+        fp_t eta_max = 0.9;                      ///< upper bound of the forcing term
+        fp_t ew_gamma = 0.9;                     ///< Eisenstat-Walker gamma
+        fp_t ew_alpha = 0.5 * (1 + std::sqrt(5.)); ///< Eisenstat-Walker alpha
+        int n_hess_vec = 0;                      ///< Hessian-vector products in the last solve()
+        int status;
+
+        explicit NewtonCG(std::shared_ptr<Problem> prob)
+        {
+            this->prob = prob;
+            this->ls = std::make_shared<MTLS<fp_t, false>>();
+            precond = std::make_shared<Precond>();
+        }
+
+        explicit NewtonCG(
+            std::shared_ptr<Problem> prob,
+            std::shared_ptr<LineSearchImp> ls)
+        {
+            this->prob = prob;
+            this->ls = ls;
+            precond = std::make_shared<Precond>();
+        }
+
+        fp_t solve(Mat<fp_t> &x) override
+        {
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("NewtonCG");
+            const Index n = BMO_ROWS(x),
+                        k = BMO_COLS(x);
+            auto &arg = this->prepare_workspace(x);
+            BMO_RESIZE(r, n, k), BMO_RESIZE(z, n, k);
+            BMO_RESIZE(p, n, k), BMO_RESIZE(Hp, n, k);
+            n_hess_vec = 0;
+            fp_t f_diff, x_diff_nrm, g_nrm, g_nrm_old, eta = 0.5;
+            arg.update_cur_loss_grad(prob.get());
+            ls->init(prob, arg);
+            precond->init(*prob, arg);
+            g_nrm = BMO_FRO_NORM(arg.cur_grad);
+            status = 1;
+            internal::NoMallocScope no_malloc;
+            for (iter = 1; iter <= max_iter; iter++)
+            {
+                internal::trace::Span trace_iter("iter");
+                if (g_nrm < Constant::eps)
+                {
+                    status = 0;
+                    break;
+                }
+                int cg_iter;
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    {
+                        internal::AllowMallocScope allow_malloc;
+                        internal::trace::Span trace("update_hess");
+                        prob->update_hess(arg.cur_x);
+                    }
+                    precond->update(*prob, arg);
+                    cg_iter = truncated_cg(arg, eta * g_nrm);
+                }
+                arg.flush();
+                arg.step = 1.;
+                ls->line_search(arg);
+                g_nrm_old = g_nrm;
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                    g_nrm = BMO_FRO_NORM(arg.cur_grad);
+                    x_diff_nrm = BMO_FRO_NORM(arg.direction) * arg.step;
+                    f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
+                             (std::abs(arg.cur_loss) + fp_t(1));
+                }
+                logger.trace("[NewtonCG] iter: {:<5d}| loss: {:<16g}| g_nrm: {:<12g}| eta: {:<10g}| cg_iter: {:<5d}",
+                             iter, arg.cur_loss, g_nrm, eta, cg_iter);
+                if (g_nrm < gtol && x_diff_nrm < xtol && f_diff < ftol)
+                { // check stop criteria
+                    status = 0;
+                    break;
+                }
+                // Eisenstat-Walker choice 2 with its safeguard
+                const fp_t eta_pred = ew_gamma * std::pow(eta, ew_alpha);
+                eta = ew_gamma * std::pow(g_nrm / g_nrm_old, ew_alpha);
+                if (eta_pred > fp_t(0.1))
+                    eta = std::max(eta, eta_pred);
+                eta = std::min(eta, eta_max);
+            }
+            BMO_SWAP(x, arg.cur_x);
+            return arg.cur_loss;
+        }
+
+        void release() override
+        {
+            BMO_RESIZE(r, 0, 0), BMO_RESIZE(z, 0, 0);
+            BMO_RESIZE(p, 0, 0), BMO_RESIZE(Hp, 0, 0);
+            precond->release();
+            LSBaseSolver<fp_t, false>::release();
+        }
+
+    private:
+        OPTIM_INLINE void hess_vec(const Mat<fp_t> &v, Mat<fp_t> &out)
+        {
+            internal::AllowMallocScope allow_malloc;
+            {
+                internal::trace::Span trace("hess_vec");
+                prob->hess_forward(v, out);
+            }
+            n_hess_vec++;
+            internal::instrument::count(internal::instrument::Eval::Hess);
+        }
+
+        /// @brief approximately solve H d = -g at cur_x into arg.direction
+        /// @param tol stop when |H d + g| <= tol
+        /// @return number of CG iterations
+        int truncated_cg(LineSearchArgs<fp_t, false> &arg, const fp_t tol)
+        {
+            Mat<fp_t> &d = arg.direction;
+            const int max_cg = max_cg_iter < 0 ? int(BMO_SIZE(d)) : max_cg_iter;
+            BMO_SET_ZERO(d);
+            r = arg.cur_grad; // r = H d + g
+            precond->apply(r, z);
+            p = -z;
+            fp_t rz = BMO_MAT_DOT_PROD(r, z);
+            int j = 0;
+            for (; j < max_cg; j++)
+            {
+                hess_vec(p, Hp);
+                const fp_t pHp = BMO_MAT_DOT_PROD(p, Hp);
+                if (pHp <= Constant::eps * BMO_SQUARE_NORM(p))
+                { // non-positive curvature along p
+                    if (j == 0)
+                        d = p;
+                    break;
+                }
+                precond->record(p, Hp, pHp);
+                const fp_t alpha = rz / pHp;
+                d += alpha * p;
+                r += alpha * Hp;
+                if (BMO_FRO_NORM(r) <= tol)
+                {
+                    j++;
+                    break;
+                }
+                precond->apply(r, z);
+                const fp_t rz_new = BMO_MAT_DOT_PROD(r, z);
+                p *= rz_new / rz;
+                p -= z;
+                rz = rz_new;
+            }
+            return j;
+        }
+    };
+}
+
+#endif
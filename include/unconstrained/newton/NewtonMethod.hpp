@@ -8,20 +8,26 @@
 
 namespace optim
 {
-    template <typename fp_t>
+    /// @brief Newton's method with line search
+    /// @details the Newton step comes from `hess_backward` of the problem.
+    /// @tparam fp_t floating-point type
+    /// @tparam N number of rows of x if fixed at compile time
+    /// @tparam K number of columns of x if fixed at compile time. With both sizes fixed, `hess_backward` can solve with a fixed-size factorization on the stack.
+    template <typename fp_t, int N = Dynamic, int K = Dynamic>
     class NewtonMethod final
-        : public LSBaseSolver<fp_t>
+        : public LSBaseSolver<fp_t, false, N, K>
     {
     public:
         using Constant = OptimConst<fp_t>;
-        using Problem = HessProblem<fp_t>;
-        using LineSearchImp = typename LSBaseSolver<fp_t, false>::LineSearchImp;
+        using Problem = HessProblem<fp_t, N, K>;
+        using LineSearchImp = typename LSBaseSolver<fp_t, false, N, K>::LineSearchImp;
 
-        using BaseSolver<fp_t>::iter;
-        using LSBaseSolver<fp_t>::ls;
+        using BaseSolver<fp_t, N, K>::iter;
+        using LSBaseSolver<fp_t, false, N, K>::ls;
 
     private:
         std::shared_ptr<Problem> prob;
+        Mat<fp_t, N, K> rhs; ///< -grad, kept across solve() calls
 
     public:
         int max_iter = 100;
@@ -33,7 +39,7 @@ namespace optim
         explicit NewtonMethod(std::shared_ptr<Problem> prob)
         {
             this->prob = prob;
-            this->ls = std::make_shared<MTLS<fp_t, false>>();
+            this->ls = std::make_shared<MTLS<fp_t, false, GradProblem<fp_t, N, K>>>();
         }
 
         explicit NewtonMethod(
@@ -44,40 +50,61 @@ namespace optim
             this->ls = ls;
         }
 
-        fp_t solve(Mat<fp_t> &x) override
+        fp_t solve(Mat<fp_t, N, K> &x) override
         {
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("NewtonMethod");
             const Index n = BMO_ROWS(x),
-                        k = BMO_COLS(x),
-                        nk = n * k;
-            Mat<fp_t> H(nk, nk);
-            LineSearchArgs<fp_t, false> arg(x);
+                        k = BMO_COLS(x);
+            auto &arg = this->prepare_workspace(x);
+            BMO_RESIZE(rhs, n, k);
             fp_t f_diff, x_diff_nrm, g_nrm;
-            arg.update_cur_loss(prob.get());
-            arg.update_cur_grad(prob.get());
+            arg.update_cur_loss_grad(prob.get());
             ls->init(prob, arg);
+            internal::NoMallocScope no_malloc;
             for (iter = 1; iter <= max_iter; iter++)
             {
+                internal::trace::Span trace_iter("iter");
                 arg.flush();
-                prob->hess_backward(-arg.prev_grad, arg.direction);
+                rhs = -arg.prev_grad;
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    internal::AllowMallocScope allow_malloc;
+                    {
+                        internal::trace::Span trace("hess");
+                        prob->update_hess(arg.prev_x);
+                        prob->hess_backward(rhs, arg.direction);
+                    }
+                    internal::instrument::count(internal::instrument::Eval::Hess);
+                }
                 arg.step = 1.;
                 ls->line_search(arg);
-                g_nrm = BMO_FRO_NORM(arg.cur_grad);
-                x_diff_nrm = BMO_FRO_NORM(arg.direction) * arg.step;
-                f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
-                         (std::abs(arg.cur_loss) + fp_t(1));
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                    g_nrm = BMO_FRO_NORM(arg.cur_grad);
+                    x_diff_nrm = BMO_FRO_NORM(arg.direction) * arg.step;
+                    f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
+                             (std::abs(arg.cur_loss) + fp_t(1));
+                }
                 if ((g_nrm < gtol && x_diff_nrm < xtol && f_diff < ftol) ||
                     g_nrm < Constant::eps)
                 { // check stop criteria
                     status = 0;
-                    x = std::move(arg.cur_x);
+                    BMO_SWAP(x, arg.cur_x);
                     return arg.cur_loss;
                 }
             }
             // TODO : log
             status = 1;
-            x = std::move(arg.cur_x);
+            BMO_SWAP(x, arg.cur_x);
             return arg.cur_loss;
         }
+
+        void release() override
+        {
+            BMO_RESIZE(rhs, 0, 0);
+            LSBaseSolver<fp_t, false, N, K>::release();
+        }
     };
 }
 
@@ -0,0 +1,146 @@
+#pragma once
+#ifndef _OPTIM_NEWTON_PRECONDITIONER_HPP_
+#define _OPTIM_NEWTON_PRECONDITIONER_HPP_
+
+#include "line_search/base.hpp"
+#include "LBFGS.ipp"
+
+namespace optim
+{
+    /// @brief Preconditioner of the inner CG of NewtonCG
+    /// @details `apply` computes z = M^{-1} r for an approximation M of the Hessian. The default is the identity.
+    template <typename fp_t>
+    struct CGPreconditioner
+    {
+        using BaseArgs = BaseLineSearchArgs<fp_t>;
+        using Problem = HessProblem<fp_t>;
+
+        /// @brief called once per solve() at the initial point
+        virtual void init(Problem &, BaseArgs &){};
+
+        /// @brief called at every outer iterate cur_x, after the Hessian moved there
+        virtual void update(Problem &, BaseArgs &){};
+
+        /// @brief called by CG after every Hessian-vector product Hp with positive curvature pHp = p^T H p
+        virtual void record(const Mat<fp_t> &, const Mat<fp_t> &, fp_t){};
+
+        /// @brief z = M^{-1} r
+        virtual void apply(const Mat<fp_t> &r, Mat<fp_t> &z) { z = r; };
+
+        virtual void release(){};
+
+        virtual ~CGPreconditioner() = default;
+    };
+
+    /// @brief Jacobi preconditioner M = |diag(H)|
+    /// @details requires HessProblem::hess_diag. Entries below `min_diag` are clamped so that M stays positive definite.
+    template <typename fp_t>
+    struct DiagPreconditioner
+        : public CGPreconditioner<fp_t>
+    {
+        using BaseArgs = typename CGPreconditioner<fp_t>::BaseArgs;
+        using Problem = typename CGPreconditioner<fp_t>::Problem;
+
+        fp_t min_diag = 1e-8;
+
+    private:
+        Mat<fp_t> inv_diag;
+
+    public:
+        void init(Problem &, BaseArgs &arg) override
+        {
+            BMO_RESIZE(inv_diag, BMO_ROWS(arg.cur_x), BMO_COLS(arg.cur_x));
+        }
+
+        void update(Problem &prob, BaseArgs &) override
+        {
+            {
+                internal::AllowMallocScope allow_malloc;
+                prob.hess_diag(inv_diag);
+            }
+            for (Index i = 0; i < BMO_SIZE(inv_diag); i++)
+                inv_diag(i) = 1 / std::max(std::abs(inv_diag(i)), min_diag);
+        }
+
+        void apply(const Mat<fp_t> &r, Mat<fp_t> &z) override
+        {
+            z = BMO_ARRAY_MUL(r, inv_diag);
+        }
+
+        void release() override
+        {
+            BMO_RESIZE(inv_diag, 0, 0);
+        }
+    };
+
+    /// @brief L-BFGS preconditioner
+    /// @details M^{-1} is the L-BFGS inverse Hessian built from the last m pairs (p, Hp) of the previous CG solves (Morales and Nocedal). The pairs are exact Hessian products, so M^{-1} inverts the Hessian on the directions CG already resolved and the next solves spend their iterations elsewhere. It pays off when a few eigenvalues stand out and move slowly from one iterate to the next; a Hessian dominated by a fast-changing diagonal is better served by DiagPreconditioner. The first solve runs unpreconditioned.
+    template <typename fp_t>
+    struct LBFGSPreconditioner
+        : public CGPreconditioner<fp_t>
+    {
+        using BaseArgs = typename CGPreconditioner<fp_t>::BaseArgs;
+        using Problem = typename CGPreconditioner<fp_t>::Problem;
+        using Storage = internal::LBFGS::Storage<fp_t>;
+
+        int m = 5; ///< number of memory
+
+    private:
+        CircularArray<Storage> memory, pending; ///< pairs in use, pairs of the running CG solve
+        Storage sy;
+        fp_t gamma = 1;
+
+    public:
+        void init(Problem &, BaseArgs &arg) override
+        {
+            const Index n = BMO_ROWS(arg.cur_x),
+                        k = BMO_COLS(arg.cur_x);
+            for (auto *mem : {&memory, &pending})
+            {
+                mem->reset(m);
+                for (int i = 0; i < m; i++)
+                {
+                    BMO_RESIZE(mem->data[i].s, n, k);
+                    BMO_RESIZE(mem->data[i].y, n, k);
+                }
+            }
+            BMO_RESIZE(sy.s, n, k);
+            BMO_RESIZE(sy.y, n, k);
+            gamma = 1;
+        }
+
+        void update(Problem &, BaseArgs &) override
+        { // add the pairs of the last solve, M stays fixed during a solve
+            if (pending.empty())
+                return;
+            const Storage &newest = pending.back();
+            gamma = 1 / (newest.rho * BMO_SQUARE_NORM(newest.y));
+            for (int i = 0; i < pending.size(); i++)
+                memory.push_back(std::move(pending[i])); // swaps the buffers
+            pending.clear();
+        }
+
+        void record(const Mat<fp_t> &p, const Mat<fp_t> &Hp, fp_t pHp) override
+        {
+            sy.s = p;
+            sy.y = Hp;
+            sy.rho = 1 / pHp;
+            pending.push_back(std::move(sy));
+        }
+
+        void apply(const Mat<fp_t> &r, Mat<fp_t> &z) override
+        {
+            z = r;
+            internal::LBFGS::lbfgs_update_direction(gamma, memory, z);
+        }
+
+        void release() override
+        {
+            memory.reset(0);
+            pending.reset(0);
+            sy = Storage();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,168 @@
+#pragma once
+#ifndef _OPTIM_NEWTON_SPARSE_NEWTON_HPP_
+#define _OPTIM_NEWTON_SPARSE_NEWTON_HPP_
+
+#include "base/BaseSolver.hpp"
+#include "line_search/More_Thuente.hpp"
+
+#if defined(OPTIM_USE_EIGEN)
+#include <Eigen/SparseCholesky>
+
+namespace optim
+{
+    /// @brief Newton's method with a sparse Hessian
+    /// @details The problem fills a sparse Hessian and the solver factorizes it with a sparse LDL^T. The fill-reducing ordering and symbolic factorization are computed once and reused as long as the pattern does not change, every iteration only redoes the numeric factorization. When the Hessian is not positive definite, a multiple of the identity is added (modified Cholesky, Nocedal & Wright Alg. 3.3) until the factorization has a positive diagonal, so the step is always a descent direction. Only available with the Eigen backend.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class SparseNewton final
+        : public LSBaseSolver<fp_t>
+    {
+    public:
+        using Constant = OptimConst<fp_t>;
+        using Problem = SpHessProblem<fp_t>;
+        using LineSearchImp = typename LSBaseSolver<fp_t, false>::LineSearchImp;
+
+        using BaseSolver<fp_t>::iter;
+        using LSBaseSolver<fp_t>::ls;
+
+    private:
+        using Factor = Eigen::SimplicialLDLT<SpMat<fp_t>>;
+
+        std::shared_ptr<Problem> prob;
+        SpMat<fp_t> H;                ///< kept across solve() calls
+        std::unique_ptr<Factor> ldlt; ///< symbolic part kept across solve() calls
+        Index analyzed_size = -1,
+              analyzed_nnz = -1; ///< shape of the analyzed pattern
+        fp_t tau = 0;            ///< shift of the last factorization
+
+    public:
+        int max_iter = 100;
+        fp_t xtol = 1e-10;
+        fp_t ftol = 1e-6;
+        fp_t gtol = 1e-6;
+        fp_t min_shift = 1e-3; ///< first shift tried when the Hessian is not positive definite
+        int max_shift_iter = 40;
+        int status;
+
+        explicit SparseNewton(std::shared_ptr<Problem> prob)
+        {
+            this->prob = prob;
+            this->ls = std::make_shared<MTLS<fp_t, false>>();
+        }
+
+        explicit SparseNewton(
+            std::shared_ptr<Problem> prob,
+            std::shared_ptr<LineSearchImp> ls)
+        {
+            this->prob = prob;
+            this->ls = ls;
+        }
+
+        /// @brief shift added to the Hessian in the last iteration, 0 if it was positive definite
+        fp_t shift() const { return tau; }
+
+        /// @brief redo the symbolic factorization on the next iteration
+        /// @details only needed if the pattern changes but keeps the same number of nonzeros.
+        void reanalyze() { analyzed_size = analyzed_nnz = -1; }
+
+        fp_t solve(Mat<fp_t> &x) override
+        {
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("SparseNewton");
+            const Index nk = BMO_SIZE(x);
+            auto &arg = this->prepare_workspace(x);
+            fp_t f_diff, x_diff_nrm, g_nrm;
+            arg.update_cur_loss_grad(prob.get());
+            ls->init(prob, arg);
+            internal::NoMallocScope no_malloc;
+            for (iter = 1; iter <= max_iter; iter++)
+            {
+                internal::trace::Span trace_iter("iter");
+                arg.flush();
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    internal::AllowMallocScope allow_malloc;
+                    {
+                        internal::trace::Span trace("hess");
+                        prob->hess(arg.prev_x, H);
+                    }
+                    internal::instrument::count(internal::instrument::Eval::Hess);
+                    optim_assert(H.rows() == nk && H.cols() == nk,
+                                 "Hessian must be nk x nk.");
+                    if (!factorize())
+                    {
+                        logger.warn("[SparseNewton] factorization failed.");
+                        status = -1;
+                        BMO_SWAP(arg.cur_x, arg.prev_x);
+                        BMO_SWAP(arg.cur_grad, arg.prev_grad);
+                        arg.cur_loss = arg.prev_loss;
+                        break;
+                    }
+                    MapCol<fp_t> BMO_INIT_MAP_COL(g, arg.prev_grad, nk);
+                    MapCol<fp_t> BMO_INIT_MAP_COL(d, arg.direction, nk);
+                    d = -ldlt->solve(g);
+                }
+                arg.step = 1.;
+                ls->line_search(arg);
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Check);
+                    g_nrm = BMO_FRO_NORM(arg.cur_grad);
+                    x_diff_nrm = BMO_FRO_NORM(arg.direction) * arg.step;
+                    f_diff = std::abs(arg.cur_loss - arg.prev_loss) /
+                             (std::abs(arg.cur_loss) + fp_t(1));
+                }
+                logger.trace("[SparseNewton] iter: {:<5d}| loss: {:<16g}| g_nrm: {:<12g}| shift: {:<10g}",
+                             iter, arg.cur_loss, g_nrm, tau);
+                if ((g_nrm < gtol && x_diff_nrm < xtol && f_diff < ftol) ||
+                    g_nrm < Constant::eps)
+                { // check stop criteria
+                    status = 0;
+                    BMO_SWAP(x, arg.cur_x);
+                    return arg.cur_loss;
+                }
+            }
+            if (iter > max_iter)
+                status = 1;
+            BMO_SWAP(x, arg.cur_x);
+            return arg.cur_loss;
+        }
+
+        void release() override
+        {
+            H = SpMat<fp_t>();
+            ldlt.reset();
+            reanalyze();
+            LSBaseSolver<fp_t, false>::release();
+        }
+
+    private:
+        /// @brief numeric LDL^T of H + tau I with the smallest tau found that makes it positive definite
+        bool factorize()
+        {
+            if (!ldlt)
+                ldlt = std::make_unique<Factor>();
+            if (H.rows() != analyzed_size || H.nonZeros() != analyzed_nnz)
+            {
+                ldlt->analyzePattern(H);
+                analyzed_size = H.rows(), analyzed_nnz = H.nonZeros();
+            }
+            tau = 0;
+            for (int i = 0; i < max_shift_iter; i++)
+            {
+                ldlt->setShift(tau);
+                ldlt->factorize(H);
+                if (ldlt->info() == Eigen::Success &&
+                    ldlt->vectorD().minCoeff() > 0)
+                    return true;
+                if (i == 0) // a shift of -min(H_ii) is needed anyway
+                    tau = std::max(min_shift, min_shift - fp_t(H.diagonal().minCoeff()));
+                else
+                    tau *= 2;
+            }
+            return false;
+        }
+    };
+}
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+#pragma once
+#ifndef _OPTIM_NEWTON_TRUST_REGION_NEWTON_HPP_
+#define _OPTIM_NEWTON_TRUST_REGION_NEWTON_HPP_
+
+#include "base/BaseSolver.hpp"
+#include "misc/malloc_guard.hpp"
+
+namespace optim
+{
+    /// @brief Trust-region Newton method with Steihaug-Toint CG
+    /// @details Each step approximately minimizes the quadratic model \f$ m(d) = g^T d + \frac{1}{2} d^T H d \f$ within \f$ |d| \leq \Delta \f$ by CG on `HessProblem::hess_forward`. CG stops on the boundary when it meets non-positive curvature or leaves the region, so indefinite Hessians give a step along the negative curvature instead of a failed line search, and inside the region once \f$ |H d + g| \leq \min(0.5, \sqrt{|g|}) |g| \f$. A step costs one loss and gradient evaluation: it is accepted if the ratio \f$ \rho \f$ of actual to predicted decrease exceeds `eta`, and \f$ \Delta \f$ shrinks when \f$ \rho < 1/4 \f$ and doubles when \f$ \rho > 3/4 \f$ on the boundary.
+    /// @tparam fp_t floating-point type
+    template <typename fp_t>
+    class TrustRegionNewton final
+        : public BaseSolver<fp_t>
+    {
+    public:
+        using Constant = OptimConst<fp_t>;
+        using Problem = HessProblem<fp_t>;
+
+        using BaseSolver<fp_t>::iter;
+
+    private:
+        std::shared_ptr<Problem> prob;
+        Mat<fp_t> g, d, r, p, Hp, x_trial, g_trial; ///< kept across solve() calls
+
+    public:
+        int max_iter = 100;
+        int max_cg_iter = -1;            ///< max CG iterations per step, -1 for the problem size
+        fp_t xtol = 1e-10;               ///< stop if |x_{k+1} - x_k| < xtol and |f_{k+1} - f_k| < ftol
+        fp_t ftol = 1e-10;               ///< relative to 1 + |f_{k+1}|
+        fp_t gtol = 1e-6;                ///< stop if |g_k| < gtol
+        fp_t init_radius = 1;            ///< initial trust-region radius
+        fp_t max_radius = 1e3;           ///< upper bound of the radius
+        fp_t min_radius = Constant::eps; ///< stop if the radius falls below
+        fp_t eta = 1e-4;                 ///< accept a step if the actual decrease is eta times the predicted one
+        fp_t radius;                     ///< radius at the end of the last solve()
+        int n_hess_vec = 0;              ///< Hessian-vector products in the last solve()
+        int n_eval = 0;                  ///< loss and gradient evaluations in the last solve()
+        int status;                      ///< 0 converged, 1 reaches max_iter, 2 radius below min_radius
+
+        explicit TrustRegionNewton(std::shared_ptr<Problem> prob) : prob(prob) {}
+
+        fp_t solve(Mat<fp_t> &x) override
+        {
+            internal::instrument::Scope instrument(this->solver_stats);
+            internal::trace::Span trace("TRNewton");
+            const Index n = BMO_ROWS(x),
+                        k = BMO_COLS(x);
+            BMO_RESIZE(g, n, k), BMO_RESIZE(d, n, k);
+            BMO_RESIZE(r, n, k), BMO_RESIZE(p, n, k), BMO_RESIZE(Hp, n, k);
+            BMO_RESIZE(x_trial, n, k), BMO_RESIZE(g_trial, n, k);
+            n_hess_vec = n_eval = 0;
+            radius = init_radius;
+            fp_t f = loss_and_grad(x, g), g_nrm = BMO_FRO_NORM(g);
+            bool moved = true; // the Hessian has to follow x
+            status = 1;
+            internal::NoMallocScope no_malloc;
+            for (iter = 1; iter <= max_iter; iter++)
+            {
+                internal::trace::Span trace_iter("iter");
+                if (g_nrm < gtol)
+                {
+                    status = 0;
+                    break;
+                }
+                bool on_boundary;
+                int cg_iter;
+                {
+                    internal::instrument::Timer timer(internal::instrument::Phase::Direction);
+                    if (moved)
+                    {
+                        internal::AllowMallocScope allow_malloc;
+                        prob->update_hess(x);
+                    }
+                    cg_iter = steihaug_cg(g_nrm, on_boundary);
+                }
+                // m(0) - m(d) = -(g^T d + d^T H d / 2), with H d = r - g
+                const fp_t pred = -fp_t(0.5) * (BMO_MAT_DOT_PROD(g, d) + BMO_MAT_DOT_PROD(r, d)),
+                           d_nrm = BMO_FRO_NORM(d);
+                x_trial = x + d;
+                // decreases at the rounding level of f count as agreeing
+                const fp_t f_trial = loss_and_grad(x_trial, g_trial),
+                           noise = 10 * Constant::eps * std::max(fp_t(1), std::abs(f)),
+                           rho = (f - f_trial + noise) / (pred + noise);
+                if (!(rho >= fp_t(0.25))) // NaN shrinks too
+                    radius = fp_t(0.25) * d_nrm;
+                else if (rho > fp_t(0.75) && on_boundary)
+                    radius = std::min(2 * radius, max_radius);
+                moved = rho > eta;
+                logger.trace("[TRNewton] iter: {:<5d}| loss: {:<16g}| g_nrm: {:<12g}| radius: {:<10g}| rho: {:<10g}| cg_iter: {:<5d}",
+                             iter, f, g_nrm, radius, rho, cg_iter);
+                if (moved)
+                {
+                    const fp_t f_diff = std::abs(f - f_trial) / (std::abs(f_trial) + fp_t(1));
+                    BMO_SWAP(x, x_trial);
+                    BMO_SWAP(g, g_trial);
+                    f = f_trial;
+                    g_nrm = BMO_FRO_NORM(g);
+                    if (g_nrm < gtol || (d_nrm < xtol && f_diff < ftol))
+                    {
+                        status = 0;
+                        break;
+                    }
+                }
+                if (radius < min_radius)
+                {
+                    status = 2;
+                    logger.warn("[TRNewton] trust-region radius {:g} below min_radius.", radius);
+                    break;
+                }
+            }
+            return f;
+        }
+
+        /// @brief free the memory kept for the next solve() call
+        void release()
+        {
+            BMO_RESIZE(g, 0, 0), BMO_RESIZE(d, 0, 0);
+            BMO_RESIZE(r, 0, 0), BMO_RESIZE(p, 0, 0), BMO_RESIZE(Hp, 0, 0);
+            BMO_RESIZE(x_trial, 0, 0), BMO_RESIZE(g_trial, 0, 0);
+        }
+
+    private:
+        OPTIM_INLINE fp_t loss_and_grad(const Mat<fp_t> &x, Mat<fp_t> &out_g)
+        {
+            internal::AllowMallocScope allow_malloc;
+            n_eval++;
+            internal::instrument::count(internal::instrument::Eval::LossGrad);
+            internal::trace::Span trace("loss_grad");
+            return prob->loss_and_grad(x, out_g);
+        }
+
+        OPTIM_INLINE void hess_vec(const Mat<fp_t> &v, Mat<fp_t> &out)
+        {
+            internal::AllowMallocScope allow_malloc;
+            {
+                internal::trace::Span trace("hess_vec");
+                prob->hess_forward(v, out);
+            }
+            n_hess_vec++;
+            internal::instrument::count(internal::instrument::Eval::Hess);
+        }
+
+        /// @brief tau > 0 with |d + tau p| = radius
+        fp_t to_boundary() const
+        {
+            const fp_t pp = BMO_SQUARE_NORM(p),
+                       dp = BMO_MAT_DOT_PROD(d, p),
+                       dd = BMO_SQUARE_NORM(d);
+            // dd < radius^2, so the roots have opposite signs
+            const fp_t disc = std::sqrt(std::max(dp * dp + pp * (radius * radius - dd), fp_t(0)));
+            return dp >= 0 ? (radius * radius - dd) / (dp + disc)
+                           : (disc - dp) / pp;
+        }
+
+        /// @brief approximately minimize the model within the radius into d, with r = H d + g
+        /// @param g_nrm |g|
+        /// @param on_boundary whether d ends on the boundary
+        /// @return number of CG iterations
+        int steihaug_cg(const fp_t g_nrm, bool &on_boundary)
+        {
+            const int max_cg = max_cg_iter < 0 ? int(BMO_SIZE(g)) : max_cg_iter;
+            const fp_t tol = std::min(fp_t(0.5), std::sqrt(g_nrm)) * g_nrm;
+            BMO_SET_ZERO(d);
+            r = g;
+            p = -g;
+            fp_t rr = g_nrm * g_nrm;
+            on_boundary = false;
+            int j = 0;
+            for (; j < max_cg; j++)
+            {
+                hess_vec(p, Hp);
+                const fp_t pHp = BMO_MAT_DOT_PROD(p, Hp);
+                fp_t alpha = pHp > 0 ? rr / pHp : Constant::inf;
+                if (pHp <= 0 || alpha * BMO_FRO_NORM(p) >= radius - BMO_FRO_NORM(d))
+                { // negative curvature or leaves the region: maybe stop on the boundary
+                    const fp_t tau = to_boundary();
+                    if (pHp <= 0 || alpha >= tau)
+                    {
+                        d += tau * p;
+                        r += tau * Hp;
+                        on_boundary = true;
+                        j++;
+                        break;
+                    }
+                }
+                d += alpha * p;
+                r += alpha * Hp;
+                const fp_t rr_new = BMO_SQUARE_NORM(r);
+                if (std::sqrt(rr_new) <= tol)
+                {
+                    j++;
+                    break;
+                }
+                p *= rr_new / rr;
+                p -= r;
+                rr = rr_new;
+            }
+            return j;
+        }
+    };
+}
+
+#endif
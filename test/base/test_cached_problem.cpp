@@ -0,0 +1,119 @@
+// gradient descent with Barzilai-Borwein steps and the Zhang-Hager line
+// search, which asks for the loss at every trial point and for the gradient
+// at the accepted one in a separate call. Behind a CachedProblem in joint mode the two calls become one
+// loss_and_grad, so the pass over the data computing A x is shared, while the
+// iterates stay bitwise identical. Then the LRU order of a small cache.
+#include "base/CachedProblem.hpp"
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "line_search/Zhang_Hager.hpp"
+#include <cstdio>
+
+using namespace optim;
+
+/// @brief logistic regression, counting the products with A
+struct Logistic : GradProblem<double>
+{
+    Mat<double> A, y;
+    long n_loss = 0, n_grad = 0, n_loss_grad = 0, n_pass = 0;
+
+    double eval(const Mat<double> &x, Mat<double> *g)
+    {
+        n_pass++;
+        Mat<double> z = A * x;
+        double f = 0;
+        for (Index t = 0; t < BMO_SIZE(z); t++)
+        {
+            const double m = -y(t) * z(t);
+            f += std::max(m, 0.) + std::log1p(std::exp(-std::abs(m)));
+            z(t) = -y(t) / (1 + std::exp(-m));
+        }
+        if (g)
+        {
+            n_pass++;
+            g->noalias() = BMO_TRANSPOSE(A) * z;
+        }
+        return f / BMO_ROWS(A);
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        n_loss++;
+        return eval(x, nullptr);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_grad++;
+        eval(x, &g);
+        g /= BMO_ROWS(A);
+    }
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_loss_grad++;
+        const double f = eval(x, &g);
+        g /= BMO_ROWS(A);
+        return f;
+    }
+};
+
+int main(int argc, char const *argv[])
+{
+    const Index n = 50, T = 2000;
+    logger.set_verbosity("error");
+    auto prob = std::make_shared<Logistic>();
+    prob->A = BMO_INIT_RAND(Mat<double>, T, n);
+    prob->y = BMO_INIT_RAND(Mat<double>, T, 1);
+    for (Index t = 0; t < T; t++)
+        prob->y(t) = prob->y(t) > 0 ? 1 : -1;
+    const Mat<double> x0 = BMO_INIT_ZERO(Mat<double>, n, 1);
+
+    auto cached = std::make_shared<CachedProblem<double>>(prob);
+    cached->joint = true;
+    std::shared_ptr<GradProblem<double>> probs[2] = {prob, cached};
+    const char *names[2] = {"plain", "cached"};
+    Mat<double> x[2];
+    double f[2];
+    long n_pass_plain = 0;
+    std::printf("%-8s %6s %8s %8s %10s %8s %8s\n", "problem", "iter", "loss()", "grad()", "loss_grad()", "passes", "hits");
+    for (int s = 0; s < 2; s++)
+    {
+        GD<double> gd(probs[s]);
+        gd.ls = std::make_shared<ZHLS<double>>();
+        gd.lr_scheduler = std::make_shared<BBStepScheduler<double>>();
+        gd.max_iter = 300;
+        gd.gtol = 1e-8;
+        gd.xtol = gd.ftol = 0;
+        prob->n_loss = prob->n_grad = prob->n_loss_grad = prob->n_pass = 0;
+        x[s] = x0;
+        f[s] = gd.solve(x[s]);
+        std::printf("%-8s %6d %8ld %8ld %10ld %8ld %8ld\n", names[s], gd.n_iter(),
+                    prob->n_loss, prob->n_grad, prob->n_loss_grad, prob->n_pass,
+                    s ? cached->n_hits() : 0);
+        if (s == 0)
+            n_pass_plain = prob->n_pass;
+    }
+    int failed = 0;
+    failed |= f[0] != f[1] || x[0] != x[1];
+    failed |= cached->n_hits() == 0 || prob->n_grad != 0;
+    failed |= prob->n_pass >= n_pass_plain;
+
+    // capacity 2: the third point evicts the least recently used one
+    CachedProblem<double> lru(prob, 2);
+    Mat<double> p[3] = {x0, x[0], x[0] + x[0]}, g(n, 1), g_ref(n, 1);
+    lru.loss(p[0]);
+    lru.loss(p[1]);
+    lru.loss(p[0]); // hit, p[1] is now the oldest
+    lru.loss(p[2]); // evicts p[1]
+    lru.loss(p[0]); // hit
+    lru.loss(p[1]); // miss
+    failed |= lru.n_hits() != 2 || lru.n_misses() != 4;
+    lru.grad(p[1], g); // loss cached, gradient not
+    lru.loss_and_grad(p[1], g_ref);
+    failed |= lru.n_hits() != 3 || g != g_ref;
+    lru.clear();
+    lru.loss(p[0]);
+    failed |= lru.n_misses() != 6;
+    std::printf("lru: hits %ld, misses %ld\n", lru.n_hits(), lru.n_misses());
+    return failed;
+}
@@ -0,0 +1,115 @@
+// logistic regression as a finite sum, one shard per 256 samples.
+// the gradient must be bitwise identical for any number of threads.
+#include "base/FiniteSumProblem.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include <chrono>
+
+using namespace optim;
+
+struct Logistic : FiniteSumProblem<double>
+{
+    static constexpr Index shard_size = 256;
+    Mat<double> A, b; // samples by column, labels in {-1, 1}
+
+    Logistic(Index n_features, Index n_samples)
+    {
+        A = BMO_INIT_RAND(Mat<double>, n_features, n_samples);
+        b = BMO_SIGN(BMO_INIT_RAND(Mat<double>, n_samples, 1)).matrix();
+    }
+
+    Index n_shards() const override
+    {
+        return (BMO_COLS(A) + shard_size - 1) / shard_size;
+    }
+
+    double shard_loss(Index s, const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        BMO_SET_ZERO(g);
+        return shard_loss_and_grad(s, x, g);
+    }
+
+    void shard_grad(Index s, const Mat<double> &x, Mat<double> &g) override
+    {
+        shard_loss_and_grad(s, x, g);
+    }
+
+    double shard_loss_and_grad(Index s, const Mat<double> &x, Mat<double> &g) override
+    {
+        double loss = 0;
+        const Index end = std::min(BMO_COLS(A), (s + 1) * shard_size);
+        for (Index j = s * shard_size; j < end; j++)
+        {
+            const double z = -b(j) * BMO_DOT_PROD(A.col(j), x.col(0));
+            loss += std::log1p(std::exp(z));
+            g -= b(j) / (1 + std::exp(-z)) * A.col(j);
+        }
+        return loss;
+    }
+};
+
+int main(int argc, char const *argv[])
+{
+    auto prob = std::make_shared<Logistic>(64, 1 << 17);
+    Mat<double> x = BMO_INIT_RAND(Mat<double>, 64, 1), g1, g;
+    // at least 4 threads so stealing is exercised on small machines too
+    const unsigned n_cores = std::max(4u, std::thread::hardware_concurrency());
+    prob->pool = std::make_shared<ThreadPool>(0);
+    const double f1 = prob->loss_and_grad(x, g1);
+    int failed = 0;
+    for (unsigned n_threads = 1; n_threads <= n_cores; n_threads *= 2)
+    {
+        prob->pool = std::make_shared<ThreadPool>(n_threads - 1);
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < 10; i++)
+            prob->grad(x, g);
+        const double ms = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - t0)
+                              .count() /
+                          10;
+        const bool same = prob->loss_and_grad(x, g) == f1 && g == g1;
+        failed += !same;
+        std::cout << n_threads << " threads: " << ms << " ms/grad, "
+                  << (same ? "identical" : "DIFFERENT") << std::endl;
+    }
+    { // concurrent calls on one instance, as from the starts of a MultiStart
+        std::vector<Mat<double>> gs(4);
+        std::vector<double> fs(4);
+        std::vector<std::thread> callers;
+        for (int t = 0; t < 4; t++)
+            callers.emplace_back([&, t]
+                                 { for (int i = 0; i < 5; i++)
+                                       fs[t] = prob->loss_and_grad(x, gs[t]); });
+        for (auto &t : callers)
+            t.join();
+        bool same = true;
+        for (int t = 0; t < 4; t++)
+            same &= fs[t] == f1 && gs[t] == g1;
+        failed += !same;
+        std::cout << "concurrent calls: " << (same ? "identical" : "DIFFERENT") << std::endl;
+    }
+    { // an exception thrown by a task reaches the caller, nesting runs inline
+        ThreadPool pool(3);
+        bool caught = false;
+        try
+        {
+            pool.parallel_for(64, [](Index i)
+                              { if (i % 7 == 3) throw std::runtime_error("task"); });
+        }
+        catch (const std::runtime_error &)
+        {
+            caught = true;
+        }
+        std::atomic<Index> n_inner{0};
+        pool.parallel_for(8, [&](Index)
+                          { pool.parallel_for(8, [&](Index)
+                                              { n_inner++; }); });
+        failed += !caught || n_inner != 64;
+        std::cout << "exception " << (caught ? "rethrown" : "LOST")
+                  << ", nested tasks: " << n_inner << std::endl;
+    }
+    LBFGS<double> solver(prob);
+    BMO_SET_ZERO(x);
+    std::cout << "LBFGS loss: " << solver.solve(x) << std::endl;
+    return failed;
+}
@@ -0,0 +1,127 @@
+// multi-start L-BFGS on the Styblinski-Tang function, whose 2^n minima
+// differ by the sign of each coordinate. The parallel driver must find the
+// same minima as a serial run, and pruning against the incumbent must save
+// evaluations without losing the global minimum. The logger is written to
+// from every thread at once.
+#include "base/MultiStart.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+
+using namespace optim;
+using Clock = std::chrono::steady_clock;
+
+/// @brief f(x) = 1/2 sum_i x_i^4 - 16 x_i^2 + 5 x_i
+struct StyblinskiTang : GradProblem<double>
+{
+    std::atomic<long> n_eval{0};
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_eval++;
+        double f = 0;
+        for (Index i = 0; i < BMO_ROWS(x); i++)
+        {
+            const double t = x(i);
+            f += 0.5 * (t * t * t * t - 16 * t * t + 5 * t);
+            g(i) = 2 * t * t * t - 16 * t + 2.5;
+        }
+        return f;
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        return loss_and_grad(x, g);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+};
+
+struct Run
+{
+    std::vector<MultiStart<double>::Result> minima;
+    long n_eval;
+    int n_abandoned;
+    double ms;
+};
+
+Run run(std::shared_ptr<StyblinskiTang> prob, const std::vector<Mat<double>> &starts,
+        unsigned n_workers, double patience)
+{
+    MultiStart<double> ms(prob, [](std::shared_ptr<GradProblem<double>> p)
+                          {
+        auto lbfgs = std::make_shared<LBFGS<double>>(p);
+        lbfgs->gtol = 1e-8;
+        lbfgs->max_iter = 200;
+        return lbfgs; });
+    ms.pool = std::make_shared<ThreadPool>(n_workers);
+    ms.patience = patience;
+    ms.top_k = 6;
+    prob->n_eval = 0;
+    const auto t0 = Clock::now();
+    Run r;
+    r.minima = ms.solve(starts);
+    r.ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    r.n_eval = prob->n_eval;
+    r.n_abandoned = ms.n_abandoned();
+    return r;
+}
+
+int main(int argc, char const *argv[])
+{
+    const Index n = 4, n_starts = 512;
+    const double f_min = -39.16616570377142 * n;
+    const unsigned n_workers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    auto prob = std::make_shared<StyblinskiTang>();
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> unif(-5, 5);
+    std::vector<Mat<double>> starts(n_starts, Mat<double>(n, 1));
+    for (auto &x : starts)
+        for (Index i = 0; i < n; i++)
+            x(i) = unif(gen);
+    logger.set_verbosity("error");
+
+    const Run serial = run(prob, starts, 0, OptimConst<double>::inf);
+    const Run parallel = run(prob, starts, n_workers, OptimConst<double>::inf);
+    const Run pruned = run(prob, starts, n_workers, 10);
+    std::printf("%-10s %8s %10s %10s %12s\n", "run", "threads", "time(ms)", "evals", "abandoned");
+    for (auto [name, r, threads] : {std::make_tuple("serial", &serial, 1u),
+                                    std::make_tuple("parallel", &parallel, n_workers + 1),
+                                    std::make_tuple("pruned", &pruned, n_workers + 1)})
+        std::printf("%-10s %8u %10.2f %10ld %12d\n", name, threads, r->ms, r->n_eval, r->n_abandoned);
+
+    int failed = 0;
+    // every run finds the global minimum, the unpruned ones the same minima
+    failed |= serial.minima.size() != 6 || parallel.minima.size() != 6;
+    for (size_t k = 0; k < serial.minima.size() && k < parallel.minima.size(); k++)
+    {
+        failed |= std::abs(serial.minima[k].loss - parallel.minima[k].loss) > 1e-9;
+        std::printf("minimum %zu: %.8f\n", k, serial.minima[k].loss);
+    }
+    failed |= pruned.minima.empty() || std::abs(pruned.minima[0].loss - f_min) > 1e-8;
+    failed |= std::abs(serial.minima[0].loss - f_min) > 1e-8;
+    failed |= pruned.n_eval >= parallel.n_eval;
+    for (size_t k = 1; k < pruned.minima.size(); k++)
+        failed |= pruned.minima[k].loss < pruned.minima[k - 1].loss ||
+                  BMO_FRO_NORM(Mat<double>(pruned.minima[k].x - pruned.minima[k - 1].x)) < 1e-4;
+
+    // one whole line per finished start while every thread logs
+    std::ostringstream oss;
+    logger.write_to_oss(oss);
+    logger.set_pattern("%v");
+    logger.set_verbosity("trace");
+    const Run logged = run(prob, starts, n_workers, 10);
+    logger.write_to_console();
+    std::istringstream lines(oss.str());
+    std::string line;
+    int n_lines = 0;
+    while (std::getline(lines, line))
+        n_lines += line.rfind("[MultiStart] start ", 0) == 0 &&
+                   line.find(" iterations.") == line.size() - 12;
+    std::printf("logged: %d finished starts, %d abandoned\n", n_lines, logged.n_abandoned);
+    failed |= n_lines != n_starts - logged.n_abandoned;
+    return failed;
+}
@@ -0,0 +1,114 @@
+// projection onto the L1 ball: Condat's algorithm against the sort-based
+// threshold prox<-1> used before, for a small radius (few active entries)
+// and a large one (half of the mass kept). The simplex and weighted
+// variants are checked against sort-based references too.
+#include "functions/functions.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace optim;
+using Clock = std::chrono::steady_clock;
+
+/// @brief tau with sum_i w_i max(y_i - tau w_i, 0) = a, by sorting y_i / w_i
+double sort_threshold(const std::vector<double> &y, const std::vector<double> &w, double a)
+{
+    const size_t n = y.size();
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t i, size_t j)
+              { return y[i] / w[i] > y[j] / w[j]; });
+    double num = 0, den = 0, tau = 0;
+    for (size_t k = 0; k < n; k++)
+    {
+        const size_t i = order[k];
+        if (k > 0 && y[i] / w[i] <= tau)
+            break;
+        num += w[i] * y[i], den += w[i] * w[i];
+        tau = (num - a) / den;
+    }
+    return tau;
+}
+
+double sort_threshold(const std::vector<double> &y, double a)
+{
+    return sort_threshold(y, std::vector<double>(y.size(), 1.), a);
+}
+
+/// @brief the sort-based prox of the infinity norm
+void sort_prox_inf(double step, const Mat<double> &x, Mat<double> &out)
+{
+    const Index n = BMO_SIZE(x);
+    std::vector<double> y(n);
+    for (Index i = 0; i < n; i++)
+        y[i] = std::abs(x(i));
+    const double tau = sort_threshold(y, step);
+    out.resize(BMO_ROWS(x), BMO_COLS(x));
+    for (Index i = 0; i < n; i++)
+        out(i) = std::min(std::max(x(i), -tau), tau);
+}
+
+template <typename F>
+double time_ms(F &&f, int reps)
+{
+    const auto t0 = Clock::now();
+    for (int r = 0; r < reps; r++)
+        f();
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count() / reps;
+}
+
+int main(int argc, char const *argv[])
+{
+    const Index ns[] = {1000, 100000, 10000000};
+    int failed = 0;
+    std::printf("%9s %8s %12s %12s %8s %10s\n",
+                "n", "radius", "sort(ms)", "condat(ms)", "speedup", "max_err");
+    for (Index n : ns)
+    {
+        const int reps = int(std::max(Index(3), Index(3000000) / n));
+        const Mat<double> x = BMO_INIT_RAND(Mat<double>, n, 1);
+        const double l1 = BMO_SUM(BMO_ABS(x));
+        Mat<double> a(n, 1), b(n, 1);
+        for (double radius : {1., 0.5 * l1})
+        {
+            const double t_sort = time_ms([&]
+                                          { sort_prox_inf(radius, x, a); },
+                                          reps);
+            const double t_condat = time_ms([&]
+                                            { fn::prox<-1>(radius, x, b); },
+                                            reps);
+            double err = 0;
+            for (Index i = 0; i < n; i++)
+                err = std::max(err, std::abs(a(i) - b(i)));
+            failed |= err > 1e-12 * std::max(1., radius);
+            std::printf("%9ld %8.3g %12.3f %12.3f %8.1f %10.2e\n", long(n), radius,
+                        t_sort, t_condat, t_sort / t_condat, err);
+        }
+        // simplex and weighted L1 ball
+        std::vector<double> y(n), w(n);
+        Mat<double> weight(n, 1);
+        for (Index i = 0; i < n; i++)
+        {
+            y[i] = x(i), w[i] = weight(i) = 0.5 + std::abs(std::sin(double(i)));
+        }
+        const double tau_s = sort_threshold(y, 2.);
+        fn::proj_simplex(2., x, b);
+        double err = std::abs(BMO_SUM(b) - 2.);
+        for (Index i = 0; i < n; i++)
+            err = std::max(err, std::abs(b(i) - std::max(x(i) - tau_s, 0.)));
+        for (Index i = 0; i < n; i++)
+            y[i] = std::abs(x(i));
+        const double tau_w = sort_threshold(y, w, 3.);
+        fn::proj_l1_ball(3., weight, x, b);
+        double wsum = 0;
+        for (Index i = 0; i < n; i++)
+        {
+            const double ref = (x(i) > 0 ? 1 : -1) * std::max(y[i] - tau_w * w[i], 0.);
+            err = std::max(err, std::abs(b(i) - ref));
+            wsum += w[i] * std::abs(b(i));
+        }
+        err = std::max(err, std::abs(wsum - 3.));
+        failed |= err > 1e-9;
+        std::printf("%9ld simplex / weighted ball max_err %.2e\n", long(n), err);
+    }
+    return failed;
+}
@@ -0,0 +1,111 @@
+// throughput of the proximal kernels in GB/s (bytes read + written) for every
+// instruction set this CPU supports, next to the branchy scalar loop that
+// fn::prox<1> used before. Every SIMD result is checked against the scalar
+// kernels, the squared norm against a sum in double.
+#include "functions/functions.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace optim;
+using namespace optim::fn::kernel;
+using Clock = std::chrono::steady_clock;
+
+template <typename T>
+void branchy_soft_threshold(const T *x, T *y, Index n, T t)
+{
+    for (Index i = 0; i < n; i++)
+    {
+        if (x[i] > t)
+            y[i] = x[i] - t;
+        else if (x[i] < -t)
+            y[i] = x[i] + t;
+        else
+            y[i] = 0;
+    }
+}
+
+/// @brief GB/s of f over reps calls moving bytes each
+template <typename F>
+double gbps(F &&f, double bytes, int reps)
+{
+    f(); // warm up
+    const auto t0 = Clock::now();
+    for (int r = 0; r < reps; r++)
+        f();
+    const double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+    return bytes * reps / sec * 1e-9;
+}
+
+template <typename T>
+int run(const char *type_name)
+{
+    const Index ns[] = {1000, 100000, 10000000};
+    const SimdISA isas[] = {SimdISA::Scalar, SimdISA::NEON, SimdISA::AVX2, SimdISA::AVX512};
+    const T t = 0.5;
+    int failed = 0;
+    std::printf("%-6s %9s %-8s %9s %9s %9s %9s %9s\n", type_name, "n", "isa",
+                "soft", "elastic", "box", "sq_norm", "scale");
+    for (Index n : ns)
+    {
+        const int reps = int(std::max(Index(10), Index(200000000) / n));
+        Mat<T> x = BMO_INIT_RAND(Mat<T>, n, 1), y(n, 1), ref(n, 1),
+               lo = BMO_INIT_RAND(Mat<T>, n, 1), hi = lo;
+        hi = BMO_ARRAY_ADD_SCALAR(BMO_ABS(hi), T(0.1));
+        lo = -hi;
+        const T *px = BMO_GET_DATA(x), *plo = BMO_GET_DATA(lo), *phi = BMO_GET_DATA(hi);
+        T *py = BMO_GET_DATA(y), *pref = BMO_GET_DATA(ref);
+        const double rw = 2. * n * sizeof(T);
+        std::printf("%-6s %9ld %-8s %9.2f\n", "", long(n), "branchy",
+                    gbps([&]
+                         { branchy_soft_threshold(px, py, n, t); },
+                         rw, reps));
+        for (SimdISA isa : isas)
+        {
+            if (!set_simd_isa(isa))
+                continue;
+            const auto &k = kernels<T>();
+            const auto &s = scalar::make_table<scalar::Vec<T>>();
+            // correctness against the scalar kernels
+            k.soft_threshold(px, py, n, t), s.soft_threshold(px, pref, n, t);
+            failed |= !(y == ref);
+            k.elastic_net(px, py, n, t, T(0.8)), s.elastic_net(px, pref, n, t, T(0.8));
+            failed |= !(y == ref);
+            k.clamp_vec(px, plo, phi, py, n), s.clamp_vec(px, plo, phi, pref, n);
+            failed |= !(y == ref);
+            double sq_ref = 0; // accumulated in double
+            for (Index i = 0; i < n; i++)
+                sq_ref += double(px[i]) * px[i];
+            const double sq = k.squared_norm(px, n);
+            failed |= std::abs(sq - sq_ref) > 10 * std::sqrt(double(n)) * std::numeric_limits<T>::epsilon() * sq_ref;
+            std::printf("%-6s %9ld %-8s %9.2f %9.2f %9.2f %9.2f %9.2f\n", "", long(n),
+                        simd_isa_name(isa),
+                        gbps([&]
+                             { k.soft_threshold(px, py, n, t); },
+                             rw, reps),
+                        gbps([&]
+                             { k.elastic_net(px, py, n, t, T(0.8)); },
+                             rw, reps),
+                        gbps([&]
+                             { k.clamp_vec(px, plo, phi, py, n); },
+                             2 * rw, reps),
+                        gbps([&]
+                             { volatile T r = k.squared_norm(px, n); (void)r; },
+                             rw / 2, reps),
+                        gbps([&]
+                             { k.scale(px, py, n, T(0.8)); },
+                             rw, reps));
+        }
+        set_simd_isa(best_simd_isa());
+    }
+    if (failed)
+        std::printf("%s: SIMD kernels differ from the scalar ones\n", type_name);
+    return failed;
+}
+
+int main(int argc, char const *argv[])
+{
+    std::printf("best instruction set: %s\n", simd_isa_name(best_simd_isa()));
+    int failed = run<double>("double");
+    failed |= run<float>("float");
+    return failed;
+}
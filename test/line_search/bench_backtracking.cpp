@@ -0,0 +1,267 @@
+// loss evaluations of the Armijo and Zhang-Hager line searches when a rejected
+// step is shrunk by the fixed decay rate or by safeguarded quadratic / cubic
+// interpolation, on test functions of More, Garbow and Hillstrom. Gradient
+// descent restarting each search from a unit step, gradient descent with
+// Barzilai-Borwein steps and L-BFGS. Interpolation must not cost more
+// evaluations in total, nor miss a minimum that the fixed decay reaches.
+#define OPTIM_INSTRUMENT
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include "line_search/Armijo.hpp"
+#include "line_search/Zhang_Hager.hpp"
+#include <cstdio>
+
+using namespace optim;
+
+/// @brief a test function counting its loss and gradient evaluations
+struct TestFunction : GradProblem<double>
+{
+    long n_loss = 0, n_grad = 0;
+
+    virtual double f(const Mat<double> &x) = 0;
+    virtual void df(const Mat<double> &x, Mat<double> &g) = 0;
+
+    double loss(const Mat<double> &x) override
+    {
+        n_loss++;
+        return f(x);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_grad++;
+        df(x, g);
+    }
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_loss++, n_grad++;
+        df(x, g);
+        return f(x);
+    }
+};
+
+/// @brief extended Rosenbrock, sum 100 (x_{2i} - x_{2i-1}^2)^2 + (1 - x_{2i-1})^2
+struct Rosenbrock : TestFunction
+{
+    double f(const Mat<double> &x) override
+    {
+        double s = 0;
+        for (Index i = 0; i + 1 < BMO_SIZE(x); i += 2)
+        {
+            const double a = x(i + 1) - x(i) * x(i), b = 1 - x(i);
+            s += 100 * a * a + b * b;
+        }
+        return s;
+    }
+
+    void df(const Mat<double> &x, Mat<double> &g) override
+    {
+        for (Index i = 0; i + 1 < BMO_SIZE(x); i += 2)
+        {
+            const double a = x(i + 1) - x(i) * x(i), b = 1 - x(i);
+            g(i) = -400 * a * x(i) - 2 * b;
+            g(i + 1) = 200 * a;
+        }
+    }
+};
+
+/// @brief extended Powell singular function, with a singular Hessian at the minimum
+struct Powell : TestFunction
+{
+    double f(const Mat<double> &x) override
+    {
+        double s = 0;
+        for (Index i = 0; i + 3 < BMO_SIZE(x); i += 4)
+        {
+            const double a = x(i) + 10 * x(i + 1), b = x(i + 2) - x(i + 3),
+                         c = x(i + 1) - 2 * x(i + 2), d = x(i) - x(i + 3);
+            s += a * a + 5 * b * b + c * c * c * c + 10 * d * d * d * d;
+        }
+        return s;
+    }
+
+    void df(const Mat<double> &x, Mat<double> &g) override
+    {
+        for (Index i = 0; i + 3 < BMO_SIZE(x); i += 4)
+        {
+            const double a = x(i) + 10 * x(i + 1), b = x(i + 2) - x(i + 3),
+                         c = x(i + 1) - 2 * x(i + 2), d = x(i) - x(i + 3);
+            g(i) = 2 * a + 40 * d * d * d;
+            g(i + 1) = 20 * a + 4 * c * c * c;
+            g(i + 2) = 10 * b - 8 * c * c * c;
+            g(i + 3) = -10 * b - 40 * d * d * d;
+        }
+    }
+};
+
+/// @brief trigonometric function, sum (n - sum_j cos x_j + i (1 - cos x_i) - sin x_i)^2
+struct Trigonometric : TestFunction
+{
+    Mat<double> r;
+
+    double f(const Mat<double> &x) override
+    {
+        const Index n = BMO_SIZE(x);
+        double c = 0;
+        for (Index j = 0; j < n; j++)
+            c += std::cos(x(j));
+        r.resize(n, 1);
+        for (Index i = 0; i < n; i++)
+            r(i) = double(n) - c + double(i + 1) * (1 - std::cos(x(i))) - std::sin(x(i));
+        return BMO_SQUARE_NORM(r);
+    }
+
+    void df(const Mat<double> &x, Mat<double> &g) override
+    {
+        const Index n = BMO_SIZE(x);
+        f(x);
+        const double s = BMO_SUM(r);
+        for (Index i = 0; i < n; i++)
+            g(i) = 2 * (s * std::sin(x(i)) +
+                        r(i) * (double(i + 1) * std::sin(x(i)) - std::cos(x(i))));
+    }
+};
+
+/// @brief Broyden tridiagonal function, sum ((3 - 2 x_i) x_i - x_{i-1} - 2 x_{i+1} + 1)^2
+struct BroydenTridiagonal : TestFunction
+{
+    Mat<double> r;
+
+    double f(const Mat<double> &x) override
+    {
+        const Index n = BMO_SIZE(x);
+        r.resize(n, 1);
+        for (Index i = 0; i < n; i++)
+            r(i) = (3 - 2 * x(i)) * x(i) + 1 - (i > 0 ? x(i - 1) : 0) -
+                   2 * (i + 1 < n ? x(i + 1) : 0);
+        return BMO_SQUARE_NORM(r);
+    }
+
+    void df(const Mat<double> &x, Mat<double> &g) override
+    {
+        const Index n = BMO_SIZE(x);
+        f(x);
+        for (Index i = 0; i < n; i++)
+            g(i) = 2 * (r(i) * (3 - 4 * x(i)) - (i + 1 < n ? r(i + 1) : 0) -
+                        2 * (i > 0 ? r(i - 1) : 0));
+    }
+};
+
+struct Case
+{
+    const char *name;
+    std::shared_ptr<TestFunction> prob;
+    Mat<double> x0;
+};
+
+/// @brief restarts every line search from the same step, like a fixed learning rate
+struct ConstantStep : StepScheduler<double>
+{
+    double step = 1;
+
+    void update(int, BaseLineSearchArgs<double> &arg) override { arg.step = step; }
+};
+
+struct Result
+{
+    int iter;
+    long n_loss, n_rejected;
+    bool converged;
+};
+
+template <typename LS>
+std::shared_ptr<LS> make_ls(Backtracking policy)
+{
+    auto ls = std::make_shared<LS>();
+    ls->backtracking = policy;
+    ls->max_iter = 30;
+    return ls;
+}
+
+template <typename LS>
+Result run(const std::string &solver, Case &c, Backtracking policy)
+{
+    const int max_iter = 5000;
+    const double gtol = 1e-5;
+    c.prob->n_loss = 0;
+    Mat<double> x = c.x0, g(BMO_ROWS(x), 1);
+    Result r;
+    if (solver != "LBFGS")
+    {
+        GD<double> gd(c.prob);
+        gd.ls = make_ls<LS>(policy);
+        if (solver == "GD+BB")
+            gd.lr_scheduler = std::make_shared<BBStepScheduler<double>>();
+        else
+            gd.lr_scheduler = std::make_shared<ConstantStep>();
+        gd.step = 1;
+        gd.max_iter = max_iter;
+        gd.gtol = gtol;
+        gd.xtol = gd.ftol = 0;
+        gd.solve(x), r.iter = gd.n_iter(), r.n_rejected = gd.stats().n_ls_rejected;
+    }
+    else
+    {
+        LBFGS<double> lbfgs(c.prob, make_ls<LS>(policy));
+        lbfgs.max_iter = max_iter;
+        lbfgs.gtol = gtol;
+        lbfgs.xtol = lbfgs.ftol = 1e10; // stop on gtol alone
+        lbfgs.solve(x), r.iter = lbfgs.n_iter(), r.n_rejected = lbfgs.stats().n_ls_rejected;
+    }
+    r.n_loss = c.prob->n_loss;
+    c.prob->df(x, g);
+    r.converged = BMO_FRO_NORM(g) < gtol;
+    return r;
+}
+
+int main(int argc, char const *argv[])
+{
+    const Index n = 100;
+    logger.set_verbosity("error");
+    Mat<double> x_rosen(n, 1), x_powell(n, 1), x_trig(n, 1), x_broyden(n, 1);
+    for (Index i = 0; i < n; i++)
+    {
+        x_rosen(i) = i % 2 ? 1 : -1.2;
+        x_powell(i) = (i % 4 == 0 ? 3 : i % 4 == 1 ? -1 : i % 4 == 2 ? 0 : 1);
+        x_trig(i) = 1. / double(n);
+        x_broyden(i) = -1;
+    }
+    std::vector<Case> cases = {
+        {"rosenbrock", std::make_shared<Rosenbrock>(), x_rosen},
+        {"powell", std::make_shared<Powell>(), x_powell},
+        {"trig", std::make_shared<Trigonometric>(), x_trig},
+        {"broyden", std::make_shared<BroydenTridiagonal>(), x_broyden}};
+
+    std::printf("%-10s %-6s %-6s | %6s %7s %7s %6s | %6s %7s %7s %6s | %6s\n", "", "", "",
+                "fixed", "", "", "", "interp", "", "", "", "");
+    std::printf("%-10s %-6s %-6s | %6s %7s %7s %6s | %6s %7s %7s %6s | %6s\n", "problem", "solver", "ls",
+                "iter", "loss", "reject", "/iter", "iter", "loss", "reject", "/iter", "saved");
+    int failed = 0;
+    long total[2] = {0, 0}, rejected[2] = {0, 0};
+    for (Case &c : cases)
+        for (const char *solver : {"GD", "GD+BB", "LBFGS"})
+            for (const char *ls : {"Armijo", "ZHLS"})
+            {
+                Result r[2];
+                for (int v = 0; v < 2; v++)
+                {
+                    const Backtracking policy = v ? Backtracking::Interpolation : Backtracking::Fixed;
+                    r[v] = ls[0] == 'A' ? run<ArmijoLineSearch<double>>(solver, c, policy)
+                                        : run<ZHLineSearch<double>>(solver, c, policy);
+                    total[v] += r[v].n_loss, rejected[v] += r[v].n_rejected;
+                }
+                std::printf("%-10s %-6s %-6s | %6d %7ld %7ld %6.2f | %6d %7ld %7ld %6.2f | %5.1f%%\n",
+                            c.name, solver, ls,
+                            r[0].iter, r[0].n_loss, r[0].n_rejected, double(r[0].n_loss) / r[0].iter,
+                            r[1].iter, r[1].n_loss, r[1].n_rejected, double(r[1].n_loss) / r[1].iter,
+                            100. * (1 - double(r[1].n_loss) / double(r[0].n_loss)));
+                failed |= r[0].converged && !r[1].converged;
+            }
+    std::printf("total loss evaluations: fixed %ld, interpolation %ld, %.1f%% saved\n",
+                total[0], total[1], 100. * (1 - double(total[1]) / double(total[0])));
+    std::printf("rejected trial steps:   fixed %ld, interpolation %ld, %.1f%% saved\n",
+                rejected[0], rejected[1], 100. * (1 - double(rejected[1]) / double(rejected[0])));
+    failed |= total[1] > total[0];
+    return failed;
+}
@@ -0,0 +1,250 @@
+// Hager-Zhang line search against More-Thuente under L-BFGS, down to a tight
+// gtol. Where the loss decrease of a step is mostly rounding error, HZLS must
+// converge with far fewer evaluations thanks to the approximate Wolfe
+// conditions. Then proximal gradient descent on a LASSO
+// problem, where Hager-Zhang must get at least as low as Zhang-Hager in fewer
+// iterations. With an identity prox the proximal search must take the very
+// same trials as the plain one.
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include "line_search/Hager_Zhang.hpp"
+#include "line_search/Zhang_Hager.hpp"
+#include "line_search/More_Thuente.hpp"
+#include "functions/functions.hpp"
+#include <cstdio>
+
+using namespace optim;
+
+/// @brief counts the evaluations of a problem
+template <typename Base>
+struct Counted : Base
+{
+    long n_eval = 0;
+};
+
+/// @brief f = sum 100 (x_{i+1} - x_i^2)^2 + (1 - x_i)^2
+struct ChainRosenbrock : Counted<GradProblem<double>>
+{
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_eval++;
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        BMO_SET_ZERO(g);
+        for (Index i = 0; i + 1 < n; i++)
+        {
+            const double a = x(i + 1) - x(i) * x(i), b = 1 - x(i);
+            f += 100 * a * a + b * b;
+            g(i) += -400 * a * x(i) - 2 * b;
+            g(i + 1) += 200 * a;
+        }
+        return f;
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        return loss_and_grad(x, g);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+};
+
+/// @brief f = sum w_i log cosh(x_i - c_i) + 0.5 (x_{i+1} - x_i)^2 + 1000
+struct LogCoshChain : Counted<GradProblem<double>>
+{
+    Mat<double> w, c;
+
+    explicit LogCoshChain(Index n)
+    {
+        w.resize(n, 1);
+        for (Index i = 0; i < n; i++)
+            w(i) = std::pow(1e2, double(i) / double(n - 1));
+        c = 3 * BMO_INIT_RAND(Mat<double>, n, 1);
+    }
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_eval++;
+        const Index n = BMO_SIZE(x);
+        double f = 1000; // offset, so that the decrease is lost in rounding early
+        for (Index i = 0; i < n; i++)
+        {
+            const double u = std::abs(x(i) - c(i));
+            f += w(i) * (u + std::log1p(std::exp(-2 * u)) - std::log(2.));
+            g(i) = w(i) * std::tanh(x(i) - c(i));
+            if (i > 0)
+                g(i) += x(i) - x(i - 1);
+            if (i + 1 < n)
+            {
+                f += 0.5 * (x(i + 1) - x(i)) * (x(i + 1) - x(i));
+                g(i) -= x(i + 1) - x(i);
+            }
+        }
+        return f;
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        return loss_and_grad(x, g);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+};
+
+/// @brief f = 0.5 |A x - b|^2 + mu |x|_1
+struct LASSO : ProxGradProblem<double>
+{
+    Mat<double> A, b, r;
+    double mu;
+
+    LASSO(Index m, Index n, double mu) : mu(mu)
+    {
+        A = BMO_INIT_RAND(Mat<double>, m, n);
+        Mat<double> x0 = BMO_INIT_ZERO(Mat<double>, n, 1);
+        for (Index i = 0; i < n; i += 10)
+            x0(i) = 1;
+        b = A * x0;
+    }
+
+    double sm_loss(const Mat<double> &x) override
+    {
+        r = A * x - b;
+        return 0.5 * BMO_SQUARE_NORM(r);
+    }
+
+    double nsm_loss(const Mat<double> &x) override { return mu * BMO_SUM(BMO_ABS(x)); }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        r = A * x - b;
+        g = BMO_TRANSPOSE(A) * r;
+    }
+
+    void prox(double step, const Mat<double> &in_x, Mat<double> &out_x) override
+    {
+        fn::prox<1>(step * mu, in_x, out_x);
+    }
+};
+
+/// @brief f = sum w_i x_i^2 with no non-smooth part, so the prox is the identity
+struct SmoothQuad : ProxGradProblem<double>
+{
+    double sm_loss(const Mat<double> &x) override
+    {
+        double f = 0;
+        for (Index i = 0; i < BMO_SIZE(x); i++)
+            f += (i + 1) * x(i) * x(i);
+        return f;
+    }
+
+    double nsm_loss(const Mat<double> &) override { return 0; }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        for (Index i = 0; i < BMO_SIZE(x); i++)
+            g(i) = 2 * (i + 1) * x(i);
+    }
+
+    void prox(double, const Mat<double> &in_x, Mat<double> &out_x) override { out_x = in_x; }
+};
+
+/// @brief one search from x = 1 along the negative gradient
+/// @return the trials taken, the accepted step is left in step
+template <bool use_prox>
+int search(std::shared_ptr<SmoothQuad> prob, double &step)
+{
+    HZLS<double, use_prox> ls;
+    typename HZLS<double, use_prox>::Args arg;
+    Mat<double> x = BMO_INIT_ZERO(Mat<double>, 10, 1);
+    for (Index i = 0; i < BMO_SIZE(x); i++)
+        x(i) = 1;
+    arg.init(x);
+    arg.update_cur_loss_grad(prob.get());
+    ls.init(prob, arg);
+    arg.flush();
+    arg.direction = -arg.prev_grad;
+    arg.step = step;
+    ls.line_search(arg);
+    step = arg.step;
+    return ls.n_iter();
+}
+
+int failed = 0;
+
+/// @return evaluations with HZLS over those with MTLS
+template <typename Problem>
+double run(const char *name, std::shared_ptr<Problem> prob, const Mat<double> &x0, double gtol)
+{
+    long evals[2];
+    for (int v = 0; v < 2; v++)
+    {
+        LBFGS<double> lbfgs(prob);
+        if (v == 0)
+            lbfgs.ls = std::make_shared<MTLS<double>>();
+        else
+            lbfgs.ls = std::make_shared<HZLS<double>>();
+        lbfgs.gtol = gtol;
+        lbfgs.xtol = lbfgs.ftol = 1e10; // stop on gtol alone
+        lbfgs.max_iter = 5000;
+        prob->n_eval = 0;
+        Mat<double> x = x0, g(BMO_ROWS(x), 1);
+        const double f = lbfgs.solve(x);
+        prob->grad(x, g);
+        evals[v] = prob->n_eval - 1;
+        std::printf("%-10s %-5s %6d %7ld %9.2f %16.10e %10.2e\n", name, v ? "HZLS" : "MTLS",
+                    lbfgs.n_iter(), evals[v], double(evals[v]) / lbfgs.n_iter(), f, BMO_FRO_NORM(g));
+        if (v == 1)
+            failed |= BMO_FRO_NORM(g) > gtol;
+    }
+    return double(evals[1]) / double(evals[0]);
+}
+
+int main(int argc, char const *argv[])
+{
+    logger.set_verbosity("error");
+    std::printf("%-10s %-5s %6s %7s %9s %16s %10s\n", "problem", "ls", "iter", "evals", "per iter", "loss", "|g|");
+    // the loss decrease of Rosenbrock stays well above rounding, so both
+    // find Wolfe steps in much the same way
+    failed |= run("rosenbrock", std::make_shared<ChainRosenbrock>(),
+                  BMO_INIT_ZERO(Mat<double>, 100, 1), 1e-10) > 1.25;
+    failed |= run("logcosh", std::make_shared<LogCoshChain>(1000),
+                  BMO_INIT_ZERO(Mat<double>, 1000, 1), 1e-9) > 0.5;
+
+    // a proximal search with the identity prox is the plain search, a
+    // bracket whose lower end is the start point needs its slope
+    for (const double step0 : {0.01, 1.0, 10.0})
+    {
+        auto quad = std::make_shared<SmoothQuad>();
+        double steps[2] = {step0, step0};
+        const int trials[2] = {search<false>(quad, steps[0]), search<true>(quad, steps[1])};
+        std::printf("%-10s %-5g %6d %6d %12g %12g\n", "identity", step0,
+                    trials[0], trials[1], steps[0], steps[1]);
+        failed |= trials[0] != trials[1] ||
+                  std::abs(steps[1] - steps[0]) > 1e-12 * steps[0];
+    }
+
+    // proximal line search
+    const Index n = 200;
+    auto lasso = std::make_shared<LASSO>(100, n, 0.1);
+    double f[2];
+    int iters[2];
+    for (int v = 0; v < 2; v++)
+    {
+        ProxGD<double> gd(lasso);
+        if (v == 0)
+            gd.ls = std::make_shared<ZHLS<double, true>>();
+        else
+            gd.ls = std::make_shared<HZLS<double, true>>();
+        gd.step = 1e-3;
+        gd.max_iter = 3000;
+        gd.xtol = gd.ftol = 1e-12;
+        Mat<double> x = BMO_INIT_ZERO(Mat<double>, n, 1);
+        f[v] = gd.solve(x), iters[v] = gd.n_iter();
+        std::printf("%-10s %-5s %6d %7s %9s %16.10e\n", "lasso", v ? "HZLS" : "ZHLS",
+                    gd.n_iter(), "", "", f[v]);
+    }
+    failed |= f[1] > f[0] + 1e-8 * std::abs(f[0]) || iters[1] > iters[0];
+    return failed;
+}
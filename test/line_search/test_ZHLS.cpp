@@ -1,8 +1,60 @@
+// Zhang-Hager line search on f = x^2 from x = 1: a search that runs out of
+// trials must report failure through success(), both when run at once and
+// when driven by start()/tell(), and the next successful search must clear it.
 #include "line_search/Zhang_Hager.hpp"
+#include <cstdio>
+
+using namespace optim;
+
+struct Square : GradProblem<double>
+{
+    double loss(const Mat<double> &x) override { return BMO_SQUARE_NORM(x); }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { g = 2 * x; }
+};
+
+/// @brief set up a search from x = 1 along -1 with the given first step
+void prepare(ZHLineSearch<double> &ls, std::shared_ptr<Square> prob,
+             ZHLineSearch<double>::Args &arg, double step)
+{
+    Mat<double> x = BMO_INIT_ZERO(Mat<double>, 1, 1);
+    x(0) = 1;
+    arg.init(x);
+    arg.update_cur_loss_grad(prob.get());
+    ls.init(prob, arg);
+    arg.direction = -x;
+    arg.step = step;
+    arg.flush();
+}
 
 int main(int argc, char const *argv[])
 {
-    using namespace optim;
-    ZHLineSearch ls;
-    return 0;
+    auto prob = std::make_shared<Square>();
+    ZHLineSearch<double> ls;
+    ZHLineSearch<double>::Args arg;
+    int failed = 0;
+
+    ls.max_iter = 1; // one rejected trial is a failure
+    prepare(ls, prob, arg, 10);
+    ls.line_search(arg);
+    failed |= ls.success();
+    prepare(ls, prob, arg, 0.5);
+    ls.line_search(arg);
+    failed |= !ls.success();
+
+    prepare(ls, prob, arg, 10);
+    ls.start(arg);
+    do
+        arg.update_cur_loss_grad(prob.get());
+    while (!ls.tell(arg));
+    failed |= ls.success() || arg.step != ls.min_step;
+    prepare(ls, prob, arg, 0.5);
+    ls.start(arg);
+    do
+        arg.update_cur_loss_grad(prob.get());
+    while (!ls.tell(arg));
+    failed |= !ls.success();
+
+    std::printf("ZHLS status: %s\n", failed ? "WRONG" : "ok");
+    return failed;
 }
@@ -0,0 +1,143 @@
+// solver statistics collected with OPTIM_INSTRUMENT: the evaluation counts of
+// GD, L-BFGS and Newton-CG must match those the problem counts itself, a
+// line search tries at least one point per iteration and the phases fit in
+// the total time. The problem counters are reset between the two runs of each
+// solver, so the second one also checks that solve() restarts the stats.
+#define OPTIM_INSTRUMENT
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include "unconstrained/newton/NewtonCG.hpp"
+#include "line_search/Zhang_Hager.hpp"
+#include "line_search/More_Thuente.hpp"
+#include <cstdio>
+
+using namespace optim;
+
+/// @brief f = sum w_i log cosh(x_i - c_i) + 0.5 (x_{i+1} - x_i)^2, counting its calls
+struct LogCoshChain : HessProblem<double>
+{
+    Mat<double> w, c, xh;
+    long n_loss = 0, n_grad = 0, n_loss_grad = 0, n_hess = 0;
+
+    explicit LogCoshChain(Index n)
+    {
+        w.resize(n, 1);
+        for (Index i = 0; i < n; i++)
+            w(i) = std::pow(1e2, double(i) / double(n - 1));
+        c = 3 * BMO_INIT_RAND(Mat<double>, n, 1);
+    }
+
+    double eval(const Mat<double> &x)
+    {
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        for (Index i = 0; i < n; i++)
+        {
+            const double u = std::abs(x(i) - c(i));
+            f += w(i) * (u + std::log1p(std::exp(-2 * u)) - std::log(2.));
+            if (i + 1 < n)
+                f += 0.5 * (x(i + 1) - x(i)) * (x(i + 1) - x(i));
+        }
+        return f;
+    }
+
+    void eval_grad(const Mat<double> &x, Mat<double> &g)
+    {
+        const Index n = BMO_SIZE(x);
+        for (Index i = 0; i < n; i++)
+        {
+            g(i) = w(i) * std::tanh(x(i) - c(i));
+            if (i > 0)
+                g(i) += x(i) - x(i - 1);
+            if (i + 1 < n)
+                g(i) -= x(i + 1) - x(i);
+        }
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        n_loss++;
+        return eval(x);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_grad++;
+        eval_grad(x, g);
+    }
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_loss_grad++;
+        eval_grad(x, g);
+        return eval(x);
+    }
+
+    void update_hess(const Mat<double> &x) override { xh = x; }
+
+    void hess_forward(const Mat<double> &v, Mat<double> &d) override
+    {
+        n_hess++;
+        const Index n = BMO_SIZE(v);
+        for (Index i = 0; i < n; i++)
+        {
+            const double t = std::tanh(xh(i) - c(i));
+            d(i) = w(i) * (1 - t * t) * v(i);
+            if (i > 0)
+                d(i) += v(i) - v(i - 1);
+            if (i + 1 < n)
+                d(i) -= v(i + 1) - v(i);
+        }
+    }
+};
+
+int failed = 0;
+
+template <typename Solver>
+void run(const char *name, Solver &solver, LogCoshChain &prob, const Mat<double> &x0)
+{
+    for (int rep = 0; rep < 2; rep++)
+    {
+        prob.n_loss = prob.n_grad = prob.n_loss_grad = prob.n_hess = 0;
+        Mat<double> x = x0;
+        solver.solve(x);
+        const SolverStats &s = solver.stats();
+        std::printf("%-8s %5d %7ld %7ld %9ld %7ld %9ld %9ld | %8.2e %8.2e %8.2e %8.2e\n", name,
+                    solver.n_iter(), s.n_loss, s.n_grad, s.n_loss_grad, s.n_hess,
+                    s.n_ls_trials, s.n_ls_rejected,
+                    s.t_direction, s.t_line_search, s.t_check, s.t_total);
+        failed |= s.n_loss != prob.n_loss || s.n_grad != prob.n_grad ||
+                  s.n_loss_grad != prob.n_loss_grad || s.n_hess != prob.n_hess;
+        failed |= s.n_ls_trials < solver.n_iter() - 1 ||
+                  s.n_ls_rejected < 0 || s.n_ls_rejected >= s.n_ls_trials;
+        failed |= s.t_total <= 0 ||
+                  s.t_direction + s.t_line_search + s.t_check > s.t_total;
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    const Index n = 1000;
+    logger.set_verbosity("error");
+    auto prob = std::make_shared<LogCoshChain>(n);
+    const Mat<double> x0 = BMO_INIT_ZERO(Mat<double>, n, 1);
+    std::printf("%-8s %5s %7s %7s %9s %7s %9s %9s | %8s %8s %8s %8s\n", "solver", "iter",
+                "loss", "grad", "loss_grad", "hess", "ls_trial", "ls_reject",
+                "t_dir", "t_ls", "t_check", "t_total");
+
+    GD<double> gd(prob);
+    gd.ls = std::make_shared<ZHLS<double>>();
+    gd.lr_scheduler = std::make_shared<BBStepScheduler<double>>();
+    gd.max_iter = 500;
+    run("GD", gd, *prob, x0);
+
+    LBFGS<double> lbfgs(prob);
+    lbfgs.ls = std::make_shared<MTLS<double>>();
+    lbfgs.gtol = 1e-8;
+    run("LBFGS", lbfgs, *prob, x0);
+
+    NewtonCG<double> ncg(prob);
+    run("NewtonCG", ncg, *prob, x0);
+    failed |= ncg.stats().n_hess == 0;
+    return failed;
+}
@@ -0,0 +1,167 @@
+// Chrome trace export: L-BFGS with More-Thuente and GD with Zhang-Hager run
+// on two threads while tracing. The trace must hold one span per solve(),
+// per iteration and per evaluation, matching the solver statistics, with
+// every iteration inside the solve() of its own thread. Then the cost of a
+// span with tracing on and off, timed over bursts the rings can hold, next to
+// the cost of reading the clock, and the events a long burst drops.
+#define OPTIM_TRACE
+#define OPTIM_INSTRUMENT
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include "line_search/Zhang_Hager.hpp"
+#include "line_search/More_Thuente.hpp"
+#include <cstdio>
+
+using namespace optim;
+using Clock = std::chrono::steady_clock;
+
+/// @brief f = sum 100 (x_{i+1} - x_i^2)^2 + (1 - x_i)^2
+struct ChainRosenbrock : GradProblem<double>
+{
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        BMO_SET_ZERO(g);
+        for (Index i = 0; i + 1 < n; i++)
+        {
+            const double a = x(i + 1) - x(i) * x(i), b = 1 - x(i);
+            f += 100 * a * a + b * b;
+            g(i) += -400 * a * x(i) - 2 * b;
+            g(i + 1) += 200 * a;
+        }
+        return f;
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        return loss_and_grad(x, g);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+};
+
+struct Span
+{
+    std::string name;
+    int tid;
+    double ts, dur;
+};
+
+std::vector<Span> read_trace(const char *path)
+{
+    std::vector<Span> spans;
+    std::FILE *f = std::fopen(path, "r");
+    char line[256], name[64];
+    Span s;
+    while (f && std::fgets(line, sizeof(line), f))
+        if (std::sscanf(line, "%*[,]{\"name\":\"%63[^\"]\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lf,\"dur\":%lf}",
+                        name, &s.tid, &s.ts, &s.dur) == 4 ||
+            std::sscanf(line, "{\"name\":\"%63[^\"]\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lf,\"dur\":%lf}",
+                        name, &s.tid, &s.ts, &s.dur) == 4)
+        {
+            s.name = name;
+            spans.push_back(s);
+        }
+    if (f)
+        std::fclose(f);
+    return spans;
+}
+
+long count(const std::vector<Span> &spans, const char *name)
+{
+    return std::count_if(spans.begin(), spans.end(), [&](const Span &s)
+                         { return s.name == name; });
+}
+
+int main(int argc, char const *argv[])
+{
+    const Index n = 100;
+    const char *path = "optim_trace.json";
+    logger.set_verbosity("error");
+    auto prob = std::make_shared<ChainRosenbrock>();
+    const Mat<double> x0 = BMO_INIT_ZERO(Mat<double>, n, 1);
+    LBFGS<double> lbfgs(prob);
+    lbfgs.ls = std::make_shared<MTLS<double>>();
+    GD<double> gd(prob);
+    gd.ls = std::make_shared<ZHLS<double>>();
+    gd.lr_scheduler = std::make_shared<BBStepScheduler<double>>();
+    gd.max_iter = 200;
+
+    int failed = !trace::start(path);
+    std::thread worker([&]
+                       { Mat<double> x = x0; gd.solve(x); });
+    Mat<double> x = x0;
+    lbfgs.solve(x);
+    worker.join();
+    failed |= trace::stop() != 0;
+
+    const auto spans = read_trace(path);
+    const SolverStats &s_lbfgs = lbfgs.stats(), &s_gd = gd.stats();
+    std::printf("%zu spans: LBFGS %ld, GD %ld, iter %ld, MTLS %ld, ZHLS %ld, ls_trial %ld, loss %ld, grad %ld, loss_grad %ld\n",
+                spans.size(), count(spans, "LBFGS"), count(spans, "GD"), count(spans, "iter"),
+                count(spans, "MTLS"), count(spans, "ZHLS"), count(spans, "ls_trial"),
+                count(spans, "loss"), count(spans, "grad"), count(spans, "loss_grad"));
+    failed |= count(spans, "LBFGS") != 1 || count(spans, "GD") != 1;
+    failed |= count(spans, "loss") != s_lbfgs.n_loss + s_gd.n_loss ||
+              count(spans, "grad") != s_lbfgs.n_grad + s_gd.n_grad ||
+              count(spans, "loss_grad") != s_lbfgs.n_loss_grad + s_gd.n_loss_grad;
+    failed |= count(spans, "iter") < lbfgs.n_iter() + gd.n_iter() - 2;
+    for (const Span &it : spans)
+    {
+        if (it.name != "iter")
+            continue;
+        bool inside = false;
+        for (const Span &sv : spans)
+            inside |= (sv.name == "LBFGS" || sv.name == "GD") && sv.tid == it.tid &&
+                      sv.ts <= it.ts && it.ts + it.dur <= sv.ts + sv.dur + 1e-3;
+        failed |= !inside;
+    }
+    std::remove(path);
+
+    // cost of a span, in bursts of half the high-water mark with a pause for
+    // the flusher in between, so that no event is dropped
+    using internal::trace::Ring;
+    const int n_burst = 256, burst = Ring::high_water / 2;
+    const auto period = std::chrono::milliseconds(1);
+    for (bool on : {false, true})
+    {
+        if (on)
+            trace::start(path, period);
+        Clock::duration busy{0};
+        for (int b = 0; b < n_burst; b++)
+        {
+            const auto t0 = Clock::now();
+            for (int i = 0; i < burst; i++)
+                internal::trace::Span span("bench");
+            busy += Clock::now() - t0;
+            std::this_thread::sleep_for(2 * period);
+        }
+        const double ns = std::chrono::duration<double, std::nano>(busy).count() / (n_burst * burst);
+        const long dropped = trace::stop();
+        std::printf("tracing %-3s: %6.1f ns per span, %ld dropped\n", on ? "on" : "off", ns, dropped);
+        failed |= dropped != 0;
+    }
+    {
+        const int n_tick = 1 << 20;
+        int64_t sum = 0;
+        const auto t0 = Clock::now();
+        for (int i = 0; i < n_tick; i++)
+            sum += internal::trace::ticks();
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n_tick;
+        std::printf("clock read : %6.1f ns (%lld)\n", ns, (long long)(sum & 1));
+    }
+    // a burst far longer than a ring, the flusher is woken at the high-water
+    // mark but can not keep up with a producer doing nothing else
+    {
+        const int n_span = 1 << 20;
+        trace::start(path);
+        for (int i = 0; i < n_span; i++)
+            internal::trace::Span span("bench");
+        const long dropped = trace::stop();
+        std::printf("long burst : %d spans, %ld dropped\n", n_span, dropped);
+    }
+    std::remove(path);
+    return failed;
+}
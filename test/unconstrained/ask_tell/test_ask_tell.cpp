@@ -0,0 +1,177 @@
+// many solves multiplexed on one thread: each step gathers the points every
+// running ask/tell solver asks for and evaluates them in one request to a
+// stand-in simulation service. Every solve must end on exactly the point the
+// usual solver reaches calling the problem itself.
+#include "unconstrained/ask_tell/AskTellGD.hpp"
+#include "unconstrained/ask_tell/AskTellLBFGS.hpp"
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include "line_search/Armijo.hpp"
+#include "line_search/Hager_Zhang.hpp"
+#include <cstdio>
+
+using namespace optim;
+
+constexpr double lambda = 1e-2;
+
+/// @brief loss and gradient of sum_t softplus(a_t x - y_t) + l/2 |x|^2
+double fit_loss_grad(const Mat<double> &A, const Mat<double> &y,
+                     const Mat<double> &x, Mat<double> &g)
+{
+    Mat<double> r = A * x - y;
+    double f = 0.5 * lambda * BMO_SQUARE_NORM(x);
+    for (Index t = 0; t < BMO_SIZE(r); t++)
+    {
+        f += std::max(r(t), 0.) + std::log1p(std::exp(-std::abs(r(t))));
+        r(t) = 1 / (1 + std::exp(-r(t)));
+    }
+    g.noalias() = BMO_TRANSPOSE(A) * r;
+    g += lambda * x;
+    return f;
+}
+
+/// @brief the simulation service: evaluates a batch of requests in one call
+struct Service
+{
+    Mat<double> A;              ///< shared design
+    std::vector<Mat<double>> Y; ///< targets of each solve
+    int n_calls = 0, n_evals = 0;
+
+    void evaluate(const std::vector<int> &ids, const std::vector<const Mat<double> *> &xs,
+                  std::vector<double> &f, std::vector<Mat<double>> &g)
+    {
+        n_calls++, n_evals += int(ids.size());
+        for (size_t i = 0; i < ids.size(); i++)
+            f[i] = fit_loss_grad(A, Y[ids[i]], *xs[i], g[i]);
+    }
+};
+
+/// @brief solve b of the service, for the solvers calling the problem
+struct Fit : GradProblem<double>
+{
+    const Service &service;
+    int b;
+
+    Fit(const Service &service, int b) : service(service), b(b) {}
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        return fit_loss_grad(service.A, service.Y[b], x, g);
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        return loss_and_grad(x, g);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+};
+
+/// @brief run every solver to the end on one thread, batching their evaluations
+template <typename Solver>
+void drive(std::vector<std::unique_ptr<Solver>> &solvers, Service &service, const Mat<double> &x0)
+{
+    const int S = int(solvers.size());
+    std::vector<int> ids;
+    std::vector<const Mat<double> *> xs;
+    std::vector<double> f(S);
+    std::vector<Mat<double>> g(S, Mat<double>(BMO_ROWS(x0), 1));
+    for (auto &s : solvers)
+        s->start(x0);
+    for (int b = 0; b < S; b++)
+        ids.push_back(b);
+    while (!ids.empty())
+    {
+        xs.clear();
+        for (int b : ids)
+            xs.push_back(&solvers[b]->ask());
+        service.evaluate(ids, xs, f, g);
+        size_t n_running = 0;
+        for (size_t i = 0; i < ids.size(); i++)
+            if (!solvers[ids[i]]->tell(f[i], g[i]))
+                ids[n_running++] = ids[i];
+        ids.resize(n_running);
+    }
+}
+
+template <typename Solver, typename MakeRef>
+int run(const char *name, Service &service, std::vector<std::unique_ptr<Solver>> &solvers,
+        MakeRef &&make_ref)
+{
+    const Index n = BMO_COLS(service.A);
+    const int S = int(solvers.size());
+    const Mat<double> x0 = BMO_INIT_ZERO(Mat<double>, n, 1);
+    service.n_calls = service.n_evals = 0;
+    drive(solvers, service, x0);
+    double err = 0;
+    int n_mismatch = 0;
+    for (int b = 0; b < S; b++)
+    {
+        auto ref = make_ref(std::make_shared<Fit>(service, b));
+        Mat<double> x = x0;
+        const double f = ref->solve(x);
+        err = std::max(err, BMO_FRO_NORM(Mat<double>(x - solvers[b]->x())));
+        n_mismatch += f != solvers[b]->loss() || ref->n_iter() != solvers[b]->n_iter();
+    }
+    std::printf("%-22s %6d %8d %10d %10.2e %9d\n", name, S, service.n_calls,
+                service.n_evals, err, n_mismatch);
+    return err != 0 || n_mismatch != 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    const int S = 1000, n = 6, T = 40;
+    logger.set_verbosity("error");
+    Service service;
+    service.A = BMO_INIT_RAND(Mat<double>, T, n);
+    for (int b = 0; b < S; b++)
+        service.Y.push_back((1 + 4. * b / S) * BMO_INIT_RAND(Mat<double>, T, 1));
+    std::printf("%-22s %6s %8s %10s %10s %9s\n", "solver", "solves", "calls",
+                "evals", "max|dx|", "mismatch");
+    int failed = 0;
+    { // L-BFGS, More-Thuente
+        std::vector<std::unique_ptr<AskTellLBFGS<double>>> solvers;
+        for (int b = 0; b < S; b++)
+            solvers.push_back(std::make_unique<AskTellLBFGS<double>>());
+        failed |= run("AskTellLBFGS + MTLS", service, solvers,
+                      [](std::shared_ptr<Fit> p)
+                      { return std::make_shared<LBFGS<double>>(p); });
+    }
+    { // L-BFGS, Zhang-Hager
+        std::vector<std::unique_ptr<AskTellLBFGS<double>>> solvers;
+        for (int b = 0; b < S; b++)
+            solvers.push_back(std::make_unique<AskTellLBFGS<double>>(
+                std::make_shared<ZHLS<double>>()));
+        failed |= run("AskTellLBFGS + ZHLS", service, solvers,
+                      [](std::shared_ptr<Fit> p)
+                      { return std::make_shared<LBFGS<double>>(p, std::make_shared<ZHLS<double>>()); });
+    }
+    { // L-BFGS, Hager-Zhang
+        std::vector<std::unique_ptr<AskTellLBFGS<double>>> solvers;
+        for (int b = 0; b < S; b++)
+            solvers.push_back(std::make_unique<AskTellLBFGS<double>>(
+                std::make_shared<HZLS<double>>()));
+        failed |= run("AskTellLBFGS + HZLS", service, solvers,
+                      [](std::shared_ptr<Fit> p)
+                      { return std::make_shared<LBFGS<double>>(p, std::make_shared<HZLS<double>>()); });
+    }
+    { // GD, Barzilai-Borwein steps, Armijo
+        std::vector<std::unique_ptr<AskTellGD<double>>> solvers;
+        for (int b = 0; b < S; b++)
+        {
+            solvers.push_back(std::make_unique<AskTellGD<double>>(
+                std::make_shared<ArmijoLineSearch<double>>()));
+            solvers.back()->lr_scheduler = std::make_shared<BBStepScheduler<double>>();
+        }
+        failed |= run("AskTellGD + BB + Armijo", service, solvers,
+                      [](std::shared_ptr<Fit> p)
+                      {
+                          auto gd = std::make_shared<GD<double>>(p);
+                          gd->ls = std::make_shared<ArmijoLineSearch<double>>();
+                          gd->lr_scheduler = std::make_shared<BBStepScheduler<double>>();
+                          return gd;
+                      });
+    }
+    return failed;
+}
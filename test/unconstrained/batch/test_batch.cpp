@@ -0,0 +1,149 @@
+// per-instrument curve fits: B softplus regressions sharing the design A and
+// each with its own targets, f_b(x) = sum_t softplus(a_t x - y_bt) + l/2 |x|^2.
+// The batched solvers must reach the minima L-BFGS finds problem by problem,
+// in a fraction of the time.
+#include "unconstrained/batch/BatchGD.hpp"
+#include "unconstrained/batch/BatchBFGS.hpp"
+#include "unconstrained/batch/BatchLBFGS.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace optim;
+using Clock = std::chrono::steady_clock;
+
+constexpr double lambda = 1e-2;
+
+double softplus(double u) { return std::max(u, 0.) + std::log1p(std::exp(-std::abs(u))); }
+double sigmoid(double u) { return 1 / (1 + std::exp(-u)); }
+
+struct BatchFit : BatchGradProblem<double>
+{
+    Mat<double> A, Y; // T x n design, B x T targets
+    Mat<double> R;
+
+    void loss(const Mat<double> &X, const std::vector<Index> &lanes, Mat<double> &f) override
+    {
+        Mat<double> G(BMO_ROWS(X), BMO_COLS(X));
+        loss_and_grad(X, lanes, f, G);
+    }
+
+    void grad(const Mat<double> &X, const std::vector<Index> &lanes, Mat<double> &G) override
+    {
+        Mat<double> f(BMO_ROWS(X), 1);
+        loss_and_grad(X, lanes, f, G);
+    }
+
+    void loss_and_grad(const Mat<double> &X, const std::vector<Index> &lanes,
+                       Mat<double> &f, Mat<double> &G) override
+    {
+        // one problem per row, every operation below works on columns
+        R.noalias() = X * BMO_TRANSPOSE(A);
+        R -= Y(lanes, Eigen::all);
+        f = 0.5 * lambda * X.rowwise().squaredNorm();
+        for (Index t = 0; t < BMO_COLS(R); t++)
+            for (Index r = 0; r < BMO_ROWS(R); r++)
+            {
+                f(r) += softplus(R(r, t));
+                R(r, t) = sigmoid(R(r, t));
+            }
+        G.noalias() = R * A;
+        G += lambda * X;
+    }
+};
+
+/// @brief problem b of the batch alone
+struct SingleFit : GradProblem<double>
+{
+    const BatchFit &batch;
+    Index b;
+    Mat<double> r;
+
+    SingleFit(const BatchFit &batch, Index b) : batch(batch), b(b) {}
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        r.noalias() = batch.A * x;
+        r -= BMO_TRANSPOSE(batch.Y.row(b));
+        double f = 0.5 * lambda * BMO_SQUARE_NORM(x);
+        for (Index t = 0; t < BMO_SIZE(r); t++)
+            f += softplus(r(t)), r(t) = sigmoid(r(t));
+        g.noalias() = BMO_TRANSPOSE(batch.A) * r;
+        g += lambda * x;
+        return f;
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        return loss_and_grad(x, g);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+};
+
+double elapsed_ms(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+template <typename Solver>
+int run(const char *name, std::shared_ptr<BatchFit> prob, const Mat<double> &f_ref,
+        double t_ref, int max_iter)
+{
+    const Index B = BMO_ROWS(prob->Y), n = BMO_COLS(prob->A);
+    Solver solver(prob);
+    solver.max_iter = max_iter;
+    Mat<double> X = BMO_INIT_ZERO(Mat<double>, B, n), f;
+    const auto t0 = Clock::now();
+    solver.solve(X, f);
+    const double t = elapsed_ms(t0);
+    double err = 0;
+    int n_conv = 0, it_min = max_iter, it_max = 0;
+    for (Index b = 0; b < B; b++)
+    {
+        err = std::max(err, std::abs(f(b) - f_ref(b)) / (1 + std::abs(f_ref(b))));
+        n_conv += solver.status[b] == 0;
+        it_min = std::min(it_min, solver.n_iter_lane[b]);
+        it_max = std::max(it_max, solver.n_iter_lane[b]);
+    }
+    std::printf("%-10s %9.2f %8.1f %6d %4d-%-4d %10.2e\n", name, t, t_ref / t,
+                n_conv, it_min, it_max, err);
+    // the lockstep iterations are those of the slowest problem, and none
+    // are run from the solutions
+    const int n_iter = solver.n_iter();
+    solver.gtol = 1e-3;
+    solver.solve(X, f);
+    return n_conv != B || err > 1e-8 || n_iter != it_max || solver.n_iter() != 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    const Index B = 2048, n = 6, T = 40;
+    logger.set_verbosity("error");
+    auto prob = std::make_shared<BatchFit>();
+    prob->A = BMO_INIT_RAND(Mat<double>, T, n);
+    prob->Y = BMO_INIT_RAND(Mat<double>, B, T);
+    for (Index b = 0; b < B; b++) // lanes of different difficulty
+        prob->Y.row(b) *= 1 + 4. * b / B;
+    // reference: L-BFGS on every problem in turn
+    Mat<double> f_ref(B, 1);
+    const auto t0 = Clock::now();
+    for (Index b = 0; b < B; b++)
+    {
+        LBFGS<double> lbfgs(std::make_shared<SingleFit>(*prob, b));
+        lbfgs.gtol = 1e-7, lbfgs.xtol = 1e-10, lbfgs.ftol = 1e-12;
+        lbfgs.max_iter = 500;
+        Mat<double> x = BMO_INIT_ZERO(Mat<double>, n, 1);
+        f_ref(b) = lbfgs.solve(x);
+    }
+    const double t_ref = elapsed_ms(t0);
+    std::printf("%-10s %9s %8s %6s %9s %10s\n", "solver", "time(ms)", "speedup",
+                "conv", "iter", "rel_err_f");
+    std::printf("%-10s %9.2f %8s %6ld %9s\n", "LBFGS x B", t_ref, "1", long(B), "");
+    int failed = 0;
+    failed |= run<BatchLBFGS<double>>("BatchLBFGS", prob, f_ref, t_ref, 200);
+    failed |= run<BatchBFGS<double>>("BatchBFGS", prob, f_ref, t_ref, 200);
+    failed |= run<BatchGD<double>>("BatchGD", prob, f_ref, t_ref, 2000);
+    return failed;
+}
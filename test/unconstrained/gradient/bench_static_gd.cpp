@@ -0,0 +1,101 @@
+// gradient descent on a small ill-conditioned quadratic, where the per-
+// iteration overhead of the solver is visible: the type-erased GD against
+// StaticGradientDescent with the same components fixed at compile time and
+// a `final` problem. Both have to stop at the same point.
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace optim;
+using Clock = std::chrono::steady_clock;
+
+// code holding the type-erased solvers through their line-search base
+static_assert(std::is_base_of_v<LSBaseSolver<double, false>, GD<double>> &&
+                  std::is_base_of_v<LSBaseSolver<double, true>, ProxGD<double>>,
+              "GD and ProxGD must stay LSBaseSolvers");
+
+struct Quadratic final : GradProblem<double>
+{
+    Mat<double> A, b;
+
+    explicit Quadratic(Index n)
+    {
+        const Mat<double> Q = BMO_INIT_RAND(Mat<double>, n, n);
+        A = BMO_TRANSPOSE(Q) * Q;
+        for (Index i = 0; i < n; i++)
+            A(i, i) += 0.1 * (i + 1);
+        b = BMO_INIT_RAND(Mat<double>, n, 1);
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        return 0.5 * BMO_MAT_DOT_PROD(x, A * x) - BMO_MAT_DOT_PROD(b, x);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        g.noalias() = A * x - b;
+    }
+};
+
+template <typename Solver>
+double time_us(Solver &solver, const Mat<double> &x0, Mat<double> &x, int reps)
+{
+    const auto t0 = Clock::now();
+    for (int r = 0; r < reps; r++)
+    {
+        x = x0;
+        solver.solve(x);
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / reps;
+}
+
+/// @brief solve with the components type-erased and fixed at compile time
+/// @tparam Accel accelerator
+/// @tparam Sched step scheduler
+/// @tparam LS line search, without the problem type
+template <template <typename> class Accel, template <typename> class Sched,
+          template <typename, bool, typename> class LS>
+int run(const char *name, Index n, int reps)
+{
+    auto prob = std::make_shared<Quadratic>(n);
+    const Mat<double> x0 = BMO_INIT_ZERO(Mat<double>, n, 1);
+    Mat<double> x_dyn, x_static;
+    double L = 0; // bound of the largest eigenvalue
+    for (Index i = 0; i < n; i++)
+        L = std::max(L, double(BMO_SUM(BMO_ABS(prob->A.col(i)))));
+
+    GD<double> gd(prob);
+    gd.accelerator = std::make_shared<Accel<double>>();
+    gd.lr_scheduler = std::make_shared<Sched<double>>();
+    LSBaseSolver<double> &ls_solver = gd;
+    ls_solver.ls = std::make_shared<LS<double, false, GradProblem<double>>>();
+    gd.step = 1. / L, gd.gtol = 1e-8, gd.max_iter = 100000;
+
+    StaticGradientDescent<double, Quadratic, Accel<double>,
+                          Sched<double>, LS<double, false, Quadratic>>
+        sgd(prob);
+    sgd.step = 1. / L, sgd.gtol = 1e-8, sgd.max_iter = 100000;
+
+    const double t_dyn = time_us(gd, x0, x_dyn, reps),
+                 t_static = time_us(sgd, x0, x_static, reps);
+    Mat<double> diff = x_dyn - x_static;
+    const double err = BMO_FRO_NORM(diff);
+    std::printf("%-9s %4ld %6d %6d %12.2f %12.2f %8.2f %10.2e\n", name, long(n),
+                gd.n_iter(), sgd.n_iter(), t_dyn, t_static, t_dyn / t_static, err);
+    return gd.n_iter() != sgd.n_iter() || err > 1e-12;
+}
+
+int main(int argc, char const *argv[])
+{
+    int failed = 0;
+    std::printf("%-9s %4s %6s %6s %12s %12s %8s %10s\n", "accel", "n",
+                "iter", "iter_s", "erased(us)", "static(us)", "speedup", "diff_x");
+    for (Index n : {4, 16, 64})
+    {
+        const int reps = int(4000 / n);
+        failed |= run<GDAccelerator, BBStepScheduler, MTLineSearch>("BB+MT", n, reps);
+        failed |= run<Nesterov, StepScheduler, LineSearch>("Nesterov", n, reps);
+    }
+    return failed;
+}
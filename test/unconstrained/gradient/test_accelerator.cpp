@@ -0,0 +1,99 @@
+// Gradient descent hands the gradient the line search evaluated at the
+// accepted point to the accelerator. An accelerator of its own that moves
+// cur_x in place before asking for the gradient must get the gradient at the
+// new point, whatever the line search, while the plain and the built-in
+// accelerators keep getting it for free from HZLS, which evaluates the loss
+// and the gradient together.
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "line_search/Armijo.hpp"
+#include "line_search/Hager_Zhang.hpp"
+#include <cstdio>
+
+using namespace optim;
+
+/// @brief f = sum (i + 1) x_i^2, counting the gradients evaluated on their own
+struct Quad : GradProblem<double>
+{
+    long n_grad = 0;
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        for (Index i = 0; i < BMO_SIZE(x); i++)
+            g(i) = 2 * (i + 1) * x(i);
+        return loss(x);
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        double f = 0;
+        for (Index i = 0; i < BMO_SIZE(x); i++)
+            f += (i + 1) * x(i) * x(i);
+        return f;
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_grad++;
+        for (Index i = 0; i < BMO_SIZE(x); i++)
+            g(i) = 2 * (i + 1) * x(i);
+    }
+};
+
+/// @brief looks ahead by half the last step, in place, and checks the gradient it gets there
+struct LookAhead : GDAccelerator<double>
+{
+    int stale = 0;
+
+    void update(int, GradFunc grad_f, BaseArgs &arg) override
+    {
+        arg.cur_x += 0.5 * (arg.cur_x - arg.prev_x);
+        grad_f(arg.cur_x, arg.cur_grad);
+        for (Index i = 0; i < BMO_SIZE(arg.cur_x); i++)
+            stale += arg.cur_grad(i) != 2 * (i + 1) * arg.cur_x(i);
+        arg.direction = -arg.cur_grad;
+    }
+};
+
+int failed = 0;
+
+/// @return gradients evaluated on their own per iteration
+template <typename LS>
+double run(const char *name, const char *ls, std::shared_ptr<GDAccelerator<double>> acc)
+{
+    auto prob = std::make_shared<Quad>();
+    GD<double> gd(prob);
+    gd.ls = std::make_shared<LS>();
+    gd.accelerator = acc;
+    gd.max_iter = 50;
+    gd.step = 0.1;
+    Mat<double> x = BMO_INIT_ZERO(Mat<double>, 10, 1);
+    for (Index i = 0; i < BMO_SIZE(x); i++)
+        x(i) = 1;
+    gd.solve(x);
+    const double per_iter = double(prob->n_grad) / gd.n_iter();
+    std::printf("%-10s %-6s %6d %8.2f\n", name, ls, gd.n_iter(), per_iter);
+    return per_iter;
+}
+
+/// @brief the look-ahead accelerator must see the gradient at its own point
+template <typename LS>
+void check_lookahead(const char *ls)
+{
+    auto look = std::make_shared<LookAhead>();
+    run<LS>("lookahead", ls, look);
+    if (look->stale)
+        std::printf("%d stale gradient entries under %s\n", look->stale, ls);
+    failed |= look->stale != 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    logger.set_verbosity("error");
+    std::printf("%-10s %-6s %6s %9s\n", "accel", "ls", "iter", "grad/iter");
+    // Armijo evaluates the gradient only when asked, HZLS on every trial
+    check_lookahead<ArmijoLineSearch<double>>("Armijo");
+    check_lookahead<HZLS<double>>("HZLS");
+    failed |= run<HZLS<double>>("plain", "HZLS", std::make_shared<GDAccelerator<double>>()) != 0;
+    failed |= run<HZLS<double>>("adam", "HZLS", std::make_shared<Adam<double>>()) != 0;
+    return failed;
+}
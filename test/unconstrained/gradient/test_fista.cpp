@@ -0,0 +1,183 @@
+// FISTA on an ill-conditioned LASSO problem. Without restart, the loss must
+// stay within the bound of Beck and Teboulle, F(x_k) - F* <= 2 eta L |x_0 - x*|^2
+// / (k + 1)^2. The monotone variant must never increase the loss, adaptive
+// restart must reach a tight accuracy in 40% fewer iterations than plain FISTA,
+// and FISTA must end far below proximal gradient descent with a backtracking
+// line search after the same number of iterations. The solver must not
+// allocate once its buffers are sized.
+#define OPTIM_INSTRUMENT
+#define OPTIM_CHECK_NO_MALLOC
+#include "unconstrained/gradient/FISTA.hpp"
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "line_search/Zhang_Hager.hpp"
+#include "functions/functions.hpp"
+#include <cstdio>
+
+using namespace optim;
+
+/// @brief f = 0.5 |A x - b|^2 + mu |x|_1, recording F at every point the non-smooth part is taken at
+struct LASSO : ProxGradProblem<double>
+{
+    Mat<double> A, b, r;
+    double mu;
+    std::vector<double> history;
+
+    LASSO(Index m, Index n, double mu) : mu(mu)
+    {
+        // neighbouring columns are correlated
+        A = BMO_INIT_RAND(Mat<double>, m, n);
+        for (Index j = 1; j < n; j++)
+            for (Index i = 0; i < m; i++)
+                A(i, j) = 0.5 * A(i, j - 1) + 0.5 * A(i, j);
+        Mat<double> x0 = BMO_INIT_ZERO(Mat<double>, n, 1);
+        for (Index i = 0; i < n; i += 20)
+            x0(i) = i % 40 ? 1 : -1;
+        b = A * x0;
+    }
+
+    double sm_loss(const Mat<double> &x) override
+    {
+        r = A * x - b;
+        return 0.5 * BMO_SQUARE_NORM(r);
+    }
+
+    double nsm_loss(const Mat<double> &x) override
+    {
+        const double h = mu * BMO_SUM(BMO_ABS(x));
+        r = A * x - b;
+        history.push_back(0.5 * BMO_SQUARE_NORM(r) + h);
+        return h;
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        r = A * x - b;
+        g = BMO_TRANSPOSE(A) * r;
+    }
+
+    void prox(double step, const Mat<double> &in_x, Mat<double> &out_x) override
+    {
+        fn::prox<1>(step * mu, in_x, out_x);
+    }
+
+    /// @return the largest eigenvalue of A^T A, by power iteration
+    double lipschitz()
+    {
+        Mat<double> v = BMO_INIT_RAND(Mat<double>, BMO_COLS(A), 1), w;
+        double l = 0;
+        for (int i = 0; i < 1000; i++)
+        {
+            w = BMO_TRANSPOSE(A) * (A * v);
+            l = BMO_FRO_NORM(w);
+            v = w / l;
+        }
+        return l;
+    }
+};
+
+int failed = 0;
+
+/// @return iterations until F - F* <= tol, from the recorded losses
+int iters_to(const std::vector<double> &history, double f_star, double tol)
+{
+    for (size_t k = 1; k < history.size(); k++)
+        if (history[k] - f_star <= tol)
+            return int(k);
+    return -1;
+}
+
+int main(int argc, char const *argv[])
+{
+    logger.set_verbosity("error");
+    const Index n = 500;
+    auto prob = std::make_shared<LASSO>(200, n, 0.1);
+    const Mat<double> x0 = BMO_INIT_ZERO(Mat<double>, n, 1);
+
+    FISTA<double> solver(prob);
+    solver.max_iter = 5000;
+    solver.gtol = 1e-10;
+    solver.xtol = solver.ftol = 0;
+    Mat<double> x_star = x0;
+    const double f_star = solver.solve(x_star);
+    std::printf("F* = %.12e after %d iterations, %d restarts\n", f_star, solver.n_iter(), solver.n_restart);
+
+    // convergence bound of plain FISTA with backtracking
+    const double bound = 2 * solver.eta * prob->lipschitz() * BMO_SQUARE_NORM(x_star - x0);
+    solver.restart = FISTARestart::None;
+    solver.gtol = 0;
+    solver.max_iter = 2000;
+    prob->history.clear();
+    Mat<double> x = x0;
+    solver.solve(x);
+    const std::vector<double> plain = prob->history;
+    double worst = 0;
+    for (size_t k = 1; k < plain.size(); k++)
+        worst = std::max(worst, (plain[k] - f_star) * double((k + 1) * (k + 1)) / bound);
+    std::printf("FISTA: max (F_k - F*) (k + 1)^2 / (2 eta L |x_0 - x*|^2) = %.3f\n", worst);
+    failed |= worst > 1;
+
+    // monotone variant
+    solver.monotone = true;
+    bool increased = false;
+    double f_prev = 0;
+    for (int k = 1; k <= 200; k++)
+    {
+        solver.max_iter = k;
+        x = x0;
+        const double f = solver.solve(x);
+        increased |= k > 1 && f > f_prev;
+        f_prev = f;
+    }
+    std::printf("MFISTA: loss never increases over 200 iterations: %s\n", increased ? "no" : "yes");
+    failed |= increased;
+
+    // iterations to a tight accuracy
+    const double tol = 1e-9 * std::abs(f_star);
+    const int k_plain = iters_to(plain, f_star, tol);
+    std::printf("%-10s %-9s %6s %8s %8s %9s\n", "restart", "monotone", "iter", "restarts", "grads", "ls trials");
+    std::printf("%-10s %-9s %6d\n", "none", "no", k_plain);
+    failed |= k_plain < 0;
+    const std::pair<FISTARestart, const char *> restarts[] = {
+        {FISTARestart::None, "none"},
+        {FISTARestart::Function, "function"},
+        {FISTARestart::Gradient, "gradient"}};
+    for (auto &r : restarts)
+        for (bool monotone : {false, true})
+        {
+            solver.restart = r.first;
+            solver.monotone = monotone;
+            solver.max_iter = 2000;
+            prob->history.clear();
+            x = x0;
+            solver.solve(x);
+            const int k = iters_to(prob->history, f_star, tol);
+            const SolverStats &s = solver.stats();
+            std::printf("%-10s %-9s %6d %8d %8ld %9ld\n", r.second, monotone ? "yes" : "no",
+                        k, solver.n_restart, s.n_grad + s.n_loss_grad, s.n_ls_trials);
+            // one gradient per iteration, at the extrapolated point
+            failed |= s.n_grad + s.n_loss_grad != solver.n_iter();
+            if (r.first != FISTARestart::None)
+                failed |= k < 0 || k > 0.6 * k_plain;
+            else
+                failed |= k < 0;
+        }
+
+    // proximal gradient descent for as many iterations
+    const int k_cmp = 300;
+    ProxGD<double> gd(prob);
+    gd.ls = std::make_shared<ZHLS<double, true>>();
+    gd.step = 1;
+    gd.max_iter = k_cmp;
+    gd.xtol = gd.ftol = gd.gtol = 0;
+    x = x0;
+    const double f_gd = gd.solve(x);
+    solver.restart = FISTARestart::None;
+    solver.monotone = false;
+    solver.max_iter = k_cmp;
+    x = x0;
+    const double f_fista = solver.solve(x);
+    std::printf("after %d iterations: ProxGD F - F* = %.3e, FISTA F - F* = %.3e\n",
+                k_cmp, f_gd - f_star, f_fista - f_star);
+    failed |= f_fista - f_star > 1e-2 * (f_gd - f_star);
+    return failed;
+}
@@ -0,0 +1,179 @@
+// nonlinear CG with every choice of beta, with and without low-memory line
+// search arguments, on a Rosenbrock chain and a badly scaled log-cosh chain.
+// Both modes must reach the same point, and the low-memory mode must keep no
+// more than x, the two gradients and the direction, which glibc's heap
+// statistics show against L-BFGS. The problems are large enough for every
+// vector to bypass the thread cache, which counts freed blocks as in use.
+#include "unconstrained/gradient/Conjugate_Gradient.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include "line_search/Zhang_Hager.hpp"
+#include "line_search/More_Thuente.hpp"
+#include <malloc.h>
+#include <cstdio>
+
+using namespace optim;
+
+/// @brief f = sum 100 (x_{i+1} - x_i^2)^2 + (1 - x_i)^2
+struct ChainRosenbrock : GradProblem<double>
+{
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        BMO_SET_ZERO(g);
+        for (Index i = 0; i + 1 < n; i++)
+        {
+            const double a = x(i + 1) - x(i) * x(i), b = 1 - x(i);
+            f += 100 * a * a + b * b;
+            g(i) += -400 * a * x(i) - 2 * b;
+            g(i + 1) += 200 * a;
+        }
+        return f;
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        for (Index i = 0; i + 1 < n; i++)
+        {
+            const double a = x(i + 1) - x(i) * x(i), b = 1 - x(i);
+            f += 100 * a * a + b * b;
+        }
+        return f;
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+};
+
+/// @brief f = sum w_i log cosh(x_i - c_i) + 0.5 (x_{i+1} - x_i)^2
+struct LogCoshChain : GradProblem<double>
+{
+    Mat<double> w, c;
+
+    explicit LogCoshChain(Index n)
+    {
+        w.resize(n, 1);
+        for (Index i = 0; i < n; i++)
+            w(i) = std::pow(1e2, double(i) / double(n - 1));
+        c = 3 * BMO_INIT_RAND(Mat<double>, n, 1);
+    }
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        for (Index i = 0; i < n; i++)
+        {
+            const double u = std::abs(x(i) - c(i));
+            f += w(i) * (u + std::log1p(std::exp(-2 * u)) - std::log(2.));
+            g(i) = w(i) * std::tanh(x(i) - c(i));
+            if (i > 0)
+                g(i) += x(i) - x(i - 1);
+            if (i + 1 < n)
+            {
+                f += 0.5 * (x(i + 1) - x(i)) * (x(i + 1) - x(i));
+                g(i) -= x(i + 1) - x(i);
+            }
+        }
+        return f;
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        return loss_and_grad(x, g);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+};
+
+/// @return bytes of heap in use
+size_t heap_in_use() { return mallinfo2().uordblks; }
+
+int failed = 0;
+
+void run(const char *name, std::shared_ptr<GradProblem<double>> prob, const Mat<double> &x0)
+{
+    const Index n = BMO_SIZE(x0);
+    const std::pair<CGBeta, const char *> betas[] = {
+        {CGBeta::PRPlus, "PR+"},
+        {CGBeta::HestenesStiefel, "HS"},
+        {CGBeta::DaiYuan, "DY"},
+        {CGBeta::HagerZhang, "HZ"}};
+    for (auto &b : betas)
+    {
+        Mat<double> x[2], g(n, 1);
+        double f[2];
+        int iters[2];
+        size_t kept[2];
+        for (int v = 0; v < 2; v++)
+        {
+            NonlinearCG<double> cg(prob);
+            cg.beta = b.first;
+            cg.low_memory = v;
+            cg.max_iter = 20000;
+            x[v] = x0;
+            const size_t before = heap_in_use();
+            f[v] = cg.solve(x[v]), iters[v] = cg.n_iter();
+            kept[v] = heap_in_use() - before;
+            prob->grad(x[v], g);
+            std::printf("%-10s %-3s %-6s %6d %8d %16.10e %10.2e %6.1f\n", name, b.second,
+                        v ? "low" : "normal", iters[v], cg.n_restart, f[v], BMO_FRO_NORM(g),
+                        double(kept[v]) / double(n * sizeof(double)));
+            failed |= cg.status != 0 || BMO_FRO_NORM(g) > 1e-5;
+        }
+        // moving x in place rounds differently from x_0 + step d
+        failed |= std::abs(f[0] - f[1]) > 1e-8 * (std::abs(f[0]) + 1) ||
+                  BMO_FRO_NORM(x[0] - x[1]) > 1e-3 * (BMO_FRO_NORM(x[0]) + 1);
+        // x, the gradients and the direction, against two more points and two
+        // more gradients
+        failed |= kept[1] > 3.5 * n * sizeof(double) || kept[1] >= kept[0];
+    }
+
+    // low-memory arguments with another line search that keeps no points,
+    // which without a curvature condition only makes steady progress
+    NonlinearCG<double> cg(prob, std::make_shared<ZHLS<double>>());
+    cg.low_memory = true;
+    cg.max_iter = 20000;
+    Mat<double> x = x0, g(n, 1);
+    prob->grad(x, g);
+    const double g0_nrm = BMO_FRO_NORM(g), f = cg.solve(x);
+    prob->grad(x, g);
+    std::printf("%-10s %-3s %-6s %6d %8d %16.10e %10.2e\n", name, "HZ", "ZHLS",
+                cg.n_iter(), cg.n_restart, f, BMO_FRO_NORM(g));
+    failed |= BMO_FRO_NORM(g) > 1e-3 * g0_nrm;
+
+    // MTLS keeps points of its own, the solver must refuse and leave x as it was
+    NonlinearCG<double> mt_cg(prob, std::make_shared<MTLS<double>>());
+    mt_cg.low_memory = true;
+    x = x0;
+    bool thrown = false;
+    try
+    {
+        mt_cg.solve(x);
+    }
+    catch (const std::invalid_argument &)
+    {
+        thrown = true;
+    }
+    failed |= !thrown || BMO_SIZE(x) != n || BMO_FRO_NORM(x - x0) != 0;
+
+    LBFGS<double> lbfgs(prob);
+    lbfgs.m = 4;
+    x = x0;
+    const size_t before = heap_in_use();
+    lbfgs.solve(x);
+    std::printf("%-10s L-BFGS (m = 4) keeps %.1f vectors\n", name,
+                double(heap_in_use() - before) / double(n * sizeof(double)));
+}
+
+int main(int argc, char const *argv[])
+{
+    logger.set_verbosity("error");
+    std::printf("%-10s %-3s %-6s %6s %8s %16s %10s %6s\n",
+                "problem", "b", "args", "iter", "restarts", "loss", "|g|", "kept");
+    run("rosenbrock", std::make_shared<ChainRosenbrock>(), BMO_INIT_ZERO(Mat<double>, 200, 1));
+    run("logcosh", std::make_shared<LogCoshChain>(1000), BMO_INIT_ZERO(Mat<double>, 1000, 1));
+    return failed;
+}
@@ -0,0 +1,73 @@
+// least squares as a finite sum of 16-sample shards: plain SGD, SVRG and
+// SAGA for a few passes, compared with L-BFGS on the full problem.
+#include "unconstrained/gradient/Stochastic_Gradient.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+
+using namespace optim;
+
+struct LeastSquares : FiniteSumProblem<double>
+{
+    static constexpr Index shard_size = 16;
+    Mat<double> A, b; // samples by column
+
+    LeastSquares(Index n_features, Index n_samples)
+    {
+        A = BMO_INIT_RAND(Mat<double>, n_features, n_samples);
+        b = BMO_TRANSPOSE(A) * BMO_INIT_RAND(Mat<double>, n_features, 1);
+        b += 0.1 * BMO_INIT_RAND(Mat<double>, n_samples, 1);
+    }
+
+    Index n_shards() const override { return BMO_COLS(A) / shard_size; }
+
+    double shard_loss(Index s, const Mat<double> &x) override
+    {
+        double loss = 0;
+        for (Index j = s * shard_size; j < (s + 1) * shard_size; j++)
+        {
+            const double r = BMO_DOT_PROD(A.col(j), x.col(0)) - b(j);
+            loss += 0.5 * r * r;
+        }
+        return loss;
+    }
+
+    void shard_grad(Index s, const Mat<double> &x, Mat<double> &g) override
+    {
+        for (Index j = s * shard_size; j < (s + 1) * shard_size; j++)
+            g += (BMO_DOT_PROD(A.col(j), x.col(0)) - b(j)) * A.col(j);
+    }
+};
+
+int main(int argc, char const *argv[])
+{
+    const Index d = 20;
+    auto prob = std::make_shared<LeastSquares>(d, 1 << 14);
+    Mat<double> x = BMO_INIT_ZERO(Mat<double>, d, 1);
+    LBFGS<double> lbfgs(prob);
+    lbfgs.max_iter = 200;
+    const double f_opt = lbfgs.solve(x);
+    // step 1 / (3 L), L the largest Lipschitz constant of a shard
+    // times the N / |B| scaling of the estimate
+    double L = 0;
+    for (Index j = 0; j < BMO_COLS(prob->A); j++)
+        L = std::max(L, double(BMO_SQUARE_NORM(prob->A.col(j))));
+    const double step = 1. / (3 * L * LeastSquares::shard_size * prob->n_shards());
+    std::shared_ptr<StochasticGradEstimator<double>> estimators[] = {
+        std::make_shared<StochasticGradEstimator<double>>(),
+        std::make_shared<SVRGEstimator<double>>(),
+        std::make_shared<SAGAEstimator<double>>()};
+    const char *names[] = {"SGD", "SVRG", "SAGA"};
+    double gap[3];
+    for (int i = 0; i < 3; i++)
+    {
+        StochasticGradient<double> solver(prob, estimators[i]);
+        solver.step = step;
+        solver.max_epoch = 20;
+        solver.ftol = 0;
+        BMO_SET_ZERO(x);
+        gap[i] = solver.solve(x) - f_opt;
+        std::cout << names[i] << " gap after " << solver.epoch
+                  << " passes: " << gap[i] << std::endl;
+    }
+    // variance reduction reaches the optimum, plain SGD stalls at the noise floor
+    return !(gap[1] < 1e-6 * f_opt && gap[2] < 1e-6 * f_opt);
+}
@@ -0,0 +1,122 @@
+// many tiny calibration problems: a softplus fit of n = 2, 4, 8 parameters
+// to 16 samples, solved from random starts by BFGS and Newton with sizes
+// known at runtime only and fixed at compile time. Both have to reach the
+// same minimum.
+#include "unconstrained/newton/BFGS.hpp"
+#include "unconstrained/newton/NewtonMethod.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace optim;
+using Clock = std::chrono::steady_clock;
+
+constexpr int n_samples = 16;
+
+/// @brief sum_m softplus(a_m x - b_m) + lambda / 2 |x|^2, x of size NS or n
+template <int NS>
+struct SoftplusFit final : HessProblem<double, NS, 1>
+{
+    using Vec = Mat<double, NS, 1>;
+    Mat<double, n_samples, NS> A;
+    Mat<double, n_samples, 1> b, r;
+    Mat<double, NS, NS> H;
+    double lambda = 0.1;
+
+    SoftplusFit(const Mat<double> &A0, const Mat<double> &b0) : A(A0), b(b0) {}
+
+    static double softplus(double u) { return std::max(u, 0.) + std::log1p(std::exp(-std::abs(u))); }
+    static double sigmoid(double u) { return 1 / (1 + std::exp(-u)); }
+
+    double loss(const Vec &x) override
+    {
+        r.noalias() = A * x - b;
+        double f = 0.5 * lambda * BMO_SQUARE_NORM(x);
+        for (int m = 0; m < n_samples; m++)
+            f += softplus(r(m));
+        return f;
+    }
+
+    void grad(const Vec &x, Vec &g) override
+    {
+        r.noalias() = A * x - b;
+        for (int m = 0; m < n_samples; m++)
+            r(m) = sigmoid(r(m));
+        g.noalias() = BMO_TRANSPOSE(A) * r;
+        g += lambda * x;
+    }
+
+    void update_hess(const Vec &x) override
+    {
+        r.noalias() = A * x - b;
+        for (int m = 0; m < n_samples; m++)
+            r(m) = sigmoid(r(m)) * (1 - sigmoid(r(m)));
+        H.noalias() = BMO_TRANSPOSE(A) * BMO_AS_DIAG(r) * A;
+        H.diagonal().array() += lambda;
+    }
+
+    void hess_backward(const Vec &x, Vec &d) override
+    {
+        d = BMO_LDLT_SOLVE(H, x);
+    }
+};
+
+/// @brief solve from every start, return the time per solve in us and the largest distance between the solutions
+template <template <typename, int, int> class Solver, int NS>
+double run(const Mat<double> &A, const Mat<double> &b,
+           const std::vector<Mat<double>> &starts,
+           std::vector<Mat<double>> &sol, int &iters)
+{
+    auto prob = std::make_shared<SoftplusFit<NS>>(A, b);
+    Solver<double, NS, 1> solver(prob);
+    Mat<double, NS, 1> x;
+    iters = 0;
+    sol.resize(starts.size());
+    const auto t0 = Clock::now();
+    for (size_t i = 0; i < starts.size(); i++)
+    {
+        x = starts[i];
+        solver.solve(x);
+        iters += solver.n_iter();
+        sol[i] = x;
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / starts.size();
+}
+
+template <template <typename, int, int> class Solver, int N>
+int compare(const char *name, int n_starts)
+{
+    const Mat<double> A = BMO_INIT_RAND(Mat<double>, n_samples, N),
+                      b = BMO_INIT_RAND(Mat<double>, n_samples, 1);
+    std::vector<Mat<double>> starts(n_starts), sol_dyn, sol_fixed;
+    for (auto &x : starts)
+        x = 3 * BMO_INIT_RAND(Mat<double>, N, 1);
+    int it_dyn, it_fixed;
+    const double t_dyn = run<Solver, Dynamic>(A, b, starts, sol_dyn, it_dyn),
+                 t_fixed = run<Solver, N>(A, b, starts, sol_fixed, it_fixed);
+    double err = 0;
+    for (int i = 0; i < n_starts; i++)
+    {
+        Mat<double> diff = sol_dyn[i] - sol_fixed[i];
+        err = std::max(err, double(BMO_FRO_NORM(diff)));
+    }
+    std::printf("%-7s %3d %8.2f %8.2f %11.3f %11.3f %8.2f %10.2e\n", name, N,
+                double(it_dyn) / n_starts, double(it_fixed) / n_starts,
+                t_dyn, t_fixed, t_dyn / t_fixed, err);
+    return err > 1e-6;
+}
+
+int main(int argc, char const *argv[])
+{
+    const int n_starts = 20000;
+    int failed = 0;
+    logger.set_verbosity("error"); // far starts exhaust the line search
+    std::printf("%-7s %3s %8s %8s %11s %11s %8s %10s\n", "solver", "n", "iter",
+                "iter_fix", "dynamic(us)", "fixed(us)", "speedup", "diff_x");
+    failed |= compare<BFGS, 2>("BFGS", n_starts);
+    failed |= compare<BFGS, 4>("BFGS", n_starts);
+    failed |= compare<BFGS, 8>("BFGS", n_starts);
+    failed |= compare<NewtonMethod, 2>("Newton", n_starts);
+    failed |= compare<NewtonMethod, 4>("Newton", n_starts);
+    failed |= compare<NewtonMethod, 8>("Newton", n_starts);
+    return failed;
+}
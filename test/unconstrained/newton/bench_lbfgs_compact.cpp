@@ -0,0 +1,65 @@
+// time of one L-BFGS direction update: two-loop recursion vs compact form.
+// both are fed the same (s, y) pairs from a diagonal quadratic and must
+// produce the same direction up to rounding.
+#include "unconstrained/newton/LBFGS.hpp"
+#include "unconstrained/newton/CompactLBFGS.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace optim;
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char const *argv[])
+{
+    const int ms[] = {3, 5, 10, 20};
+    const Index ns[] = {10000, 100000, 1000000};
+    const int reps = 20;
+    std::printf("%8s %4s %14s %14s %10s\n",
+                "n", "m", "two-loop(us)", "compact(us)", "rel_err");
+    for (Index n : ns)
+        for (int m : ms)
+        {
+            Mat<double> w = BMO_INIT_RAND(Mat<double>, n, 1);
+            w = BMO_ARRAY_ADD_SCALAR(BMO_ABS(w), 1.);
+            LineSearchArgs<double, false> arg(BMO_INIT_RAND(Mat<double>, n, 1));
+            CircularArray<internal::LBFGS::Storage<double>> memory;
+            internal::LBFGS::Storage<double> sy{};
+            internal::CompactLBFGS::Memory<double> compact;
+            memory.reset(m), compact.reset(n, m);
+            Mat<double> d(n, 1);
+            double t_two_loop = 0, t_compact = 0, err = 0;
+            arg.cur_grad = BMO_ARRAY_MUL(arg.cur_x, w);
+            arg.direction = -arg.cur_grad;
+            compact.steepest_descent();
+            for (int k = 0; k < m + reps; k++)
+            { // fixed step along the current direction
+                arg.flush();
+                arg.cur_x = arg.prev_x + 0.5 * arg.direction;
+                arg.cur_grad = BMO_ARRAY_MUL(arg.cur_x, w);
+                // two-loop: store (s, y), then 4m vector passes
+                auto t0 = Clock::now();
+                sy.s = arg.cur_x - arg.prev_x;
+                sy.y = arg.cur_grad - arg.prev_grad;
+                const double sTy = BMO_MAT_DOT_PROD(sy.s, sy.y);
+                const double gamma = sTy / BMO_SQUARE_NORM(sy.y);
+                sy.rho = 1. / sTy;
+                memory.push_back(std::move(sy));
+                d = -arg.cur_grad;
+                internal::LBFGS::lbfgs_update_direction(gamma, memory, d);
+                auto t1 = Clock::now();
+                // compact: W^T g, O(m^2) update, W q
+                compact.update(0.5, arg);
+                compact.direction(arg.cur_grad, arg.direction);
+                auto t2 = Clock::now();
+                if (k >= m)
+                { // memory is full
+                    t_two_loop += std::chrono::duration<double, std::micro>(t1 - t0).count();
+                    t_compact += std::chrono::duration<double, std::micro>(t2 - t1).count();
+                }
+                err = std::max(err, double(BMO_FRO_NORM(d - arg.direction) / BMO_FRO_NORM(d)));
+            }
+            std::printf("%8ld %4d %14.1f %14.1f %10.2e\n", long(n), m,
+                        t_two_loop / reps, t_compact / reps, err);
+        }
+    return 0;
+}
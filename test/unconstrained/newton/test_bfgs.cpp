@@ -0,0 +1,93 @@
+// BFGS with the inverse Hessian and with the Cholesky factor of the Hessian
+// on a log-cosh chain of n = 2000, cheap enough that the O(n^2) update is
+// the whole cost of an iteration. Both are the same method in exact
+// arithmetic, so they must reach the same minimum in a similar number of
+// iterations. Then a badly scaled quadratic, where the curvature pairs are
+// skipped rather than spoiling the factor.
+#include "unconstrained/newton/BFGS.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace optim;
+using Clock = std::chrono::steady_clock;
+
+/// @brief f = sum w_i log cosh(x_i - c_i) + 0.5 x_i^2 + 0.5 (x_{i+1} - x_i)^2
+struct LogCoshChain : GradProblem<double>
+{
+    Mat<double> w, c;
+
+    explicit LogCoshChain(Index n, double spread)
+    {
+        w.resize(n, 1);
+        for (Index i = 0; i < n; i++)
+            w(i) = std::pow(spread, double(i) / double(n - 1));
+        c = 3 * BMO_INIT_RAND(Mat<double>, n, 1);
+    }
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        for (Index i = 0; i < n; i++)
+        {
+            const double u = std::abs(x(i) - c(i));
+            f += w(i) * (u + std::log1p(std::exp(-2 * u)) - std::log(2.)) + 0.5 * x(i) * x(i);
+            g(i) = w(i) * std::tanh(x(i) - c(i)) + x(i);
+            if (i > 0)
+                g(i) += x(i) - x(i - 1);
+            if (i + 1 < n)
+            {
+                f += 0.5 * (x(i + 1) - x(i)) * (x(i + 1) - x(i));
+                g(i) -= x(i + 1) - x(i);
+            }
+        }
+        return f;
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        return loss_and_grad(x, g);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+};
+
+int failed = 0;
+
+void run(const char *name, Index n, double spread, int max_iter)
+{
+    auto prob = std::make_shared<LogCoshChain>(n, spread);
+    BFGS<double> bfgs(prob);
+    bfgs.max_iter = max_iter;
+    bfgs.gtol = 1e-4;
+    Mat<double> x[2];
+    double f[2];
+    int iters[2];
+    for (int v = 0; v < 2; v++)
+    {
+        bfgs.cholesky = v == 1;
+        x[v] = BMO_INIT_ZERO(Mat<double>, n, 1);
+        const auto t0 = Clock::now();
+        f[v] = bfgs.solve(x[v]);
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        iters[v] = bfgs.n_iter();
+        Mat<double> g(n, 1);
+        prob->grad(x[v], g);
+        std::printf("%-10s %6ld %-9s %6d %10.3f ms/iter %14.8e |g| %.2e status %d\n", name, long(n),
+                    v ? "cholesky" : "inverse", iters[v], ms / iters[v], f[v], BMO_FRO_NORM(g), bfgs.status);
+        failed |= bfgs.status != 0 || BMO_FRO_NORM(g) > 1e-4;
+    }
+    failed |= std::abs(f[0] - f[1]) > 1e-8 * (1 + std::abs(f[0])) ||
+              BMO_FRO_NORM(x[0] - x[1]) > 1e-3 * std::sqrt(double(n)) ||
+              std::abs(iters[0] - iters[1]) > iters[0] / 4 + 5;
+}
+
+int main(int argc, char const *argv[])
+{
+    logger.set_verbosity("error");
+    std::printf("%-10s %6s %-9s %6s %18s %14s\n", "problem", "n", "variant", "iter", "time", "loss");
+    run("chain", 2000, 1e2, 2000);
+    run("scaled", 200, 1e4, 5000);
+    return failed;
+}
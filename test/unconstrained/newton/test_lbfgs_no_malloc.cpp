@@ -0,0 +1,57 @@
+// solvers must not allocate once their workspace is sized,
+// any heap allocation inside the main loop trips an assertion.
+#define OPTIM_CHECK_NO_MALLOC
+#include "unconstrained/newton/LBFGS.hpp"
+#include "unconstrained/newton/BFGS.hpp"
+#include "unconstrained/gradient/Gradient_Descent.hpp"
+#include "unconstrained/gradient/Conjugate_Gradient.hpp"
+
+using namespace optim;
+
+struct Quadratic : GradProblem<double>
+{
+    Mat<double> w;
+
+    Quadratic(int n)
+    {
+        w = BMO_INIT_RAND(Mat<double>, n, 1);
+        w = BMO_ARRAY_ADD_SCALAR(BMO_ABS(w), 1.);
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        return 0.5 * BMO_SUM(BMO_ARRAY_MUL(BMO_ARRAY_MUL(x, x), w)) + BMO_SUM(x);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        g = BMO_ARRAY_MUL(x, w);
+        g = BMO_ARRAY_ADD_SCALAR(g, 1.);
+    }
+};
+
+int main(int argc, char const *argv[])
+{
+    const int n = 64;
+    auto prob = std::make_shared<Quadratic>(n);
+    LBFGS<double> lbfgs(prob);
+    BFGS<double> bfgs(prob);
+    GD<double> gd(prob);
+    gd.lr_scheduler = std::make_shared<BBStepScheduler<double>>();
+    NonlinearCG<double> cg(prob);
+    Mat<double> x(n, 1);
+    for (int i = 0; i < 3; i++)
+    { // the workspace is reused from the second call on
+        BMO_SET_ZERO(x);
+        std::cout << "LBFGS loss: " << lbfgs.solve(x) << std::endl;
+        BMO_SET_ZERO(x);
+        std::cout << "BFGS loss: " << bfgs.solve(x) << std::endl;
+        bfgs.cholesky = !bfgs.cholesky;
+        BMO_SET_ZERO(x);
+        std::cout << "GD loss: " << gd.solve(x) << std::endl;
+        BMO_SET_ZERO(x);
+        std::cout << "NonlinearCG loss: " << cg.solve(x) << std::endl;
+        cg.low_memory = !cg.low_memory;
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// nonnegative least squares min 0.5 |Ax - b|^2 s.t. 0 <= x <= 1,
+// compared against many projected gradient steps.
+#include "unconstrained/newton/LBFGSB.hpp"
+
+using namespace optim;
+
+struct BoxLS : GradProblem<double>
+{
+    Mat<double> A, b;
+
+    BoxLS(int m, int n)
+    {
+        A = BMO_INIT_RAND(Mat<double>, m, n);
+        b = BMO_INIT_RAND(Mat<double>, m, 1);
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        return 0.5 * BMO_SQUARE_NORM(A * x - b);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        g = BMO_TRANSPOSE(A) * (A * x - b);
+    }
+};
+
+int main(int argc, char const *argv[])
+{
+    const int m = 80, n = 120;
+    auto prob = std::make_shared<BoxLS>(m, n);
+    Mat<double> lower = BMO_INIT_ZERO(Mat<double>, n, 1),
+                upper = BMO_INIT_ZERO(Mat<double>, n, 1);
+    upper = BMO_ARRAY_ADD_SCALAR(upper, 1.);
+    LBFGSB<double> solver(prob, lower, upper);
+    solver.m = 8;
+    Mat<double> x = BMO_INIT_ZERO(Mat<double>, n, 1);
+    const double f = solver.solve(x);
+    // projected gradient reference
+    Mat<double> z = BMO_INIT_ZERO(Mat<double>, n, 1), g;
+    const double L = BMO_SQUARE_NORM(prob->A);
+    for (int i = 0; i < 100000; i++)
+    {
+        prob->grad(z, g);
+        z -= g / L;
+        for (int j = 0; j < n; j++)
+            z(j) = std::min(std::max(z(j), 0.), 1.);
+    }
+    std::cout << "L-BFGS-B loss: " << f << " in " << solver.n_iter()
+              << " iterations, projected gradient loss: " << prob->loss(z)
+              << std::endl;
+    return std::abs(f - prob->loss(z)) > 1e-6 * (1 + std::abs(f));
+}
@@ -0,0 +1,244 @@
+// Levenberg-Marquardt on small dense least-squares problems of the More,
+// Garbow & Hillstrom collection, with and without geodesic acceleration,
+// against L-BFGS on the same problems seen as a GradProblem. Then the
+// extended Rosenbrock function with n = 2000, whose Jacobian is given as a
+// sparse matrix and as products, solved by LSQR.
+#include "unconstrained/newton/LevenbergMarquardt.hpp"
+#include "unconstrained/newton/LBFGS.hpp"
+#include <cstdio>
+
+using namespace optim;
+
+struct Rosenbrock : LeastSquaresProblem<double>
+{
+    Index n_residuals() const override { return 2; }
+
+    void residual(const Mat<double> &x, Mat<double> &r) override
+    {
+        r(0) = 10 * (x(1) - x(0) * x(0));
+        r(1) = 1 - x(0);
+    }
+
+    void jacobian(const Mat<double> &x, Mat<double> &J) override
+    {
+        J << -20 * x(0), 10,
+            -1, 0;
+    }
+};
+
+/// @brief Box three-dimensional function, m = 10
+struct Box3D : LeastSquaresProblem<double>
+{
+    Index n_residuals() const override { return 10; }
+
+    void residual(const Mat<double> &x, Mat<double> &r) override
+    {
+        for (Index i = 0; i < 10; i++)
+        {
+            const double t = 0.1 * (i + 1);
+            r(i) = std::exp(-t * x(0)) - std::exp(-t * x(1)) - x(2) * (std::exp(-t) - std::exp(-10 * t));
+        }
+    }
+
+    void jacobian(const Mat<double> &x, Mat<double> &J) override
+    {
+        for (Index i = 0; i < 10; i++)
+        {
+            const double t = 0.1 * (i + 1);
+            J(i, 0) = -t * std::exp(-t * x(0));
+            J(i, 1) = t * std::exp(-t * x(1));
+            J(i, 2) = -(std::exp(-t) - std::exp(-10 * t));
+        }
+    }
+};
+
+/// @brief Meyer function, badly scaled, m = 16
+struct Meyer : LeastSquaresProblem<double>
+{
+    static constexpr double y[16] = {34780, 28610, 23650, 19630, 16370, 13720, 11540, 9744,
+                                     8261, 7030, 6005, 5147, 4427, 3820, 3307, 2872};
+
+    Index n_residuals() const override { return 16; }
+
+    void residual(const Mat<double> &x, Mat<double> &r) override
+    {
+        for (Index i = 0; i < 16; i++)
+        {
+            const double t = 45 + 5 * (i + 1);
+            r(i) = x(0) * std::exp(x(1) / (t + x(2))) - y[i];
+        }
+    }
+
+    void jacobian(const Mat<double> &x, Mat<double> &J) override
+    {
+        for (Index i = 0; i < 16; i++)
+        {
+            const double t = 45 + 5 * (i + 1),
+                         e = std::exp(x(1) / (t + x(2)));
+            J(i, 0) = e;
+            J(i, 1) = x(0) * e / (t + x(2));
+            J(i, 2) = -x(0) * e * x(1) / ((t + x(2)) * (t + x(2)));
+        }
+    }
+};
+
+/// @brief sum of three decaying exponentials fitted to samples, a sloppy model
+struct ExpSum : LeastSquaresProblem<double>
+{
+    Index n_residuals() const override { return 30; }
+
+    static double model(const Mat<double> &x, double t)
+    {
+        return std::exp(-x(0) * t) + std::exp(-x(1) * t) + std::exp(-x(2) * t);
+    }
+
+    void residual(const Mat<double> &x, Mat<double> &r) override
+    {
+        const Mat<double> truth = (Mat<double>(3, 1) << 0.3, 1, 3).finished();
+        for (Index i = 0; i < 30; i++)
+        {
+            const double t = 0.2 * i;
+            r(i) = model(x, t) - model(truth, t);
+        }
+    }
+
+    void jacobian(const Mat<double> &x, Mat<double> &J) override
+    {
+        for (Index i = 0; i < 30; i++)
+        {
+            const double t = 0.2 * i;
+            for (Index k = 0; k < 3; k++)
+                J(i, k) = -t * std::exp(-x(k) * t);
+        }
+    }
+};
+
+/// @brief extended Rosenbrock, r_{2i} = 10 (x_{2i+1} - x_{2i}^2), r_{2i+1} = 1 - x_{2i}
+struct ExtRosenbrock : LeastSquaresProblem<double>
+{
+    Index n;
+    JacobianType type;
+    Mat<double> xj;
+
+    ExtRosenbrock(Index n, JacobianType type) : n(n), type(type) {}
+
+    Index n_residuals() const override { return n; }
+
+    JacobianType jacobian_type() const override { return type; }
+
+    void residual(const Mat<double> &x, Mat<double> &r) override
+    {
+        for (Index i = 0; i < n; i += 2)
+        {
+            r(i) = 10 * (x(i + 1) - x(i) * x(i));
+            r(i + 1) = 1 - x(i);
+        }
+    }
+
+    void sp_jacobian(const Mat<double> &x, SpMat<double> &J) override
+    {
+        std::vector<Eigen::Triplet<double>> entries;
+        for (Index i = 0; i < n; i += 2)
+        {
+            entries.emplace_back(i, i, -20 * x(i));
+            entries.emplace_back(i, i + 1, 10);
+            entries.emplace_back(i + 1, i, -1);
+        }
+        J.setFromTriplets(entries.begin(), entries.end());
+    }
+
+    void update_jac(const Mat<double> &x) override { xj = x; }
+
+    void jac_forward(const Mat<double> &v, Mat<double> &Jv) override
+    {
+        for (Index i = 0; i < n; i += 2)
+        {
+            Jv(i) = -20 * xj(i) * v(i) + 10 * v(i + 1);
+            Jv(i + 1) = -v(i);
+        }
+    }
+
+    void jac_backward(const Mat<double> &u, Mat<double> &Jtu) override
+    {
+        for (Index i = 0; i < n; i += 2)
+        {
+            Jtu(i) = -20 * xj(i) * u(i) - u(i + 1);
+            Jtu(i + 1) = 10 * u(i);
+        }
+    }
+};
+
+/// @brief the problem seen by L-BFGS, counting the residual evaluations
+template <typename P>
+struct Counted : P
+{
+    int n_eval = 0;
+
+    using P::P;
+
+    void residual(const Mat<double> &x, Mat<double> &r) override
+    {
+        n_eval++;
+        P::residual(x, r);
+    }
+};
+
+int failed = 0;
+
+template <typename P>
+void run(const char *name, Mat<double> x0, double f_min)
+{
+    auto prob = std::make_shared<Counted<P>>();
+    LevenbergMarquardt<double> lm(prob);
+    lm.max_iter = 1000;
+    for (bool geodesic : {false, true})
+    {
+        Mat<double> x = x0;
+        lm.geodesic = geodesic;
+        const double f = lm.solve(x);
+        std::printf("%-10s %-12s %6d %8d %6d %8d %14.6e\n", name, geodesic ? "LM+geodesic" : "LM",
+                    lm.n_iter(), lm.n_eval, lm.n_jac, lm.n_factor, f);
+        // one factorization per Jacobian, however many dampings were tried
+        failed |= lm.status != 0 || lm.n_factor != lm.n_jac ||
+                  std::abs(f - f_min) > 1e-6 * (1 + f_min);
+    }
+    LBFGS<double> lbfgs(prob);
+    lbfgs.max_iter = 10000;
+    lbfgs.gtol = 1e-8;
+    Mat<double> x = x0;
+    prob->n_eval = 0;
+    const double f = lbfgs.solve(x);
+    std::printf("%-10s %-12s %6d %8d %6s %8s %14.6e\n", name, "LBFGS",
+                lbfgs.n_iter(), prob->n_eval, "-", "-", f);
+}
+
+int main(int argc, char const *argv[])
+{
+    logger.set_verbosity("error");
+    std::printf("%-10s %-12s %6s %8s %6s %8s %14s\n", "problem", "solver", "iter", "evals", "jac", "factor", "loss");
+    run<Rosenbrock>("Rosenbrock", (Mat<double>(2, 1) << -1.2, 1).finished(), 0);
+    run<Box3D>("Box3D", (Mat<double>(3, 1) << 0, 10, 20).finished(), 0);
+    run<Meyer>("Meyer", (Mat<double>(3, 1) << 0.02, 4000, 250).finished(), 87.9458 / 2);
+    run<ExpSum>("ExpSum", (Mat<double>(3, 1) << 0.1, 2, 10).finished(), 0);
+
+    const Index n = 2000;
+    const Mat<double> x0 = (Mat<double>(2, 1) << -1.2, 1).finished().replicate(n / 2, 1);
+    for (auto type : {JacobianType::Sparse, JacobianType::Operator})
+    {
+        auto prob = std::make_shared<ExtRosenbrock>(n, type);
+        LevenbergMarquardt<double> lm(prob);
+        for (bool geodesic : {false, true})
+        {
+            Mat<double> x = x0;
+            lm.geodesic = geodesic;
+            const double f = lm.solve(x);
+            const double err = (x.array() - 1).abs().maxCoeff();
+            std::printf("%-10s %-12s %6d %8d %6d %8d %14.6e  lsqr_iter: %d\n",
+                        type == JacobianType::Sparse ? "ExtRos/sp" : "ExtRos/op",
+                        geodesic ? "LM+geodesic" : "LM", lm.n_iter(), lm.n_eval, lm.n_jac,
+                        lm.n_factor, f, lm.n_lsqr_iter);
+            failed |= lm.status != 0 || err > 1e-6 || lm.n_factor != 0;
+        }
+    }
+    return failed;
+}
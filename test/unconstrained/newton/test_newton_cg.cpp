@@ -0,0 +1,173 @@
+// Hessian-vector products of NewtonCG with each preconditioner, on two
+// problems with matrix-free Hessians. The log-cosh chain has a diagonal
+// spread over four orders of magnitude, which the diagonal preconditioner
+// removes. The second problem is well conditioned but for a few stiff dense
+// directions, which the L-BFGS preconditioner learns from the previous CG
+// solve. Each must take fewer products than no preconditioner on its problem.
+#include "unconstrained/newton/NewtonCG.hpp"
+
+using namespace optim;
+
+struct LogCoshChain : HessProblem<double>
+{
+    Mat<double> w, c, xh;
+
+    explicit LogCoshChain(Index n)
+    {
+        w.resize(n, 1);
+        for (Index i = 0; i < n; i++)
+            w(i) = std::pow(1e4, double(i) / double(n - 1));
+        c = 3 * BMO_INIT_RAND(Mat<double>, n, 1);
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        for (Index i = 0; i < n; i++)
+        { // log cosh(u) = |u| + log(1 + exp(-2|u|)) - log 2
+            const double u = std::abs(x(i) - c(i));
+            f += w(i) * (u + std::log1p(std::exp(-2 * u)) - std::log(2.));
+            if (i + 1 < n)
+                f += 0.5 * (x(i + 1) - x(i)) * (x(i + 1) - x(i));
+        }
+        return f;
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        const Index n = BMO_SIZE(x);
+        for (Index i = 0; i < n; i++)
+        {
+            g(i) = w(i) * std::tanh(x(i) - c(i));
+            if (i > 0)
+                g(i) += x(i) - x(i - 1);
+            if (i + 1 < n)
+                g(i) -= x(i + 1) - x(i);
+        }
+    }
+
+    void update_hess(const Mat<double> &x) override { xh = x; }
+
+    void hess_forward(const Mat<double> &v, Mat<double> &d) override
+    {
+        const Index n = BMO_SIZE(v);
+        for (Index i = 0; i < n; i++)
+        {
+            const double t = std::tanh(xh(i) - c(i));
+            d(i) = w(i) * (1 - t * t) * v(i);
+            if (i > 0)
+                d(i) += v(i) - v(i - 1);
+            if (i + 1 < n)
+                d(i) -= v(i + 1) - v(i);
+        }
+    }
+
+    void hess_diag(Mat<double> &d) override
+    {
+        const Index n = BMO_SIZE(xh);
+        for (Index i = 0; i < n; i++)
+        {
+            const double t = std::tanh(xh(i) - c(i));
+            d(i) = w(i) * (1 - t * t) + (i > 0) + (i + 1 < n);
+        }
+    }
+};
+
+/// @brief f = 0.5 |x - c|^2 + 0.1 sum log cosh(x_i) + 0.5 sum_j a_j (u_j^T x)^2, with 8 stiff directions u_j of weights up to 1e4
+struct StiffDirections : HessProblem<double>
+{
+    static constexpr int k = 8;
+    Mat<double> U, a, c, xh;
+
+    explicit StiffDirections(Index n)
+    {
+        U = BMO_INIT_RAND(Mat<double>, n, k);
+        a.resize(k, 1);
+        for (int j = 0; j < k; j++)
+            a(j) = std::pow(1e4, double(j + 1) / k) / double(n);
+        c = 3 * BMO_INIT_RAND(Mat<double>, n, 1);
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        const Mat<double> ux = BMO_TRANSPOSE(U) * x, r = x - c;
+        double f = 0.5 * BMO_SQUARE_NORM(r);
+        for (Index i = 0; i < BMO_SIZE(x); i++)
+        {
+            const double u = std::abs(x(i));
+            f += 0.1 * (u + std::log1p(std::exp(-2 * u)) - std::log(2.));
+        }
+        for (int j = 0; j < k; j++)
+            f += 0.5 * a(j) * ux(j) * ux(j);
+        return f;
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        const Mat<double> ux = BMO_ARRAY_MUL(Mat<double>(BMO_TRANSPOSE(U) * x), a);
+        g = x - c + U * ux;
+        for (Index i = 0; i < BMO_SIZE(x); i++)
+            g(i) += 0.1 * std::tanh(x(i));
+    }
+
+    void update_hess(const Mat<double> &x) override { xh = x; }
+
+    void hess_forward(const Mat<double> &v, Mat<double> &d) override
+    {
+        const Mat<double> uv = BMO_ARRAY_MUL(Mat<double>(BMO_TRANSPOSE(U) * v), a);
+        d = v + U * uv;
+        for (Index i = 0; i < BMO_SIZE(v); i++)
+        {
+            const double t = std::tanh(xh(i));
+            d(i) += 0.1 * (1 - t * t) * v(i);
+        }
+    }
+};
+
+/// @brief solve from 0 with each preconditioner
+/// @param with_diag include the diagonal one, which needs hess_diag
+/// @return Hessian-vector products of each, -1 if it failed
+std::vector<int> run(const char *problem, std::shared_ptr<HessProblem<double>> prob,
+                     Index n, bool with_diag)
+{
+    const char *names[] = {"identity", "diagonal", "L-BFGS"};
+    std::vector<int> n_hess_vec(3, 0);
+    for (int i = 0; i < 3; i++)
+    {
+        if (i == 1 && !with_diag)
+            continue;
+        NewtonCG<double> solver(prob);
+        if (i == 1)
+            solver.precond = std::make_shared<DiagPreconditioner<double>>();
+        else if (i == 2)
+        { // room for the stiff directions and a few more
+            auto lbfgs = std::make_shared<LBFGSPreconditioner<double>>();
+            lbfgs->m = 10;
+            solver.precond = lbfgs;
+        }
+        Mat<double> x = BMO_INIT_ZERO(Mat<double>, n, 1), g(n, 1);
+        const double f = solver.solve(x);
+        prob->grad(x, g);
+        std::cout << problem << " " << names[i] << " loss: " << f << " |g|: " << BMO_FRO_NORM(g)
+                  << " iterations: " << solver.n_iter()
+                  << " Hessian-vector products: " << solver.n_hess_vec << std::endl;
+        n_hess_vec[i] = solver.status == 0 ? solver.n_hess_vec : -1;
+    }
+    return n_hess_vec;
+}
+
+int main(int argc, char const *argv[])
+{
+    const Index n = 2000;
+    logger.set_verbosity("error");
+    const auto chain = run("log-cosh chain", std::make_shared<LogCoshChain>(n), n, true);
+    const auto stiff = run("stiff directions", std::make_shared<StiffDirections>(n), n, false);
+    int failed = 0;
+    for (int v : chain)
+        failed |= v < 0;
+    for (int v : stiff)
+        failed |= v < 0;
+    failed |= chain[1] >= chain[0] || stiff[2] >= stiff[0];
+    return failed;
+}
@@ -0,0 +1,72 @@
+// chain of double wells, f = sum 0.5 (x_{i+1} - x_i)^2 + x_i^4 / 4 - x_i^2 / 2.
+// the Hessian is tridiagonal and indefinite around 0, so early steps need
+// the shifted factorization.
+#include "unconstrained/newton/SparseNewton.hpp"
+
+using namespace optim;
+
+struct DoubleWellChain : SpHessProblem<double>
+{
+    double loss(const Mat<double> &x) override
+    {
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        for (Index i = 0; i < n; i++)
+        {
+            const double xi2 = x(i) * x(i);
+            f += 0.25 * xi2 * xi2 - 0.5 * xi2 + 0.1 * x(i);
+            if (i + 1 < n)
+                f += 0.5 * (x(i + 1) - x(i)) * (x(i + 1) - x(i));
+        }
+        return f;
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        const Index n = BMO_SIZE(x);
+        for (Index i = 0; i < n; i++)
+        {
+            g(i) = x(i) * x(i) * x(i) - x(i) + 0.1;
+            if (i > 0)
+                g(i) += x(i) - x(i - 1);
+            if (i + 1 < n)
+                g(i) -= x(i + 1) - x(i);
+        }
+    }
+
+    void hess(const Mat<double> &x, SpMat<double> &H) override
+    {
+        const Index n = BMO_SIZE(x);
+        if (H.rows() != n)
+        { // the pattern is built once
+            std::vector<Eigen::Triplet<double>> entries;
+            for (Index i = 0; i < n; i++)
+            {
+                entries.emplace_back(i, i, 0.);
+                if (i + 1 < n)
+                    entries.emplace_back(i + 1, i, 0.);
+            }
+            H.resize(n, n);
+            H.setFromTriplets(entries.begin(), entries.end());
+        }
+        for (Index i = 0; i < n; i++)
+        {
+            H.coeffRef(i, i) = 3 * x(i) * x(i) - 1 + (i > 0) + (i + 1 < n);
+            if (i + 1 < n)
+                H.coeffRef(i + 1, i) = -1;
+        }
+    }
+};
+
+int main(int argc, char const *argv[])
+{
+    const Index n = 100000;
+    auto prob = std::make_shared<DoubleWellChain>();
+    SparseNewton<double> solver(prob);
+    Mat<double> x = 0.3 * BMO_INIT_RAND(Mat<double>, n, 1), g(n, 1);
+    const double f = solver.solve(x);
+    prob->grad(x, g);
+    std::cout << "loss: " << f << " |g|: " << BMO_FRO_NORM(g)
+              << " iterations: " << solver.n_iter() << std::endl;
+    return solver.status != 0;
+}
@@ -0,0 +1,102 @@
+// f = 1/2 sum_i (x_i^4 - 16 x_i^2 + 5 x_i) + mu/2 sum_i (x_{i+1} - x_i)^2
+// from starts in [-1, 1]^n, where the Hessian is indefinite. Compares the
+// loss and gradient evaluations of the trust-region Newton method with the
+// line-search NewtonCG.
+#include "unconstrained/newton/TrustRegionNewton.hpp"
+#include "unconstrained/newton/NewtonCG.hpp"
+#include <cstdio>
+#include <random>
+
+using namespace optim;
+
+struct CoupledStyblinskiTang : HessProblem<double>
+{
+    double mu = 1;
+    Mat<double> xh;
+    long n_eval = 0;
+
+    double loss_and_grad(const Mat<double> &x, Mat<double> &g) override
+    {
+        n_eval++;
+        const Index n = BMO_SIZE(x);
+        double f = 0;
+        for (Index i = 0; i < n; i++)
+        {
+            const double t = x(i);
+            f += 0.5 * (t * t * t * t - 16 * t * t + 5 * t);
+            g(i) = 2 * t * t * t - 16 * t + 2.5;
+            if (i + 1 < n)
+                f += 0.5 * mu * (x(i + 1) - t) * (x(i + 1) - t);
+            if (i > 0)
+                g(i) += mu * (t - x(i - 1));
+            if (i + 1 < n)
+                g(i) -= mu * (x(i + 1) - t);
+        }
+        return f;
+    }
+
+    double loss(const Mat<double> &x) override
+    {
+        Mat<double> g(BMO_ROWS(x), 1);
+        return loss_and_grad(x, g);
+    }
+
+    void grad(const Mat<double> &x, Mat<double> &g) override { loss_and_grad(x, g); }
+
+    void update_hess(const Mat<double> &x) override { xh = x; }
+
+    void hess_forward(const Mat<double> &v, Mat<double> &d) override
+    {
+        const Index n = BMO_SIZE(v);
+        for (Index i = 0; i < n; i++)
+        {
+            d(i) = (6 * xh(i) * xh(i) - 16) * v(i);
+            if (i > 0)
+                d(i) += mu * (v(i) - v(i - 1));
+            if (i + 1 < n)
+                d(i) -= mu * (v(i + 1) - v(i));
+        }
+    }
+};
+
+int main(int argc, char const *argv[])
+{
+    const Index n = 50;
+    const int n_starts = 20;
+    logger.set_verbosity("error");
+    auto prob = std::make_shared<CoupledStyblinskiTang>();
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> unif(-1, 1);
+    std::vector<Mat<double>> starts(n_starts, Mat<double>(n, 1));
+    for (auto &x : starts)
+        for (Index i = 0; i < n; i++)
+            x(i) = unif(gen);
+
+    TrustRegionNewton<double> tr(prob);
+    NewtonCG<double> ncg(prob);
+    ncg.max_iter = tr.max_iter = 500;
+    ncg.gtol = tr.gtol = 1e-6;
+    long evals[2] = {0, 0}, hess_vec[2] = {0, 0};
+    double loss[2] = {0, 0};
+    int n_conv[2] = {0, 0};
+    Mat<double> g(n, 1);
+    for (const auto &x0 : starts)
+    {
+        BaseSolver<double> *solvers[2] = {&tr, &ncg};
+        for (int s = 0; s < 2; s++)
+        {
+            Mat<double> x = x0;
+            prob->n_eval = 0;
+            const double f = solvers[s]->solve(x);
+            evals[s] += prob->n_eval;
+            hess_vec[s] += s == 0 ? tr.n_hess_vec : ncg.n_hess_vec;
+            loss[s] += f / n_starts;
+            prob->loss_and_grad(x, g);
+            n_conv[s] += BMO_FRO_NORM(g) < 1e-6;
+        }
+    }
+    std::printf("%-10s %8s %10s %10s %12s\n", "solver", "conv", "evals", "hess_vec", "mean_loss");
+    std::printf("%-10s %5d/%-2d %10ld %10ld %12.4f\n", "TRNewton", n_conv[0], n_starts, evals[0], hess_vec[0], loss[0]);
+    std::printf("%-10s %5d/%-2d %10ld %10ld %12.4f\n", "NewtonCG", n_conv[1], n_starts, evals[1], hess_vec[1], loss[1]);
+    return n_conv[0] != n_starts || evals[0] >= evals[1];
+}